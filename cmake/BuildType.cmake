@@ -136,6 +136,8 @@ else(MSVC)
 	
 	if(USE_LTO)
 		add_cxxflag("-flto")
+		# Keep machine code in the installed library so that users don't need LTO
+		add_cxxflag("-ffat-lto-objects")
 		# TODO set CMAKE_INTERPROCEDURAL_OPTIMIZATION instead
 		add_ldflag("-fuse-linker-plugin")
 	endif()
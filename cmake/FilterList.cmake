@@ -125,6 +125,11 @@ function(filter_list LIST_NAME)
 		
 	endforeach()
 	
+	# Handle a trailing unconditional item
+	if(NOT last_item STREQUAL "" AND mode EQUAL 0)
+		list(APPEND filtered ${last_item})
+	endif()
+	
 	if(mode EQUAL 1)
 		message(FATAL_ERROR "bad filter_list syntax: unexpected end, expected condition")
 	elseif(mode EQUAL 2 OR mode EQUAL 3)
@@ -0,0 +1,63 @@
+
+# Copyright (C) 2026 agent
+#
+# This software is provided 'as-is', without any express or implied
+# warranty.  In no event will the author(s) be held liable for any damages
+# arising from the use of this software.
+#
+# Permission is granted to anyone to use this software for any purpose,
+# including commercial applications, and to alter it and redistribute it
+# freely, subject to the following restrictions:
+#
+# 1. The origin of this software must not be misrepresented; you must not
+#    claim that you wrote the original software. If you use this software
+#    in a product, an acknowledgment in the product documentation would be
+#    appreciated but is not required.
+# 2. Altered source versions must be plainly marked as such, and must not be
+#    misrepresented as being the original software.
+
+# Try to find libfuse 3 and the include path for fuse.h.
+# Once done this will define
+#
+# FUSE3_FOUND
+# FUSE3_INCLUDE_DIR   Where to find fuse.h
+# FUSE3_LIBRARIES     The libfuse3 library
+# FUSE3_DEFINITIONS   Definitions to use when compiling code that uses libfuse3
+#
+# Typical usage could be something like:
+#   find_package(FUSE3 REQUIRED)
+#   include_directories(SYSTEM ${FUSE3_INCLUDE_DIR})
+#   add_definitions(${FUSE3_DEFINITIONS})
+#   ...
+#   target_link_libraries(myexe ${FUSE3_LIBRARIES})
+
+if(UNIX)
+	find_package(PkgConfig QUIET)
+	pkg_check_modules(_PC_FUSE3 fuse3)
+endif()
+
+find_path(FUSE3_INCLUDE_DIR fuse.h
+	HINTS
+		${_PC_FUSE3_INCLUDE_DIRS}
+	PATH_SUFFIXES fuse3
+	DOC "The directory where fuse.h resides"
+)
+mark_as_advanced(FUSE3_INCLUDE_DIR)
+
+find_library(FUSE3_LIBRARY fuse3
+	HINTS
+		${_PC_FUSE3_LIBRARY_DIRS}
+	DOC "The libfuse3 library"
+)
+mark_as_advanced(FUSE3_LIBRARY)
+
+set(FUSE3_DEFINITIONS ${_PC_FUSE3_CFLAGS_OTHER})
+
+# handle the QUIETLY and REQUIRED arguments and set FUSE3_FOUND to TRUE if
+# all listed variables are TRUE
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(FUSE3 DEFAULT_MSG FUSE3_LIBRARY FUSE3_INCLUDE_DIR)
+
+if(FUSE3_FOUND)
+	set(FUSE3_LIBRARIES ${FUSE3_LIBRARY})
+endif(FUSE3_FOUND)
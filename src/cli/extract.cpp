@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -37,6 +38,8 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/ptr_container/ptr_map.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
 
 #include <boost/version.hpp>
 #if BOOST_VERSION >= 104800
@@ -51,6 +54,8 @@
 #include "crypto/checksum.hpp"
 #include "crypto/hasher.hpp"
 
+#include "lib/installer.hpp"
+
 #include "loader/offsets.hpp"
 
 #include "setup/data.hpp"
@@ -72,7 +77,15 @@
 #include "util/load.hpp"
 #include "util/log.hpp"
 #include "util/output.hpp"
+#include "util/outputbatch.hpp"
+#include "util/outputfile.hpp"
+#include "util/outputtree.hpp"
+#include "util/stats.hpp"
+#include "util/store.hpp"
+#include "util/tar.hpp"
+#include "util/tempdir.hpp"
 #include "util/time.hpp"
+#include "util/trace.hpp"
 
 namespace fs = boost::filesystem;
 
@@ -124,11 +137,87 @@ public:
 	
 };
 
+/*!
+ * Archive that extracted files are streamed into instead of writing them to disk.
+ */
+class archive_output : private boost::noncopyable {
+	
+	util::ofstream file_;
+	util::tar_writer writer_;
+	
+	boost::scoped_ptr<util::temporary_directory> spool_dir_;
+	boost::scoped_ptr<util::output_tree> spool_;
+	size_t spooled_;
+	
+public:
+	
+	explicit archive_output(const extract_options & o)
+		: writer_(o.output_file == "-" ? std::cout : static_cast<std::ostream &>(file_))
+		, spooled_(0)
+	{
+		if(o.output_file == "-") {
+			#if defined(_WIN32)
+			_setmode(_fileno(stdout), _O_BINARY);
+			#endif
+			return;
+		}
+		try {
+			file_.open(o.output_file, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			if(!file_.is_open()) {
+				throw std::exception();
+			}
+		} catch(...) {
+			throw std::runtime_error("Could not open output file \"" + o.output_file.string() + '"');
+		}
+	}
+	
+	util::tar_writer & writer() { return writer_; }
+	
+	//! Temporary files for entries that cannot be streamed directly
+	util::output_tree & spool() {
+		if(!spool_) {
+			spool_dir_.reset(new util::temporary_directory(fs::temp_directory_path()));
+			spool_.reset(new util::output_tree(spool_dir_->get()));
+		}
+		return *spool_;
+	}
+	
+	std::string spool_name() {
+		std::ostringstream oss;
+		oss << "spool-" << spooled_++;
+		return oss.str();
+	}
+	
+	void finish() {
+		writer_.finish();
+		if(!writer_.good()) {
+			throw std::runtime_error("Error writing archive");
+		}
+	}
+	
+};
+
 class file_output : private boost::noncopyable {
 	
+public:
+	
+	enum mode {
+		WriteFile,     //!< Write to the output directory
+		StreamEntry,   //!< Write directly into the archive
+		SpoolEntry,    //!< Write to a temporary file and copy it into the archive when complete
+		LinkEntry      //!< Add a hard link to an archive entry written by another output
+	};
+	
+private:
+	
 	fs::path path_;
 	const processed_file * file_;
-	util::fstream stream_;
+	util::output_file stream_;
+	
+	util::output_tree * target_;
+	const extract_options * options_;
+	bool batched_; //!< Is the file kept in memory to be written by \ref util::output_batch?
+	std::vector<char> data_;
 	
 	crypto::hasher checksum_;
 	boost::uint64_t checksum_position_;
@@ -138,40 +227,215 @@ class file_output : private boost::noncopyable {
 	
 	bool write_;
 	
+	mode mode_;
+	archive_output * archive_;
+	std::string source_; //!< Spool file or link target
+	boost::uint64_t size_; //!< Size of the archive entry
+	util::time mtime_;
+	
+	void abort_entry() {
+		if(write_ && mode_ == StreamEntry && archive_->writer().in_entry()) {
+			// Keep the archive consistent if extraction is aborted
+			archive_->writer().end_file();
+		}
+	}
+	
+	//! Open the file to write data that was to be written in one go.
+	bool unbatch() {
+		batched_ = false;
+		stream_.open(target_->open_file(file_->path(), false), file_->entry().size,
+		             options_->output_buffer_size, options_->output_cache);
+		return data_.empty() || stream_.write(&data_.front(), data_.size());
+	}
+	
+	bool finish_entry() {
+		
+		switch(mode_) {
+			case WriteFile: {
+				if(batched_) {
+					batched_ = false;
+					target_->write_file(file_->path(), data_, false, 0, 0);
+					return true;
+				}
+				return stream_.close();
+			}
+			case StreamEntry: {
+				if(!archive_->writer().end_file()) {
+					log_warning << "Padded incomplete archive entry for " << file_->path();
+				}
+				return archive_->writer().good();
+			}
+			case SpoolEntry: {
+				util::stats::timer timer(util::stats::OutputWrite);
+				archive_->writer().begin_file(file_->path(), size_, mtime_);
+				for(boost::uint64_t position = 0; ; ) {
+					char buffer[8192 * 10];
+					size_t n = stream_.read(position, buffer, sizeof(buffer));
+					if(n == 0) {
+						break;
+					}
+					archive_->writer().write(buffer, n);
+					timer.add(n);
+					position += n;
+				}
+				if(!archive_->writer().end_file()) {
+					log_warning << "Padded incomplete archive entry for " << file_->path();
+				}
+				bool success = stream_.close();
+				try {
+					fs::remove(archive_->spool().full_path(source_));
+				} catch(...) {
+					// Removed together with the spool directory
+				}
+				return success && archive_->writer().good();
+			}
+			case LinkEntry: {
+				archive_->writer().add_link(file_->path(), source_, mtime_);
+				return archive_->writer().good();
+			}
+		}
+		
+		return false;
+	}
+	
 public:
 	
-	explicit file_output(const fs::path & dir, const processed_file * f, bool write)
-		: path_(dir / f->path())
-		, file_(f)
-		, checksum_(f->entry().checksum.type)
-		, checksum_position_(f->entry().checksum.type == crypto::None ? boost::uint64_t(-1) : 0)
+	//! Create a closed output to be opened later using \ref open().
+	file_output()
+		: file_(NULL)
+		, target_(NULL)
+		, options_(NULL)
+		, batched_(false)
+		, checksum_(crypto::None)
+		, checksum_position_(0)
 		, position_(0)
 		, total_written_(0)
-		, write_(write)
+		, write_(false)
+		, mode_(WriteFile)
+		, archive_(NULL)
+		, size_(0)
+		, mtime_(0)
+	{ }
+	
+	//! Create an output and \ref open() it.
+	explicit file_output(util::output_tree & target, const processed_file * f, const extract_options & o,
+	                     archive_output * archive = NULL, mode m = WriteFile,
+	                     boost::uint64_t size = 0, util::time mtime = 0,
+	                     const std::string & link = std::string())
+		: batched_(false)
+		, checksum_(crypto::None)
+		, write_(false)
 	{
-		if(write_) {
-			try {
-				std::ios_base::openmode flags = std::ios_base::out | std::ios_base::binary | std::ios_base::trunc;
-				if(file_->is_multipart()) {
-					flags |= std::ios_base::in;
+		open(target, f, o, archive, m, size, mtime, link);
+	}
+	
+	~file_output() {
+		abort_entry();
+	}
+	
+	/*!
+	 * Start writing a file.
+	 *
+	 * The output can be re-used for another file after it has been closed. Existing buffers
+	 * are kept so that opening the next file does not need to allocate memory.
+	 *
+	 * \param target  Output directory tree
+	 * \param f       File to write
+	 * \param o       Extraction options
+	 * \param archive Archive to add the file to, or NULL to write it to the output directory
+	 * \param m       How to write the file
+	 * \param size    Total size of the file, including all parts
+	 * \param mtime   Modification time for archive entries
+	 * \param link    Path of the archive entry to link to for \ref LinkEntry outputs
+	 */
+	void open(util::output_tree & target, const processed_file * f, const extract_options & o,
+	          archive_output * archive = NULL, mode m = WriteFile,
+	          boost::uint64_t size = 0, util::time mtime = 0,
+	          const std::string & link = std::string()) {
+		
+		abort_entry();
+		
+		// Assign in place to re-use the string storage
+		path_ = target.root();
+		path_ /= f->path();
+		file_ = f;
+		target_ = &target;
+		options_ = &o;
+		batched_ = false;
+		checksum_ = crypto::hasher(f->entry().checksum.type);
+		checksum_position_ = (f->entry().checksum.type == crypto::None ? boost::uint64_t(-1) : 0);
+		position_ = 0;
+		total_written_ = 0;
+		write_ = o.extract;
+		mode_ = m;
+		archive_ = archive;
+		source_ = link;
+		size_ = size;
+		mtime_ = mtime;
+		
+		if(!write_) {
+			return;
+		}
+		switch(mode_) {
+			case WriteFile: {
+				if(target.is_batched() && !file_->is_multipart() && o.output_cache == util::KeepCache
+				   && f->entry().size <= util::output_batch::max_file_size) {
+					// Small files are kept in memory and then written in one go
+					batched_ = true;
+					data_.clear();
+					break;
 				}
-				stream_.open(path_, flags);
-				if(!stream_.is_open()) {
-					throw std::exception();
+				// Large files are decoded directly into a mapping of the output file
+				bool map = (o.output_cache == util::KeepCache
+				            && f->entry().size >= util::output_file::min_map_size);
+				stream_.open(target.open_file(f->path(), file_->is_multipart() || map), f->entry().size,
+				             o.output_buffer_size, o.output_cache);
+				if(map) {
+					stream_.map(f->entry().size);
 				}
-			} catch(...) {
-				throw std::runtime_error("Could not open output file \"" + path_.string() + '"');
+				break;
+			}
+			case StreamEntry: {
+				archive_->writer().begin_file(f->path(), size_, mtime_);
+				break;
+			}
+			case SpoolEntry: {
+				source_ = archive_->spool_name();
+				stream_.open(archive_->spool().open_file(source_, true), size_,
+				             o.output_buffer_size, util::KeepCache);
+				break;
 			}
+			case LinkEntry: break;
 		}
 	}
 	
 	bool write(const char * data, size_t n) {
 		
+		bool success = true;
 		if(write_) {
-			stream_.write(data, std::streamsize(n));
+			util::stats::timer timer(util::stats::OutputWrite);
+			timer.add(n);
+			if(batched_ && data_.size() + n > util::output_batch::max_file_size) {
+				success = unbatch();
+			}
+			switch(mode_) {
+				case WriteFile: {
+					if(batched_) {
+						data_.insert(data_.end(), data, data + n);
+					} else {
+						success = stream_.write(data, n) && success;
+					}
+					break;
+				}
+				case SpoolEntry: success = stream_.write(data, n); break;
+				case StreamEntry: success = archive_->writer().write(data, n); break;
+				case LinkEntry: break;
+			}
 		}
 		
 		if(checksum_position_ == position_) {
+			util::stats::timer timer(util::stats::Hash);
+			timer.add(n);
 			checksum_.update(data, n);
 			checksum_position_ += n;
 		}
@@ -179,7 +443,18 @@ public:
 		position_ += n;
 		total_written_ += n;
 		
-		return !write_ || !stream_.fail();
+		return success;
+	}
+	
+	/*!
+	 * Get memory to decode the data at the current position into.
+	 *
+	 * \param n Maximum number of bytes needed, set to the number of bytes available.
+	 *
+	 * \return a pointer to pass to \ref write() or NULL if the output is not mapped.
+	 */
+	char * mapped(size_t & n) {
+		return (write_ && mode_ == WriteFile) ? stream_.mapped(n) : NULL;
 	}
 	
 	void seek(boost::uint64_t new_position) {
@@ -190,39 +465,56 @@ public:
 		
 		debug("seeking output from " << print_hex(position_) << " to " << print_hex(new_position));
 		
-		if(!write_) {
-			position_ = new_position;
-			return;
-		}
-		
-		const boost::uint64_t max = boost::uint64_t(std::numeric_limits<util::fstream::off_type>::max() / 4);
-		
-		if(new_position <= max) {
-			stream_.seekp(util::fstream::off_type(new_position), std::ios_base::beg);
-		} else {
-			util::fstream::off_type sign = (new_position > position_) ? 1 : -1;
-			boost::uint64_t diff = (new_position > position_) ? new_position - position_ : position_ - new_position;
-			while(diff > 0) {
-				stream_.seekp(sign * util::fstream::off_type(std::min(diff, max)), std::ios_base::cur);
-				diff -= std::min(diff, max);
+		if(write_ && (mode_ == WriteFile || mode_ == SpoolEntry)) {
+			util::stats::count(util::stats::Seeks);
+			if(batched_) {
+				unbatch();
 			}
+			stream_.seek(new_position);
 		}
 		
 		position_ = new_position;
 		
 	}
 	
-	void close() {
+	bool close() {
+		
+		if(write_) {
+			write_ = false;
+			return finish_entry();
+		}
+		
+		return true;
+	}
+	
+	//! Close the file and set its timestamp using the still open handle.
+	bool close(util::time sec, boost::uint32_t nsec, bool & time_set) {
+		
+		time_set = true;
 		
 		if(write_) {
-			stream_.close();
+			write_ = false;
+			if(mode_ == WriteFile && batched_) {
+				// The time is set once the file has been written
+				batched_ = false;
+				target_->write_file(file_->path(), data_, true, sec, nsec);
+				return true;
+			} else if(mode_ == WriteFile) {
+				return stream_.close(path_, sec, nsec, time_set);
+			}
+			return finish_entry();
 		}
 		
+		return true;
 	}
 	
 	const fs::path & path() const { return path_; }
 	const processed_file * file() const { return file_; }
 	
+	static bool archive_order(const file_output * a, const file_output * b) {
+		return a->mode_ < b->mode_;
+	}
+	
 	bool is_complete() const {
 		return total_written_ == file_->entry().size;
 	}
@@ -237,26 +529,28 @@ public:
 			return true;
 		}
 		
-		if(!write_) {
+		if(!write_ || (mode_ != WriteFile && mode_ != SpoolEntry)) {
 			return false;
 		}
 		
 		debug("calculating output checksum for " << path_);
 		
-		const boost::uint64_t max = boost::uint64_t(std::numeric_limits<util::fstream::off_type>::max() / 4);
-		
-		boost::uint64_t diff = checksum_position_;
-		stream_.seekg(util::fstream::off_type(std::min(diff, max)), std::ios_base::beg);
-		diff -= std::min(diff, max);
-		while(diff > 0) {
-			stream_.seekg(util::fstream::off_type(std::min(diff, max)), std::ios_base::cur);
-			diff -= std::min(diff, max);
+		if(batched_ && !unbatch()) {
+			return false;
 		}
 		
-		while(!stream_.eof()) {
+		util::stats::timer timer(util::stats::Reread);
+		
+		for(;;) {
 			char buffer[8192];
-			std::streamsize n = stream_.read(buffer, sizeof(buffer)).gcount();
-			checksum_.update(buffer, size_t(n));
+			size_t n = stream_.read(checksum_position_, buffer, sizeof(buffer));
+			if(n == 0) {
+				break;
+			}
+			timer.add(n);
+			util::stats::timer hash_timer(util::stats::Hash);
+			hash_timer.add(n);
+			checksum_.update(buffer, n);
 			checksum_position_ += boost::uint64_t(n);
 		}
 		
@@ -274,6 +568,17 @@ public:
 	
 };
 
+//! How a file is added to the archive
+struct archive_entry {
+	
+	file_output::mode mode;
+	boost::uint64_t size; //!< Total size of all parts
+	std::string link; //!< Target for \ref file_output::LinkEntry
+	
+	archive_entry() : mode(file_output::StreamEntry), size(0) { }
+	
+};
+
 class path_filter {
 	
 	typedef std::pair<bool, std::string> Filter;
@@ -514,63 +819,132 @@ bool insert_dirs(DirectoriesMap & processed_directories, const path_filter & inc
 	return false;
 }
 
-bool rename_collision(const extract_options & o, FilesMap & processed_files, const std::string & path,
-                      const processed_file & other, bool common_component, bool common_language,
-                      bool common_arch, bool first) {
+struct collision_stats {
 	
-	const setup::file_entry & file = other.entry();
+	size_t paths; //!< Number of paths with more than one file
+	size_t files; //!< Number of files involved in collisions
+	size_t renamed; //!< Number of files that were assigned a new name
+	size_t numbered; //!< Number of files that needed a numbered suffix
 	
-	bool require_number_suffix = !first || (o.collisions == RenameAllCollisions);
-	std::ostringstream oss;
-	const setup::file_entry::flags arch_flags = setup::file_entry::Bits32 | setup::file_entry::Bits64;
+	collision_stats() : paths(0), files(0), renamed(0), numbered(0) { }
 	
-	if(!common_component && !file.components.empty()) {
-		if(setup::is_simple_expression(file.components)) {
-			require_number_suffix = false;
-			oss << '#' << file.components;
-		}
-	}
-	if(!common_language && !file.languages.empty()) {
-		if(setup::is_simple_expression(file.languages)) {
-			require_number_suffix = false;
-			if(file.languages != o.default_language) {
-				oss << '@' << file.languages;
-			}
-		}
-	}
-	if(!common_arch && (file.options & arch_flags) == setup::file_entry::Bits32) {
-		require_number_suffix = false;
-		oss << "@32bit";
-	} else if(!common_arch && (file.options & arch_flags) == setup::file_entry::Bits64) {
-		require_number_suffix = false;
-		oss << "@64bit";
-	}
+};
+
+/*!
+ * Assigns unique names to colliding files.
+ *
+ * Remembers the next number to try for each base name so that many files with the same
+ * suffix don't have to re-probe all previously allocated names.
+ */
+class collision_resolver {
 	
-	size_t i = 0;
-	std::string suffix = oss.str();
-	if(require_number_suffix) {
-		oss << '$' << i++;
+	const extract_options & o;
+	FilesMap & processed_files;
+	collision_stats & stats;
+	
+	typedef std::unordered_map<std::string, size_t> CounterMap;
+	CounterMap next_number;
+	
+	std::string name;
+	std::string suffix;
+	
+	void append_number(std::string & str, size_t number) {
+		char buffer[24];
+		char * end = buffer + sizeof(buffer);
+		char * begin = end;
+		do {
+			*--begin = char('0' + number % 10);
+			number /= 10;
+		} while(number != 0);
+		str.push_back('$');
+		str.append(begin, end);
 	}
-	for(;;) {
+	
+	bool try_name(const std::string & path, const processed_file & other, bool & done) {
 		std::pair<FilesMap::iterator, bool> insertion = processed_files.insert(std::make_pair(
-			path + oss.str(), processed_file(&file, other.path() + oss.str())
+			path + name, processed_file(&other.entry(), other.path() + name)
 		));
 		if(insertion.second) {
 			// Found an available name and inserted
+			stats.renamed++;
+			done = true;
 			return true;
 		}
-		if(&insertion.first->second.entry() == &file) {
+		if(&insertion.first->second.entry() == &other.entry()) {
 			// File already has the desired name, abort
+			done = true;
 			return false;
 		}
-		oss.str(suffix);
-		oss << '$' << i++;
+		done = false;
+		return false;
 	}
 	
-}
+public:
+	
+	collision_resolver(const extract_options & options, FilesMap & files, collision_stats & statistics)
+		: o(options), processed_files(files), stats(statistics) { }
+	
+	bool rename(const std::string & path, const processed_file & other,
+	            bool common_component, bool common_language, bool common_arch, bool first) {
+		
+		const setup::file_entry & file = other.entry();
+		
+		bool require_number_suffix = !first || (o.collisions == RenameAllCollisions);
+		const setup::file_entry::flags arch_flags = setup::file_entry::Bits32 | setup::file_entry::Bits64;
+		
+		suffix.clear();
+		if(!common_component && !file.components.empty()) {
+			if(setup::is_simple_expression(file.components)) {
+				require_number_suffix = false;
+				suffix.push_back('#');
+				suffix.append(file.components);
+			}
+		}
+		if(!common_language && !file.languages.empty()) {
+			if(setup::is_simple_expression(file.languages)) {
+				require_number_suffix = false;
+				if(file.languages != o.default_language) {
+					suffix.push_back('@');
+					suffix.append(file.languages);
+				}
+			}
+		}
+		if(!common_arch && (file.options & arch_flags) == setup::file_entry::Bits32) {
+			require_number_suffix = false;
+			suffix.append("@32bit");
+		} else if(!common_arch && (file.options & arch_flags) == setup::file_entry::Bits64) {
+			require_number_suffix = false;
+			suffix.append("@64bit");
+		}
+		
+		bool done;
+		if(!require_number_suffix) {
+			name = suffix;
+			bool inserted = try_name(path, other, done);
+			if(done) {
+				return inserted;
+			}
+		}
+		
+		stats.numbered++;
+		size_t & i = next_number[path + suffix];
+		for(;;) {
+			name = suffix;
+			append_number(name, i++);
+			bool inserted = try_name(path, other, done);
+			if(done) {
+				return inserted;
+			}
+		}
+		
+	}
+	
+};
 
 void rename_collisions(const extract_options & o, FilesMap & processed_files,
-                       const CollisionMap & collisions) {
+                       const CollisionMap & collisions, collision_stats & stats) {
+	
+	collision_resolver resolver(o, processed_files, stats);
 	
 	for(const CollisionMap::value_type & collision : collisions) {
 		
@@ -589,18 +963,27 @@ void rename_collisions(const extract_options & o, FilesMap & processed_files,
 			common_arch = common_arch && (other.entry().options & arch_flags) == (file.options & arch_flags);
 		}
 		
+		stats.paths++;
+		stats.files += collision.second.size() + 1;
+		
 		bool ignore_component = common_component || o.collisions != RenameAllCollisions;
-		if(rename_collision(o, processed_files, path, base,
-		                    ignore_component, common_language, common_arch, true)) {
+		if(resolver.rename(path, base, ignore_component, common_language, common_arch, true)) {
 			processed_files.erase(path);
 		}
 		
 		for(const processed_file & other : collision.second) {
-			rename_collision(o, processed_files, path, other,
-			                 common_component, common_language, common_arch, false);
+			resolver.rename(path, other, common_component, common_language, common_arch, false);
 		}
 		
 	}
+	
+	util::stats::count(util::stats::CollisionPaths, stats.paths);
+	util::stats::count(util::stats::CollisionFiles, stats.files);
+	util::stats::count(util::stats::Renamed, stats.renamed);
+	util::stats::count(util::stats::Numbered, stats.numbered);
+	
+	debug("renamed " << stats.renamed << " of " << stats.files << " files colliding at "
+	      << stats.paths << " paths, " << stats.numbered << " needed a number");
 }
 
 bool print_file_info(const extract_options & o, const setup::info & info) {
@@ -735,9 +1118,19 @@ struct processed_entries {
 	
 	DirectoriesMap directories;
 	
+	collision_stats collisions;
+	
 };
 
-processed_entries filter_entries(const extract_options & o, const setup::info & info) {
+/*!
+ * Select the files and directories to process and resolve collisions between them.
+ *
+ * \param list_collisions Print overwritten and skipped files when listing.
+ */
+processed_entries filter_entries(const extract_options & o, const setup::info & info,
+                                 bool list_collisions = true) {
+	
+	util::trace::span span("entries", "filter_entries");
 	
 	processed_entries processed;
 	
@@ -754,6 +1147,8 @@ processed_entries filter_entries(const extract_options & o, const setup::info &
 	
 	path_filter includes(o);
 	
+	setup::expression_cache expressions;
+	
 	// Filter the directories to be created
 	for(const setup::directory_entry & directory : info.directories) {
 		
@@ -762,7 +1157,7 @@ processed_entries filter_entries(const extract_options & o, const setup::info &
 		}
 		
 		if(!directory.languages.empty()) {
-			if(!o.language.empty() && !setup::expression_match(o.language, directory.languages)) {
+			if(!o.language.empty() && !expressions.match(o.language, directory.languages)) {
 				continue; // Ignore other languages
 			}
 		} else if(o.language_only) {
@@ -770,16 +1165,16 @@ processed_entries filter_entries(const extract_options & o, const setup::info &
 		}
 
 		if(!directory.components.empty()) {
-			if(!o.component.empty() && !setup::expression_match(o.component, directory.components)) {
+			if(!o.component.empty() && !expressions.match(o.component, directory.components)) {
 				continue;
 			}
 		}
 
-		std::string path = o.filenames.convert(directory.name);
+		std::string internal_path;
+		std::string path = o.filenames.convert(directory.name, internal_path);
 		if(path.empty()) {
 			continue; // Don't know what to do with this
 		}
-		std::string internal_path = boost::algorithm::to_lower_copy(path);
 		
 		bool path_included = includes.match(internal_path);
 		
@@ -813,7 +1208,7 @@ processed_entries filter_entries(const extract_options & o, const setup::info &
 		}
 		
 		if(!file.languages.empty()) {
-			if(!o.language.empty() && !setup::expression_match(o.language, file.languages)) {
+			if(!o.language.empty() && !expressions.match(o.language, file.languages)) {
 				continue; // Ignore other languages
 			}
 		} else if(o.language_only) {
@@ -821,16 +1216,16 @@ processed_entries filter_entries(const extract_options & o, const setup::info &
 		}
 
 		if (!file.components.empty()) {
-			if (!o.component.empty() && !setup::expression_match(o.component, file.components)) {
+			if (!o.component.empty() && !expressions.match(o.component, file.components)) {
 				continue;
 			}
 		}
 
-		std::string path = o.filenames.convert(file.destination);
+		std::string internal_path;
+		std::string path = o.filenames.convert(file.destination, internal_path);
 		if(path.empty()) {
 			continue; // Internal file, not extracted
 		}
-		std::string internal_path = boost::algorithm::to_lower_copy(path);
 		
 		bool path_included = includes.match(internal_path);
 		
@@ -859,8 +1254,8 @@ processed_entries filter_entries(const extract_options & o, const setup::info &
 				const char * skip = handle_collision(existing.entry(), olddata, file, newdata);
 				
 				if(!o.default_language.empty()) {
-					bool oldlang = setup::expression_match(o.default_language, file.languages);
-					bool newlang = setup::expression_match(o.default_language, existing.entry().languages);
+					bool oldlang = expressions.match(o.default_language, file.languages);
+					bool newlang = expressions.match(o.default_language, existing.entry().languages);
 					if(oldlang && !newlang) {
 						skip = NULL;
 					} else if(!oldlang && newlang) {
@@ -872,7 +1267,7 @@ processed_entries filter_entries(const extract_options & o, const setup::info &
 					const setup::file_entry & clobberedfile = skip ? file : existing.entry();
 					const std::string & clobberedpath = skip ? path : existing.path();
 					collisions[internal_path].push_back(processed_file(&clobberedfile, clobberedpath));
-				} else if(!o.silent) {
+				} else if(list_collisions && !o.silent) {
 					std::cout << " - ";
 					const std::string & clobberedpath = skip ? path : existing.path();
 					std::cout << '"' << color::dim_yellow << clobberedpath << color::reset << '"';
@@ -903,103 +1298,731 @@ processed_entries filter_entries(const extract_options & o, const setup::info &
 	}
 	
 	if(o.collisions == RenameCollisions || o.collisions == RenameAllCollisions) {
-		rename_collisions(o, processed.files, collisions);
+		rename_collisions(o, processed.files, collisions, processed.collisions);
 	}
 	
 	return processed;
 }
 
-void create_single_directory(const boost::filesystem::path & o) {
+typedef std::map<stream::file, size_t> Files;
+typedef std::map<stream::chunk, Files> Chunks;
+
+//! A file to write data to and the offset of the data in that file
+typedef std::pair<const processed_file *, boost::uint64_t> output_location;
+typedef std::vector< std::vector<output_location> > OutputLocations;
+
+/*!
+ * Find the chunks that need to be read for a set of files.
+ *
+ * \param info               Setup info, the chunk sort order is adjusted so that parts of
+ *                           multi-part files are read in order where possible.
+ * \param files              The files to process.
+ * \param all_parts          Include all parts of multi-part files, not just the first.
+ * \param files_for_location The files and offsets to write for each data entry.
+ * \param chunks             The data entries to read from each chunk.
+ */
+void group_chunks(setup::info & info, const FilesMap & files, bool all_parts,
+                  OutputLocations & files_for_location, Chunks & chunks) {
 	
-	try {
-		if(!o.empty() && !fs::exists(o)) {
-			fs::create_directory(o);
+	files_for_location.resize(info.data_entries.size());
+	for(const FilesMap::value_type & i : files) {
+		const processed_file & file = i.second;
+		files_for_location[file.entry().location].push_back(output_location(&file, 0));
+		if(all_parts) {
+			boost::uint64_t offset = info.data_entries[file.entry().location].uncompressed_size;
+			boost::uint32_t sort_slice = info.data_entries[file.entry().location].chunk.first_slice;
+			boost::uint32_t sort_offset = info.data_entries[file.entry().location].chunk.sort_offset;
+			for(boost::uint32_t location : file.entry().additional_locations) {
+				setup::data_entry & data = info.data_entries[location];
+				files_for_location[location].push_back(output_location(&file, offset));
+				offset += data.uncompressed_size;
+				if(data.chunk.first_slice > sort_slice ||
+				   (data.chunk.first_slice == sort_slice && data.chunk.sort_offset > sort_offset)) {
+					sort_slice = data.chunk.first_slice;
+					sort_offset = data.chunk.sort_offset;
+				} else if(data.chunk.first_slice == sort_slice && data.chunk.sort_offset == data.chunk.offset) {
+					data.chunk.sort_offset = ++sort_offset;
+				} else {
+					// Could not reorder chunk - no point in trying to reordder the remaining chunks
+					sort_slice = boost::uint32_t(-1);
+				}
+			}
 		}
-	} catch(...) {
-		throw std::runtime_error("Could not create directory \"" + o.string() + '"');
 	}
 	
-}
-
-bool test_password(const std::string & password, const setup::info & info) {
-	
-	if(info.header.options & setup::header::Password) {
-		crypto::hasher checksum(info.header.password.type);
-		checksum.update(info.header.password_salt.c_str(), info.header.password_salt.length());
-		checksum.update(password.c_str(), password.length());
-		return (checksum.finalize() == info.header.password);
+	for(size_t i = 0; i < info.data_entries.size(); i++) {
+		if(!files_for_location[i].empty()) {
+			setup::data_entry & location = info.data_entries[i];
+			chunks[location.chunk][location.file] = i;
+		}
 	}
-	return false;
+	
 }
 
-} // anonymous namespace
-
-void process_file(const fs::path & installer, const extract_options & o) {
+/*!
+ * Only keep the chunks for one part of the setup data.
+ *
+ * Chunks that contain parts of the same multi-part file are kept together. The resulting
+ * groups are assigned largest first to the shard with the least compressed data so far,
+ * so every node with the same installer and shard count selects the same chunks.
+ */
+void select_shard(Chunks & chunks, const setup::info & info, const FilesMap & files,
+                  size_t shard, size_t shard_count) {
 	
-	bool is_directory;
-	try {
-		is_directory = fs::is_directory(installer);
-	} catch(...) {
-		throw std::runtime_error("Could not open file \"" + installer.string()
-		                         + "\": access denied");
+	std::vector<Chunks::iterator> order;
+	std::map<stream::chunk, size_t> index;
+	for(Chunks::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+		index[it->first] = order.size();
+		order.push_back(it);
 	}
-	if(is_directory) {
-		throw std::runtime_error("Input file \"" + installer.string() + "\" is a directory!");
+	
+	std::vector<size_t> group(order.size());
+	for(size_t i = 0; i < group.size(); i++) {
+		group[i] = i;
 	}
+	auto find = [&group](size_t i) {
+		while(group[i] != i) {
+			i = group[i] = group[group[i]];
+		}
+		return i;
+	};
 	
-	util::ifstream ifs;
-	try {
-		ifs.open(installer, std::ios_base::in | std::ios_base::binary);
-		if(!ifs.is_open()) {
-			throw std::exception();
+	for(const FilesMap::value_type & i : files) {
+		const setup::file_entry & entry = i.second.entry();
+		size_t first = find(index[info.data_entries[entry.location].chunk]);
+		for(boost::uint32_t location : entry.additional_locations) {
+			size_t other = find(index[info.data_entries[location].chunk]);
+			group[std::max(first, other)] = std::min(first, other);
+			first = std::min(first, other);
 		}
-	} catch(...) {
-		throw std::runtime_error("Could not open file \"" + installer.string() + '"');
 	}
 	
-	loader::offsets offsets;
-	offsets.load(ifs);
-	
-	#ifdef DEBUG
-	if(logger::debug) {
-		print_offsets(offsets);
-		std::cout << '\n';
+	std::vector<boost::uint64_t> group_size(order.size(), 0);
+	for(size_t i = 0; i < order.size(); i++) {
+		group_size[find(i)] += order[i]->first.size;
 	}
-	#endif
 	
-	if(o.data_version)  {
-		setup::version version;
-		ifs.seekg(offsets.header_offset);
-		version.load(ifs);
-		if(o.silent) {
-			std::cout << version << '\n';
-		} else {
-			std::cout << color::white << version << color::reset << '\n';
+	std::vector<size_t> groups;
+	for(size_t i = 0; i < order.size(); i++) {
+		if(find(i) == i) {
+			groups.push_back(i);
 		}
-		return;
 	}
+	std::stable_sort(groups.begin(), groups.end(), [&group_size](size_t a, size_t b) {
+		return group_size[a] > group_size[b];
+	});
 	
-	#ifdef DEBUG
-	if(o.dump_headers)  {
-		create_single_directory(o.output_dir);
-		dump_headers(ifs, offsets, o);
-		return;
+	std::vector<boost::uint64_t> load(shard_count, 0);
+	std::vector<size_t> assigned(order.size(), 0);
+	for(size_t i : groups) {
+		size_t target = size_t(std::min_element(load.begin(), load.end()) - load.begin());
+		load[target] += group_size[i];
+		assigned[i] = target;
 	}
-	#endif
 	
-	setup::info::entry_types entries = 0;
-	if(o.list || o.test || o.extract || (o.gog_galaxy && o.list_languages)) {
-		entries |= setup::info::Files;
-		entries |= setup::info::Directories;
-		entries |= setup::info::DataEntries;
-	}
-	if(o.list_languages) {
-		entries |= setup::info::Languages;
-	}
-	if(o.list_components) {
-		entries |= setup::info::Components;
+	for(size_t i = 0; i < order.size(); i++) {
+		if(assigned[find(i)] != shard) {
+			chunks.erase(order[i]);
+		}
 	}
-	if(o.gog_game_id || o.gog) {
+	
+}
+
+/*!
+ * Write the files and chunks that would be processed, without reading any file data.
+ *
+ * The plan can be edited or split and then passed to \ref load_plan.
+ */
+void write_plan(std::ostream & os, const fs::path & installer, const setup::info & info,
+                const processed_entries & processed, const Chunks & chunks,
+                const OutputLocations & files_for_location, stream::slice_reader * slice_reader,
+                const std::string & password) {
+	
+	util::trace::span span("entries", "write_plan");
+	
+	std::ostringstream version;
+	version << info.version;
+	
+	os << "{\n\"format\":\"innoextract-plan\",\"version\":1";
+	os << ",\n\"installer\":" << json_string(installer.string());
+	os << ",\n\"data_version\":" << json_string(version.str());
+	os << ",\n\"data_entries\":" << info.data_entries.size();
+	
+	os << ",\n\"directories\":[";
+	bool first = true;
+	for(const DirectoriesMap::value_type & i : processed.directories) {
+		os << (first ? "\n" : ",\n") << "{\"path\":" << json_string(i.second.path()) << ",\"entry\":";
+		if(i.second.has_entry()) {
+			os << size_t(&i.second.entry() - &info.directories.front());
+		} else {
+			os << "null";
+		}
+		os << ",\"implied\":" << (i.second.implied() ? "true" : "false") << '}';
+		first = false;
+	}
+	os << "]";
+	
+	boost::uint64_t compressed_size = 0, uncompressed_size = 0;
+	boost::uint32_t max_dictionary_size = 0;
+	
+	os << ",\n\"chunks\":[";
+	first = true;
+	for(const Chunks::value_type & chunk : chunks) {
+		
+		boost::uint64_t chunk_size = 0;
+		for(const Files::value_type & location : chunk.second) {
+			chunk_size += info.data_entries[location.second].uncompressed_size;
+		}
+		
+		std::ostringstream compression, encryption;
+		compression << chunk.first.compression;
+		encryption << chunk.first.encryption;
+		
+		os << (first ? "\n" : ",\n");
+		os << "{\"slice\":" << chunk.first.first_slice << ",\"last_slice\":" << chunk.first.last_slice;
+		os << ",\"offset\":" << chunk.first.offset << ",\"size\":" << chunk.first.size;
+		os << ",\"compression\":" << json_string(compression.str());
+		os << ",\"encryption\":" << json_string(encryption.str());
+		os << ",\"uncompressed_size\":" << chunk_size;
+		if(chunk.first.compression == stream::LZMA1 || chunk.first.compression == stream::LZMA2) {
+			boost::uint32_t dictionary_size = 0;
+			if(slice_reader) {
+				try {
+					dictionary_size = stream::chunk_reader::dictionary_size(*slice_reader, chunk.first,
+					                                                        password);
+				} catch(const std::exception & e) {
+					log_warning << "Could not read LZMA properties for chunk @ slice "
+					            << chunk.first.first_slice << " + " << print_hex(chunk.first.offset)
+					            << ": " << e.what();
+				}
+			}
+			os << ",\"dictionary_size\":";
+			if(dictionary_size != 0) {
+				os << dictionary_size;
+				max_dictionary_size = std::max(max_dictionary_size, dictionary_size);
+			} else {
+				os << "null";
+			}
+		}
+		first = false;
+		
+		os << ",\"files\":[";
+		bool first_file = true;
+		for(const Files::value_type & location : chunk.second) {
+			os << (first_file ? "\n " : ",\n ");
+			os << "{\"location\":" << location.second << ",\"offset\":" << location.first.offset;
+			os << ",\"size\":" << info.data_entries[location.second].uncompressed_size;
+			os << ",\"outputs\":[";
+			bool first_output = true;
+			for(const output_location & output : files_for_location[location.second]) {
+				os << (first_output ? "" : ",");
+				os << "{\"entry\":" << size_t(&output.first->entry() - &info.files.front());
+				os << ",\"path\":" << json_string(output.first->path());
+				os << ",\"part_offset\":" << output.second << '}';
+				first_output = false;
+			}
+			os << "]}";
+			first_file = false;
+		}
+		os << "]}";
+		
+		compressed_size += chunk.first.size;
+		uncompressed_size += chunk_size;
+	}
+	os << "]";
+	
+	os << ",\n\"totals\":{\"chunks\":" << chunks.size() << ",\"files\":" << processed.files.size();
+	os << ",\"compressed_size\":" << compressed_size << ",\"uncompressed_size\":" << uncompressed_size;
+	os << ",\"max_dictionary_size\":" << max_dictionary_size << "}\n}\n";
+}
+
+//! Write a plan to \ref extract_options::plan_file
+void save_plan(const extract_options & o, const fs::path & installer, util::ifstream & ifs,
+               const loader::offsets & offsets, const setup::info & info,
+               const processed_entries & processed, const Chunks & chunks,
+               const OutputLocations & files_for_location, const std::string & password) {
+	
+	boost::scoped_ptr<stream::slice_reader> slice_reader;
+	try {
+		slice_reader.reset(innoextract::open_slices(installer, &ifs, offsets, info));
+	} catch(const std::exception & e) {
+		log_warning << "Could not open setup data, LZMA dictionary sizes are unknown: " << e.what();
+	}
+	
+	if(o.plan_file == "-") {
+		write_plan(std::cout, installer, info, processed, chunks, files_for_location,
+		           slice_reader.get(), password);
+		return;
+	}
+	
+	util::ofstream ofs;
+	try {
+		ofs.open(o.plan_file, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if(!ofs.is_open()) {
+			throw std::exception();
+		}
+	} catch(...) {
+		throw std::runtime_error("Could not open plan file \"" + o.plan_file.string() + '"');
+	}
+	write_plan(ofs, installer, info, processed, chunks, files_for_location, slice_reader.get(), password);
+	if(!ofs.flush()) {
+		throw std::runtime_error("Could not write plan file \"" + o.plan_file.string() + '"');
+	}
+}
+
+bool is_plan_path(const std::string & path) {
+	
+	if(path.empty() || path[0] == setup::path_sep) {
+		return false;
+	}
+	
+	size_t start = 0;
+	for(;;) {
+		size_t end = path.find(setup::path_sep, start);
+		std::string component = path.substr(start, end == std::string::npos ? end : end - start);
+		if(component.empty() || component == "." || component == "..") {
+			return false;
+		}
+		if(end == std::string::npos) {
+			return true;
+		}
+		start = end + 1;
+	}
+}
+
+/*!
+ * Read the files and directories to process from a plan written by \ref write_plan.
+ *
+ * Only the listed entries and output paths are used, the chunks are grouped again from
+ * them. Every file in the plan is processed completely, even if only some of its parts
+ * are listed.
+ */
+processed_entries load_plan(const extract_options & o, const setup::info & info) {
+	
+	util::trace::span span("entries", "load_plan");
+	
+	namespace pt = boost::property_tree;
+	
+	pt::ptree plan;
+	try {
+		util::ifstream ifs;
+		ifs.open(o.from_plan, std::ios_base::in | std::ios_base::binary);
+		if(!ifs.is_open()) {
+			throw std::runtime_error("Could not open plan \"" + o.from_plan.string() + '"');
+		}
+		pt::read_json(ifs, plan);
+	} catch(const pt::json_parser_error & e) {
+		throw std::runtime_error("Could not parse plan \"" + o.from_plan.string() + "\": "
+		                         + e.what());
+	}
+	
+	std::ostringstream version;
+	version << info.version;
+	try {
+		if(plan.get<std::string>("format") != "innoextract-plan" || plan.get<int>("version") != 1) {
+			throw std::runtime_error("Unsupported plan format in \"" + o.from_plan.string() + '"');
+		}
+		if(plan.get<std::string>("data_version") != version.str()
+		   || plan.get<size_t>("data_entries") != info.data_entries.size()) {
+			throw std::runtime_error("Plan \"" + o.from_plan.string() + "\" is for a different installer");
+		}
+	} catch(const pt::ptree_error & e) {
+		throw std::runtime_error("Invalid plan \"" + o.from_plan.string() + "\": " + e.what());
+	}
+	
+	processed_entries processed;
+	
+	try {
+		
+		for(const pt::ptree::value_type & i : plan.get_child("directories")) {
+			std::string path = i.second.get<std::string>("path");
+			if(!is_plan_path(path)) {
+				throw std::runtime_error("Invalid path in plan: " + path);
+			}
+			std::pair<DirectoriesMap::iterator, bool> existing = processed.directories.insert(
+				std::make_pair(boost::algorithm::to_lower_copy(path), processed_directory(path))
+			);
+			boost::optional<size_t> entry = i.second.get_optional<size_t>("entry");
+			if(entry) {
+				if(*entry >= info.directories.size()) {
+					throw std::runtime_error("Invalid directory entry in plan: " + path);
+				}
+				existing.first->second.set_entry(&info.directories[*entry]);
+			}
+			existing.first->second.set_implied(i.second.get<bool>("implied", false));
+		}
+		
+		for(const pt::ptree::value_type & chunk : plan.get_child("chunks")) {
+			for(const pt::ptree::value_type & file : chunk.second.get_child("files")) {
+				for(const pt::ptree::value_type & output : file.second.get_child("outputs")) {
+					std::string path = output.second.get<std::string>("path");
+					size_t entry = output.second.get<size_t>("entry");
+					if(!is_plan_path(path)) {
+						throw std::runtime_error("Invalid path in plan: " + path);
+					}
+					if(entry >= info.files.size() || info.files[entry].location >= info.data_entries.size()) {
+						throw std::runtime_error("Invalid file entry in plan: " + path);
+					}
+					std::pair<FilesMap::iterator, bool> insertion = processed.files.insert(std::make_pair(
+						boost::algorithm::to_lower_copy(path), processed_file(&info.files[entry], path)
+					));
+					if(!insertion.second && &insertion.first->second.entry() != &info.files[entry]) {
+						throw std::runtime_error("Collision in plan: " + path);
+					}
+				}
+			}
+		}
+		
+	} catch(const pt::ptree_error & e) {
+		throw std::runtime_error("Invalid plan \"" + o.from_plan.string() + "\": " + e.what());
+	}
+	
+	return processed;
+}
+
+//! \return a key identifying a file's content, or an empty string if it cannot be identified
+std::string content_key(const setup::data_entry & data) {
+	
+	// Adler-32 and CRC32 collisions would go unnoticed: the duplicate outputs are verified
+	// against the same expected checksum that matched in the first place
+	if(data.file.checksum.type != crypto::MD5 && data.file.checksum.type != crypto::SHA1) {
+		return std::string();
+	}
+	
+	std::ostringstream oss;
+	oss << data.uncompressed_size << ' ' << data.file.checksum;
+	return oss.str();
+}
+
+/*!
+ * Decode data that is stored more than once only once.
+ *
+ * Chunks where every file has the same size and MD5 or SHA-1 checksum as a file in an earlier
+ * chunk are dropped, and their outputs are written from the earlier copy. This is mostly
+ * useful for non-solid installers where the same file is stored separately for several
+ * components.
+ */
+void skip_duplicates(Chunks & chunks, const setup::info & info, OutputLocations & files_for_location,
+                     bool have_password) {
+	
+	typedef std::unordered_map<std::string, size_t> ContentMap;
+	ContentMap content;
+	
+	size_t skipped = 0;
+	
+	for(Chunks::iterator chunk = chunks.begin(); chunk != chunks.end(); ) {
+		
+		bool decoded = (chunk->first.encryption == stream::Plaintext || have_password);
+		
+		bool duplicate = decoded;
+		for(const Files::value_type & location : chunk->second) {
+			if(!duplicate) {
+				break;
+			}
+			std::string key = content_key(info.data_entries[location.second]);
+			duplicate = !key.empty() && content.find(key) != content.end();
+		}
+		
+		if(!duplicate) {
+			if(decoded) {
+				for(const Files::value_type & location : chunk->second) {
+					std::string key = content_key(info.data_entries[location.second]);
+					if(!key.empty()) {
+						content.insert(std::make_pair(key, location.second));
+					}
+				}
+			}
+			++chunk;
+			continue;
+		}
+		
+		for(const Files::value_type & location : chunk->second) {
+			size_t original = content[content_key(info.data_entries[location.second])];
+			std::vector<output_location> & outputs = files_for_location[location.second];
+			files_for_location[original].insert(files_for_location[original].end(),
+			                                    outputs.begin(), outputs.end());
+			outputs.clear();
+		}
+		
+		skipped++;
+		chunks.erase(chunk++);
+	}
+	
+	debug("skipping " << skipped << " chunks with duplicate content");
+}
+
+//! \return the name of a file's data in the content store, or an empty string if it has none
+std::string store_name(const setup::data_entry & data) {
+	
+	const crypto::checksum & checksum = data.file.checksum;
+	
+	// Adler-32 and CRC32 are too weak to identify files across installers
+	std::ostringstream oss;
+	if(checksum.type == crypto::MD5) {
+		oss << print_hex(checksum.md5, sizeof(checksum.md5));
+	} else if(checksum.type == crypto::SHA1) {
+		oss << print_hex(checksum.sha1, sizeof(checksum.sha1));
+	} else {
+		return std::string();
+	}
+	oss << '-' << data.uncompressed_size;
+	
+	return oss.str();
+}
+
+//! \return true if the data is written to whole files that can be shared with the store
+bool is_storable(const std::vector<output_location> & outputs) {
+	
+	for(const output_location & output : outputs) {
+		if(output.first->is_multipart()) {
+			return false;
+		}
+	}
+	
+	return !outputs.empty();
+}
+
+/*!
+ * Create the files for chunks whose contents are all in the content store.
+ *
+ * These chunks are dropped and will not be decoded.
+ */
+void extract_from_store(Chunks & chunks, const setup::info & info, OutputLocations & files_for_location,
+                        const util::content_store & store, const util::output_tree & output_tree,
+                        const extract_options & o) {
+	
+	for(Chunks::iterator chunk = chunks.begin(); chunk != chunks.end(); ) {
+		
+		bool stored = true;
+		for(const Files::value_type & location : chunk->second) {
+			const setup::data_entry & data = info.data_entries[location.second];
+			std::string name = store_name(data);
+			if(name.empty() || !is_storable(files_for_location[location.second])
+			   || !store.contains(name, data.uncompressed_size)) {
+				stored = false;
+				break;
+			}
+		}
+		if(!stored) {
+			++chunk;
+			continue;
+		}
+		
+		for(const Files::value_type & location : chunk->second) {
+			
+			std::string name = store_name(info.data_entries[location.second]);
+			
+			for(const output_location & output : files_for_location[location.second]) {
+				
+				const processed_file & file = *output.first;
+				fs::path path = output_tree.full_path(file.path());
+				
+				const setup::data_entry & data = info.data_entries[file.entry().location];
+				util::time filetime = data.timestamp;
+				if(o.local_timestamps && !(data.options & data.TimeStampInUTC)) {
+					filetime = util::to_local_time(filetime);
+				}
+				
+				std::time_t mtime = std::time_t(filetime);
+				bool linked = store.materialize(name, path, o.store_links,
+				                                o.preserve_file_times ? &mtime : NULL);
+				
+				if(o.preserve_file_times && !linked) {
+					if(!util::set_file_time(path, filetime, data.timestamp_nsec)) {
+						log_warning << "Error setting timestamp on file " << path;
+					}
+				}
+				
+				if(o.list) {
+					if(!o.silent) {
+						std::cout << " - \"" << color::white << file.path() << color::reset << '"';
+						print_filter_info(file.entry());
+						if(o.list_sizes) {
+							print_size_info(data.file, file.entry().size);
+						}
+						std::cout << " - stored\n";
+					} else {
+						std::cout << color::white << file.path() << color::reset << '\n';
+					}
+				}
+				
+			}
+			
+			files_for_location[location.second].clear();
+		}
+		
+		chunks.erase(chunk++);
+	}
+	
+}
+
+//! \return true if two files have the same data, judging by their sizes and checksums
+bool same_content(const setup::info & old_info, const setup::file_entry & old_file,
+                  const setup::info & new_info, const setup::file_entry & new_file) {
+	
+	if(old_file.additional_locations.size() != new_file.additional_locations.size()) {
+		return false;
+	}
+	
+	for(size_t i = 0; i <= old_file.additional_locations.size(); i++) {
+		const setup::data_entry & old_data = old_info.data_entries[
+			i == 0 ? old_file.location : old_file.additional_locations[i - 1]
+		];
+		const setup::data_entry & new_data = new_info.data_entries[
+			i == 0 ? new_file.location : new_file.additional_locations[i - 1]
+		];
+		if(old_data.uncompressed_size != new_data.uncompressed_size
+		   || old_data.file.checksum != new_data.file.checksum) {
+			return false;
+		}
+		if(new_data.file.checksum.type == crypto::None
+		   && (old_data.timestamp != new_data.timestamp
+		       || old_data.timestamp_nsec != new_data.timestamp_nsec)) {
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+//! Load only the file, directory and data entries of an installer
+void load_file_entries(const fs::path & installer, const extract_options & o, util::ifstream & ifs,
+                       loader::offsets & offsets, setup::info & info) {
+	
+	try {
+		ifs.open(installer, std::ios_base::in | std::ios_base::binary);
+		if(!ifs.is_open()) {
+			throw std::exception();
+		}
+	} catch(...) {
+		throw std::runtime_error("Could not open file \"" + installer.string() + '"');
+	}
+	
+	offsets.load(ifs);
+	
+	setup::info::entry_types entries = setup::info::Files | setup::info::Directories
+	                                   | setup::info::DataEntries;
+	if(!o.extract_unknown) {
+		entries |= setup::info::NoUnknownVersion;
+	}
+	
+	ifs.seekg(offsets.header_offset);
+	try {
+		util::stats::timer timer(util::stats::Headers);
+		info.load(ifs, entries, o.codepage);
+	} catch(const setup::version_error &) {
+		throw std::runtime_error("Not a supported Inno Setup installer: \"" + installer.string() + '"');
+	} catch(const std::exception & e) {
+		std::ostringstream oss;
+		oss << "Stream error while parsing setup headers of \"" << installer.string() << "\"!\n";
+		oss << " ├─ detected setup version: " << info.version << '\n';
+		oss << " └─ error reason: " << e.what();
+		throw format_error(oss.str());
+	}
+	
+}
+
+void create_single_directory(const fs::path & o) {
+	
+	try {
+		if(!o.empty() && !fs::exists(o)) {
+			fs::create_directory(o);
+		}
+	} catch(...) {
+		throw std::runtime_error("Could not create directory \"" + o.string() + '"');
+	}
+	
+}
+
+bool test_password(const std::string & password, const setup::info & info) {
+	
+	if(info.header.options & setup::header::Password) {
+		crypto::hasher checksum(info.header.password.type);
+		checksum.update(info.header.password_salt.c_str(), info.header.password_salt.length());
+		checksum.update(password.c_str(), password.length());
+		return (checksum.finalize() == info.header.password);
+	}
+	return false;
+}
+
+} // anonymous namespace
+
+void process_file(const fs::path & installer, const extract_options & o) {
+	
+	util::trace::span span("setup", "process_file");
+	span.arg("file", installer.string());
+	
+	bool is_directory;
+	try {
+		is_directory = fs::is_directory(installer);
+	} catch(...) {
+		throw std::runtime_error("Could not open file \"" + installer.string()
+		                         + "\": access denied");
+	}
+	if(is_directory) {
+		throw std::runtime_error("Input file \"" + installer.string() + "\" is a directory!");
+	}
+	
+	util::ifstream ifs;
+	try {
+		ifs.open(installer, std::ios_base::in | std::ios_base::binary);
+		if(!ifs.is_open()) {
+			throw std::exception();
+		}
+	} catch(...) {
+		throw std::runtime_error("Could not open file \"" + installer.string() + '"');
+	}
+	
+	if(o.stats != NoStats) {
+		util::stats::enabled = true;
+		util::stats::reset();
+	}
+	
+	loader::offsets offsets;
+	offsets.load(ifs);
+	
+	#ifdef DEBUG
+	if(logger::debug) {
+		print_offsets(offsets);
+		std::cout << '\n';
+	}
+	#endif
+	
+	if(o.data_version)  {
+		setup::version version;
+		ifs.seekg(offsets.header_offset);
+		version.load(ifs);
+		if(o.silent) {
+			std::cout << version << '\n';
+		} else {
+			std::cout << color::white << version << color::reset << '\n';
+		}
+		return;
+	}
+	
+	#ifdef DEBUG
+	if(o.dump_headers)  {
+		create_single_directory(o.output_dir);
+		dump_headers(ifs, offsets, o);
+		return;
+	}
+	#endif
+	
+	bool planning = !o.plan_file.empty();
+	
+	setup::info::entry_types entries = 0;
+	if(o.list || o.test || o.extract || planning || (o.gog_galaxy && o.list_languages)) {
+		entries |= setup::info::Files;
+		entries |= setup::info::Directories;
+		entries |= setup::info::DataEntries;
+	}
+	if(o.list_languages) {
+		entries |= setup::info::Languages;
+	}
+	if(o.list_components) {
+		entries |= setup::info::Components;
+	}
+	if(o.gog_game_id || o.gog) {
 		entries |= setup::info::RegistryEntries;
 	}
 	if(!o.extract_unknown) {
@@ -1017,6 +2040,7 @@ void process_file(const fs::path & installer, const extract_options & o) {
 	ifs.seekg(offsets.header_offset);
 	setup::info info;
 	try {
+		util::stats::timer timer(util::stats::Headers);
 		info.load(ifs, entries, o.codepage);
 	} catch(const setup::version_error &) {
 		fs::path headerfile = installer;
@@ -1101,7 +2125,7 @@ void process_file(const fs::path & installer, const extract_options & o) {
 		#endif
 	}
 	
-	if(!o.list && !o.test && !o.extract) {
+	if(!o.list && !o.test && !o.extract && !planning) {
 		return;
 	}
 	
@@ -1109,19 +2133,31 @@ void process_file(const fs::path & installer, const extract_options & o) {
 		std::cout << "Files:\n";
 	}
 	
-	processed_entries processed = filter_entries(o, info);
+	processed_entries processed = o.from_plan.empty() ? filter_entries(o, info) : load_plan(o, info);
 	
-	if(o.extract) {
+	boost::scoped_ptr<archive_output> archive;
+	if(o.extract && o.output_format == TarOutput) {
+		archive.reset(new archive_output(o));
+	} else if(o.extract) {
 		create_single_directory(o.output_dir);
 	}
 	
+	util::output_tree output_tree(o.output_dir);
+	if(o.extract && !archive && o.output_batch != 0 && o.store.empty()
+	   && !output_tree.enable_batch(o.output_batch)) {
+		log_info << "io_uring is not available, writing output files one by one";
+	}
+	
+	// Timestamp for archive entries without a stored time
+	util::time archive_time = util::time(std::time(NULL));
+	
 	if(o.list || o.extract) {
 		
 		for(const DirectoriesMap::value_type & i : processed.directories) {
 			
 			const std::string & path = i.second.path();
 			
-			if(o.list && !i.second.implied()) {
+			if(o.list && !i.second.implied() && o.shard == 0) {
 				
 				if(!o.silent) {
 					
@@ -1138,81 +2174,111 @@ void process_file(const fs::path & installer, const extract_options & o) {
 				
 			}
 			
-			if(o.extract) {
-				create_single_directory(o.output_dir / path);
+			if(archive) {
+				archive->writer().add_directory(path, archive_time);
+			} else if(o.extract) {
+				output_tree.create_directory(path);
 			}
 			
 		}
 		
 	}
 	
-	typedef std::pair<const processed_file *, boost::uint64_t> output_location;
-	std::vector< std::vector<output_location> > files_for_location;
-	files_for_location.resize(info.data_entries.size());
-	for(const FilesMap::value_type & i : processed.files) {
-		const processed_file & file = i.second;
-		files_for_location[file.entry().location].push_back(output_location(&file, 0));
-		if(o.test || o.extract) {
-			boost::uint64_t offset = info.data_entries[file.entry().location].uncompressed_size;
-			boost::uint32_t sort_slice = info.data_entries[file.entry().location].chunk.first_slice;
-			boost::uint32_t sort_offset = info.data_entries[file.entry().location].chunk.sort_offset;
-			for(boost::uint32_t location : file.entry().additional_locations) {
-				setup::data_entry & data = info.data_entries[location];
-				files_for_location[location].push_back(output_location(&file, offset));
-				offset += data.uncompressed_size;
-				if(data.chunk.first_slice > sort_slice ||
-				   (data.chunk.first_slice == sort_slice && data.chunk.sort_offset > sort_offset)) {
-					sort_slice = data.chunk.first_slice;
-					sort_offset = data.chunk.sort_offset;
-				} else if(data.chunk.first_slice == sort_slice && data.chunk.sort_offset == data.chunk.offset) {
-					data.chunk.sort_offset = ++sort_offset;
-				} else {
-					// Could not reorder chunk - no point in trying to reordder the remaining chunks
-					sort_slice = boost::uint32_t(-1);
-				}
-			}
-		}
+	OutputLocations files_for_location;
+	Chunks chunks;
+	group_chunks(info, processed.files, o.test || o.extract || planning, files_for_location, chunks);
+	
+	if(o.shard_count > 1) {
+		select_shard(chunks, info, processed.files, o.shard, o.shard_count);
+	}
+	
+	// Every chunk needs to be decoded to verify its checksums when testing
+	if(o.extract && !o.test) {
+		skip_duplicates(chunks, info, files_for_location, !password.empty());
+	}
+	
+	boost::scoped_ptr<util::content_store> store;
+	// Files from the store are not verified, so they are not used when testing
+	if(o.extract && !o.test && !o.store.empty() && !archive) {
+		store.reset(new util::content_store(o.store));
+		extract_from_store(chunks, info, files_for_location, *store, output_tree, o);
 	}
 	
 	boost::uint64_t total_size = 0;
+	for(const Chunks::value_type & chunk : chunks) {
+		for(const Files::value_type & location : chunk.second) {
+			total_size += info.data_entries[location.second].uncompressed_size;
+		}
+	}
 	
-	typedef std::map<stream::file, size_t> Files;
-	typedef std::map<stream::chunk, Files> Chunks;
-	Chunks chunks;
-	for(size_t i = 0; i < info.data_entries.size(); i++) {
-		if(!files_for_location[i].empty()) {
-			setup::data_entry & location = info.data_entries[i];
-			chunks[location.chunk][location.file] = i;
-			total_size += location.uncompressed_size;
+	if(planning) {
+		save_plan(o, installer, ifs, offsets, info, processed, chunks, files_for_location, password);
+		return;
+	}
+	
+	/*
+	 * Decide how each file is added to the archive: Files are streamed directly if possible.
+	 * Further files with the same data are stored as hard links. Multi-part files can only be
+	 * streamed if their parts are read one after the other without any other output in between,
+	 * otherwise they are assembled in a temporary file first.
+	 */
+	typedef std::unordered_map<const processed_file *, archive_entry> ArchiveEntries;
+	ArchiveEntries archive_entries;
+	if(archive) {
+		
+		std::vector<size_t> sequence(info.data_entries.size(), size_t(-1));
+		size_t next = 0;
+		for(const Chunks::value_type & chunk : chunks) {
+			for(const Files::value_type & location : chunk.second) {
+				sequence[location.second] = next++;
+			}
+		}
+		
+		for(size_t i = 0; i < info.data_entries.size(); i++) {
+			const processed_file * primary = NULL;
+			for(const output_location & output : files_for_location[i]) {
+				const processed_file * file = output.first;
+				if(output.second != 0 || archive_entries.find(file) != archive_entries.end()) {
+					continue;
+				}
+				archive_entry & entry = archive_entries[file];
+				entry.size = info.data_entries[i].uncompressed_size;
+				if(!file->is_multipart()) {
+					if(primary) {
+						entry.mode = file_output::LinkEntry;
+						entry.link = primary->path();
+					} else {
+						entry.mode = file_output::StreamEntry;
+						primary = file;
+					}
+					continue;
+				}
+				bool consecutive = (files_for_location[i].size() == 1);
+				size_t expected = sequence[i];
+				for(boost::uint32_t location : file->entry().additional_locations) {
+					entry.size += info.data_entries[location].uncompressed_size;
+					if(sequence[location] != ++expected || files_for_location[location].size() != 1) {
+						consecutive = false;
+					}
+				}
+				entry.mode = consecutive ? file_output::StreamEntry : file_output::SpoolEntry;
+			}
 		}
+		
 	}
 	
 	boost::scoped_ptr<stream::slice_reader> slice_reader;
 	if(o.extract || o.test) {
-		if(offsets.data_offset) {
-			slice_reader.reset(new stream::slice_reader(&ifs, offsets.data_offset));
-		} else {
-			fs::path dir = installer.parent_path();
-			std::string basename = util::as_string(installer.stem());
-			std::string basename2 = info.header.base_filename;
-			// Prevent access to unexpected files
-			std::replace(basename2.begin(), basename2.end(), '/', '_');
-			std::replace(basename2.begin(), basename2.end(), '\\', '_');
-			// Older Inno Setup versions used the basename stored in the headers, change our default accordingly
-			if(info.version < INNO_VERSION(4, 1, 7) && !basename2.empty()) {
-				std::swap(basename2, basename);
-			}
-			slice_reader.reset(new stream::slice_reader(dir, basename, basename2, info.header.slices_per_disk));
-		}
+		slice_reader.reset(innoextract::open_slices(installer, &ifs, offsets, info));
 	}
 	
 	progress extract_progress(total_size);
 
-	if (o.extract && (o.iss_file || o.compiledcode)) {
+	if (o.extract && (o.iss_file || o.compiledcode) && o.shard == 0) {
 		create_single_directory(o.output_dir / "embedded");
 	}
 	
-	if (o.extract && o.compiledcode) {
+	if (o.extract && o.compiledcode && o.shard == 0) {
 		util::fstream stream;
 		stream.open(o.output_dir / "embedded" / "CompiledCode.bin", std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
 		stream.write(info.header.compiled_code.data(), static_cast<std::streamsize>(info.header.compiled_code.size()));
@@ -1220,7 +2286,7 @@ void process_file(const fs::path & installer, const extract_options & o) {
 		std::cout << " - " << '"' << color::white << "embedded/CompiledCode.bin" << color::reset << '"' << '\n';
 	}
 
-	if (o.extract && o.iss_file) {
+	if (o.extract && o.iss_file && o.shard == 0) {
 		iss::dump_iss(info, o, installer);
 		std::cout << " - " << '"' << color::white << "install_script.iss" << color::reset << '"' << '\n';
 	}
@@ -1228,15 +2294,34 @@ void process_file(const fs::path & installer, const extract_options & o) {
 	typedef boost::ptr_map<const processed_file *, file_output> multi_part_outputs;
 	multi_part_outputs multi_outputs;
 	
+	// Reader and outputs for single-part files are re-used for all files
+	stream::file_reader_context file_source;
+	boost::ptr_vector<file_output> output_pool;
+	std::vector<file_output *> outputs;
+	
 	for(const Chunks::value_type & chunk : chunks) {
 		
 		debug("[starting " << chunk.first.compression << " chunk @ slice " << chunk.first.first_slice
 		      << " + " << print_hex(offsets.data_offset) << " + " << print_hex(chunk.first.offset)
 		      << ']');
 		
+		util::trace::span chunk_span("chunk", "chunk");
+		if(chunk_span.active()) {
+			std::ostringstream compression;
+			compression << chunk.first.compression;
+			chunk_span.arg("compression", compression.str()).arg("slice", chunk.first.first_slice)
+			          .arg("offset", chunk.first.offset).arg("size", chunk.first.size)
+			          .arg("files", chunk.second.size());
+		}
+		
 		stream::chunk_reader::pointer chunk_source;
 		if((o.extract || o.test) && (chunk.first.encryption == stream::Plaintext || !password.empty())) {
 			chunk_source = stream::chunk_reader::get(*slice_reader, chunk.first, password);
+			// Read ahead the next chunk while this one is being decoded
+			Chunks::const_iterator next = chunks.upper_bound(chunk.first);
+			if(next != chunks.end()) {
+				stream::chunk_reader::prefetch(*slice_reader, next->first);
+			}
 		}
 		boost::uint64_t offset = 0;
 		
@@ -1248,6 +2333,10 @@ void process_file(const fs::path & installer, const extract_options & o) {
 				debug("discarding " << print_bytes(file.offset - offset)
 				      << " @ " << print_hex(offset));
 				if(chunk_source.get()) {
+					util::stats::count(util::stats::Discards);
+					util::stats::count(util::stats::DiscardedBytes, file.offset - offset);
+					util::trace::span discard_span("chunk", "discard");
+					discard_span.arg("bytes", file.offset - offset);
 					util::discard(*chunk_source, file.offset - offset);
 				}
 			}
@@ -1347,15 +2436,20 @@ void process_file(const fs::path & installer, const extract_options & o) {
 				continue; // Not extracting/testing this file
 			}
 			
+			util::trace::span file_span("file", "file");
+			if(file_span.active()) {
+				file_span.arg("path", output_locations.front().first->path())
+				         .arg("offset", file.offset).arg("size", file.size);
+			}
+			
 			crypto::checksum checksum;
 			
 			// Open input file
-			stream::file_reader::pointer file_source;
-			file_source = stream::file_reader::get(*chunk_source, file, &checksum);
+			file_source.open(*chunk_source, file, &checksum);
 			
 			// Open output files
-			boost::ptr_vector<file_output> single_outputs;
-			std::vector<file_output *> outputs;
+			outputs.clear();
+			size_t pooled = 0;
 			for(const output_location & output_loc : output_locations) {
 				const processed_file * fileinfo = output_loc.first;
 				try {
@@ -1374,11 +2468,29 @@ void process_file(const fs::path & installer, const extract_options & o) {
 					}
 					
 					if(!output) {
-						output = new file_output(o.output_dir, fileinfo, o.extract);
 						if(fileinfo->is_multipart()) {
+							output = new file_output;
 							multi_outputs.insert(fileinfo, output);
 						} else {
-							single_outputs.push_back(output);
+							if(pooled == output_pool.size()) {
+								output_pool.push_back(new file_output);
+							}
+							output = &output_pool[pooled++];
+						}
+						if(archive) {
+							const archive_entry & entry = archive_entries[fileinfo];
+							const setup::data_entry & data = info.data_entries[fileinfo->entry().location];
+							util::time mtime = archive_time;
+							if(o.preserve_file_times) {
+								mtime = data.timestamp;
+								if(o.local_timestamps && !(data.options & data.TimeStampInUTC)) {
+									mtime = util::to_local_time(mtime);
+								}
+							}
+							output->open(output_tree, fileinfo, o, archive.get(), entry.mode,
+							             entry.size, mtime, entry.link);
+						} else {
+							output->open(output_tree, fileinfo, o);
 						}
 					}
 					
@@ -1392,22 +2504,41 @@ void process_file(const fs::path & installer, const extract_options & o) {
 				}
 			}
 			
+			if(archive) {
+				// Streamed entries must be completed before other entries can be added
+				std::stable_sort(outputs.begin(), outputs.end(), file_output::archive_order);
+			}
+			
 			// Copy data
 			boost::uint64_t output_size = 0;
-			while(!file_source->eof()) {
+			for(;;) {
 				char buffer[8192 * 10];
-				std::streamsize buffer_size = std::streamsize(std::size(buffer));
-				std::streamsize n = file_source->read(buffer, buffer_size).gcount();
-				if(n > 0) {
-					for(file_output * output : outputs) {
-						bool success = output->write(buffer, size_t(n));
-						if(!success) {
-							throw std::runtime_error("Error writing file \"" + output->path().string() + '"');
-						}
+				char * data = buffer;
+				size_t n = sizeof(buffer);
+				for(file_output * output : outputs) {
+					// Decode directly into the output file if it is mapped
+					char * mapped = output->mapped(n);
+					if(mapped) {
+						data = mapped;
+						break;
+					}
+				}
+				{
+					util::stats::timer timer(util::stats::Copy);
+					n = file_source.read(data, n);
+					timer.add(n);
+				}
+				if(n == 0) {
+					break;
+				}
+				for(file_output * output : outputs) {
+					bool success = output->write(data, n);
+					if(!success) {
+						throw std::runtime_error("Error writing file \"" + output->path().string() + '"');
 					}
-					extract_progress.update(boost::uint64_t(n));
-					output_size += boost::uint64_t(n);
 				}
+				extract_progress.update(boost::uint64_t(n));
+				output_size += boost::uint64_t(n);
 			}
 			
 			const setup::data_entry & data = info.data_entries[location.second];
@@ -1416,34 +2547,50 @@ void process_file(const fs::path & installer, const extract_options & o) {
 				log_warning << "Unexpected output file size: " << output_size << " != " << data.uncompressed_size;
 			}
 			
-			util::time filetime = data.timestamp;
-			if(o.extract && o.preserve_file_times && o.local_timestamps && !(data.options & data.TimeStampInUTC)) {
-				filetime = util::to_local_time(filetime);
-			}
-			
 			for(file_output * output : outputs) {
 				
 				if(output->file()->is_multipart() && !output->is_complete()) {
 					continue;
 				}
 				
+				// Duplicate content is only decoded once, but keep each file's own timestamp
+				const setup::data_entry & file_data = output->file()->is_multipart()
+				                                      ? data : info.data_entries[output->file()->entry().location];
+				util::time filetime = file_data.timestamp;
+				if(o.extract && o.preserve_file_times && o.local_timestamps
+				   && !(file_data.options & file_data.TimeStampInUTC)) {
+					filetime = util::to_local_time(filetime);
+				}
+				
 				// Verify output checksum if available
-				if(output->file()->entry().checksum.type != crypto::None && output->calculate_checksum()) {
-					crypto::checksum output_checksum = output->checksum();
-					if(output_checksum != output->file()->entry().checksum) {
-						log_warning << "Output checksum mismatch for " << output->file()->path() << ":\n"
-						            << " ├─ actual:   " << output_checksum << '\n'
-						            << " └─ expected: " << output->file()->entry().checksum;
-						if(o.test) {
-							throw std::runtime_error("Integrity test failed!");
+				if(output->file()->entry().checksum.type != crypto::None) {
+					util::trace::span verify_span("file", "verify");
+					if(output->calculate_checksum()) {
+						crypto::checksum output_checksum = output->checksum();
+						if(output_checksum != output->file()->entry().checksum) {
+							log_warning << "Output checksum mismatch for " << output->file()->path() << ":\n"
+							            << " ├─ actual:   " << output_checksum << '\n'
+							            << " └─ expected: " << output->file()->entry().checksum;
+							if(o.test) {
+								throw std::runtime_error("Integrity test failed!");
+							}
 						}
 					}
 				}
 				
 				// Adjust file timestamps
-				if(o.extract && o.preserve_file_times) {
-					output->close();
-					if(!util::set_file_time(output->path(), filetime, data.timestamp_nsec)) {
+				if(o.extract) {
+					bool time_set = true;
+					bool success;
+					if(o.preserve_file_times) {
+						success = output->close(filetime, file_data.timestamp_nsec, time_set);
+					} else {
+						success = output->close();
+					}
+					if(!success) {
+						throw std::runtime_error("Error writing file \"" + output->path().string() + '"');
+					}
+					if(!time_set) {
 						log_warning << "Error setting timestamp on file " << output->path();
 					}
 				}
@@ -1463,6 +2610,11 @@ void process_file(const fs::path & installer, const extract_options & o) {
 				if(o.test) {
 					throw std::runtime_error("Integrity test failed!");
 				}
+			} else if(store && is_storable(output_locations)) {
+				std::string name = store_name(data);
+				if(!name.empty() && !store->add(name, outputs.front()->path())) {
+					log_warning << "Could not add " << outputs.front()->path() << " to the store";
+				}
 			}
 			
 		}
@@ -1475,14 +2627,122 @@ void process_file(const fs::path & installer, const extract_options & o) {
 		#endif
 	}
 	
+	output_tree.flush();
+	
 	extract_progress.clear();
 	
 	if(!multi_outputs.empty()) {
 		log_warning << "Incomplete multi-part files";
 	}
 	
-	if(o.warn_unused || o.gog) {
+	if(archive) {
+		std::vector<file_output *> incomplete;
+		for(multi_part_outputs::iterator it = multi_outputs.begin(); it != multi_outputs.end(); ++it) {
+			incomplete.push_back(it->second);
+		}
+		std::stable_sort(incomplete.begin(), incomplete.end(), file_output::archive_order);
+		for(file_output * output : incomplete) {
+			output->close();
+		}
+		multi_outputs.clear();
+		archive->finish();
+	}
+	
+	if((o.warn_unused || o.gog) && o.shard == 0) {
 		gog::probe_bin_files(o, info, installer, offsets.data_offset == 0);
 	}
 	
+	if(o.stats == JsonStats) {
+		util::stats::print_json(std::cerr);
+	} else if(o.stats == TextStats) {
+		util::stats::print(std::cerr);
+	}
+	
+}
+
+void diff_installers(const fs::path & old_installer, const fs::path & new_installer,
+                     const extract_options & o) {
+	
+	util::trace::span span("setup", "diff_installers");
+	
+	util::ifstream old_ifs, new_ifs;
+	loader::offsets old_offsets, new_offsets;
+	setup::info old_info, new_info;
+	load_file_entries(old_installer, o, old_ifs, old_offsets, old_info);
+	load_file_entries(new_installer, o, new_ifs, new_offsets, new_info);
+	
+	// Only print diff lines, not the files that would be overwritten
+	processed_entries old_processed = filter_entries(o, old_info, false);
+	processed_entries processed = filter_entries(o, new_info, false);
+	
+	// Status and display path for each changed file, sorted by path
+	std::map<std::string, std::pair<char, std::string> > changes;
+	size_t unchanged = 0;
+	
+	for(const FilesMap::value_type & i : old_processed.files) {
+		if(processed.files.find(i.first) == processed.files.end()) {
+			changes[i.first] = std::make_pair('D', i.second.path());
+		}
+	}
+	
+	for(FilesMap::iterator i = processed.files.begin(); i != processed.files.end(); ) {
+		FilesMap::const_iterator old_file = old_processed.files.find(i->first);
+		if(old_file == old_processed.files.end()) {
+			changes[i->first] = std::make_pair('A', i->second.path());
+		} else if(!same_content(old_info, old_file->second.entry(), new_info, i->second.entry())) {
+			changes[i->first] = std::make_pair('M', i->second.path());
+		} else {
+			// Only keep added and changed files for the plan
+			unchanged++;
+			i = processed.files.erase(i);
+			continue;
+		}
+		++i;
+	}
+	
+	size_t added = 0, removed = 0, changed = 0;
+	for(const std::map<std::string, std::pair<char, std::string> >::value_type & i : changes) {
+		switch(i.second.first) {
+			case 'A': added++; break;
+			case 'D': removed++; break;
+			default: changed++; break;
+		}
+		if(o.silent) {
+			std::cout << i.second.first << ' ' << i.second.second << '\n';
+			continue;
+		}
+		switch(i.second.first) {
+			case 'A': std::cout << " + \"" << color::green; break;
+			case 'D': std::cout << " - \"" << color::red; break;
+			default: std::cout << " * \"" << color::yellow; break;
+		}
+		std::cout << i.second.second << color::reset << "\"\n";
+	}
+	
+	if(!o.quiet) {
+		std::cout << color::green << added << color::reset << " added, "
+		          << color::red << removed << color::reset << " removed, "
+		          << color::yellow << changed << color::reset << " changed, "
+		          << unchanged << " unchanged\n";
+	}
+	
+	if(!o.plan_file.empty()) {
+		
+		std::string password;
+		if(!o.password.empty()) {
+			util::from_utf8(o.password, password, new_info.codepage);
+			if(!test_password(password, new_info)) {
+				log_error << "Incorrect password provided";
+				password.clear();
+			}
+		}
+		
+		OutputLocations files_for_location;
+		Chunks chunks;
+		group_chunks(new_info, processed.files, true, files_for_location, chunks);
+		
+		save_plan(o, new_installer, new_ifs, new_offsets, new_info, processed, chunks,
+		          files_for_location, password);
+	}
+	
 }
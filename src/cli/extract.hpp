@@ -35,6 +35,8 @@
 
 #include "setup/filename.hpp"
 
+#include "util/outputfile.hpp"
+
 struct format_error : public std::runtime_error {
 	explicit format_error(const std::string & reason) : std::runtime_error(reason) { }
 };
@@ -46,6 +48,17 @@ enum CollisionAction {
 	ErrorOnCollisions
 };
 
+enum OutputFormat {
+	DirectoryOutput,
+	TarOutput
+};
+
+enum StatsFormat {
+	NoStats,
+	TextStats,
+	JsonStats
+};
+
 struct extract_options {
 	
 	bool quiet;
@@ -97,6 +110,24 @@ struct extract_options {
 	
 	boost::filesystem::path output_dir;
 	
+	size_t output_buffer_size; //!< Maximum write buffer size for each output file
+	util::output_cache_mode output_cache; //!< How to handle the page cache for output files
+	size_t output_batch; //!< Number of small output files to write at once, 0 to write them one by one
+	
+	OutputFormat output_format;
+	boost::filesystem::path output_file; //!< Archive to write for \ref TarOutput, "-" for stdout
+	
+	StatsFormat stats; //!< Print timing and throughput statistics to stderr
+	
+	size_t shard; //!< Which part of the setup data to process, starting at \c 0
+	size_t shard_count; //!< Split the setup data into this many parts by chunk
+	
+	boost::filesystem::path plan_file; //!< Write the resolved work to this file, "-" for stdout
+	boost::filesystem::path from_plan; //!< Process the work from this plan instead of filtering
+	
+	boost::filesystem::path store; //!< Content-addressed store to share extracted files with
+	bool store_links; //!< Hard-link files to store entries instead of cloning or copying them
+	
 	extract_options()
 		: quiet(false)
 		, silent(false)
@@ -120,10 +151,28 @@ struct extract_options {
 		, extract_temp(false)
 		, language_only(false)
 		, collisions(OverwriteCollisions)
+		, output_buffer_size(util::output_file::default_buffer_size)
+		, output_cache(util::KeepCache)
+		, output_batch(0)
+		, output_format(DirectoryOutput)
+		, output_file("-")
+		, stats(NoStats)
+		, shard(0)
+		, shard_count(1)
+		, store_links(false)
 	{ }
 	
 };
 
 void process_file(const boost::filesystem::path & installer, const extract_options & o);
 
+/*!
+ * Compare the files of two installers using only their headers.
+ *
+ * Prints the added, removed and changed files. If \ref extract_options::plan_file is set,
+ * also writes a plan to extract only the added and changed files from the new installer.
+ */
+void diff_installers(const boost::filesystem::path & old_installer,
+                     const boost::filesystem::path & new_installer, const extract_options & o);
+
 #endif // INNOEXTRACT_CLI_EXTRACT_HPP
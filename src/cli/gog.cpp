@@ -21,6 +21,7 @@
 #include "cli/gog.hpp"
 
 #include <stddef.h>
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <iomanip>
@@ -50,6 +51,7 @@
 #include "util/fstream.hpp"
 #include "util/log.hpp"
 #include "util/process.hpp"
+#include "util/tempdir.hpp"
 
 namespace fs = boost::filesystem;
 
@@ -106,6 +108,51 @@ void quit_handler(int /* ignored */) {
 	quit_requested = 1;
 }
 
+//! Remember termination signals instead of exiting while the handlers are installed.
+class quit_guard : private boost::noncopyable {
+	
+	typedef void(*signal_handler /* … */)(int /* … */);
+	
+	bool active;
+	signal_handler old_sigint_handler;
+	signal_handler old_sigterm_handler;
+	signal_handler old_sighup_handler;
+	
+public:
+	
+	quit_guard() : active(true) {
+		#ifdef SIGINT
+		old_sigint_handler = signal(SIGINT, quit_handler);
+		#endif
+		#ifdef SIGTERM
+		old_sigterm_handler = signal(SIGTERM, quit_handler);
+		#endif
+		#ifdef SIGHUP
+		old_sighup_handler = signal(SIGHUP, quit_handler);
+		#endif
+	}
+	
+	~quit_guard() {
+		restore();
+	}
+	
+	void restore() {
+		if(active) {
+			#ifdef SIGHUP
+			signal(SIGHUP, old_sighup_handler);
+			#endif
+			#ifdef SIGTERM
+			signal(SIGTERM, old_sigterm_handler);
+			#endif
+			#ifdef SIGINT
+			signal(SIGINT, old_sigint_handler);
+			#endif
+			active = false;
+		}
+	}
+	
+};
+
 bool process_file_unrar(const std::string & file, const extract_options & o, const std::string & password) {
 	
 	std::vector<const char *> args;
@@ -250,58 +297,9 @@ char hex_char(int c) {
 	}
 }
 
-class temporary_directory : private boost::noncopyable {
-	
-	fs::path parent;
-	fs::path path;
-	
-public:
-	
-	explicit temporary_directory(const fs::path & base) {
-		try {
-			if(!base.empty() && !fs::exists(base)) {
-				fs::create_directory(base);
-				parent = base;
-			}
-			size_t tmpnum = 0;
-			std::ostringstream oss;
-			do {
-				oss.str(std::string());
-				oss << "innoextract-tmp-" << tmpnum++;
-				path = base / oss.str();
-			} while(fs::exists(path));
-			fs::create_directory(path);
-		} catch(...) {
-			path = fs::path();
-			throw std::runtime_error("Could not create temporary directory!");
-		}
-	}
-	
-	~temporary_directory() {
-		if(!path.empty()) {
-			try {
-				fs::remove_all(path);
-				if(!parent.empty()) {
-					fs::remove(parent);
-				}
-			} catch(...) {
-				log_error << "Could not remove temporary directory " << path << '!';
-			}
-		}
-	}
-	
-	const fs::path & get() { return path; }
-	
-};
-
-void process_rar_files(const std::vector<fs::path> & files,
-                       const extract_options & o, const setup::info & info) {
-	
-	if((!o.list && !o.test && !o.extract) || files.empty()) {
-		return;
-	}
+//! Calculate the RAR password from the GOG.com game ID
+std::string get_password(const setup::info & info) {
 	
-	// Calculate password from the GOG.com game ID
 	std::string password = get_game_id(info);
 	if(!password.empty()) {
 		crypto::md5 md5;
@@ -316,6 +314,16 @@ void process_rar_files(const std::vector<fs::path> & files,
 		}
 	}
 	
+	return password;
+}
+
+void process_rar_files(const std::vector<fs::path> & files, const extract_options & o,
+                       const std::string & password) {
+	
+	if((!o.list && !o.test && !o.extract) || files.empty()) {
+		return;
+	}
+	
 	if((!o.extract && !o.test && o.list) || files.size() == 1) {
 		
 		// When listing contents or for single-file archives, pass the bin file to unrar
@@ -338,18 +346,9 @@ void process_rar_files(const std::vector<fs::path> & files,
 		 * names so that unrar will find all the parts of the archive.
 		 */
 		
-		typedef void(*signal_handler /* … */)(int /* … */);
-		#ifdef SIGINT
-		signal_handler old_sigint_handler = signal(SIGINT, quit_handler);
-		#endif
-		#ifdef SIGTERM
-		signal_handler old_sigterm_handler = signal(SIGTERM, quit_handler);
-		#endif
-		#ifdef SIGHUP
-		signal_handler old_sighup_handler = signal(SIGHUP, quit_handler);
-		#endif
+		quit_guard guard;
 		
-		temporary_directory tmpdir(o.output_dir);
+		util::temporary_directory tmpdir(o.output_dir);
 		
 		fs::path first_file;
 		try {
@@ -392,15 +391,7 @@ void process_rar_files(const std::vector<fs::path> & files,
 			return;
 		}
 		
-		#ifdef SIGHUP
-		signal(SIGHUP, old_sighup_handler);
-		#endif
-		#ifdef SIGTERM
-		signal(SIGTERM, old_sigterm_handler);
-		#endif
-		#ifdef SIGINT
-		signal(SIGINT, old_sigint_handler);
-		#endif
+		guard.restore();
 		if(quit_requested) {
 			throw std::runtime_error("Aborted!");
 		}
@@ -424,7 +415,7 @@ void process_bin_files(const std::vector<fs::path> & files, const extract_option
 		
 		if(std::memcmp(magic, "Rar!", 4) == 0) {
 			ifs.close();
-			process_rar_files(files, o, info);
+			process_rar_files(files, o, get_password(info));
 			return;
 		}
 		
@@ -448,10 +439,8 @@ void process_bin_files(const std::vector<fs::path> & files, const extract_option
 	                         + "\": unknown filetype");
 }
 
-size_t probe_bin_file_series(const extract_options & o, const setup::info & info, const fs::path & dir,
-                             const std::string & basename, size_t format = 0, size_t start = 0) {
-	
-	size_t count = 0;
+std::vector<fs::path> find_bin_file_series(const fs::path & dir, const std::string & basename,
+                                           size_t format = 0, size_t start = 0) {
 	
 	std::vector<fs::path> files;
 	
@@ -472,12 +461,7 @@ size_t probe_bin_file_series(const extract_options & o, const setup::info & info
 			break;
 		}
 		
-		if(o.gog) {
-			files.push_back(file);
-		} else {
-			log_warning << file.filename() << " is not part of the installer!";
-			count++;
-		}
+		files.push_back(file);
 		
 		if(format == 0) {
 			break;
@@ -485,26 +469,20 @@ size_t probe_bin_file_series(const extract_options & o, const setup::info & info
 		
 	}
 	
-	if(!files.empty()) {
-		process_bin_files(files, o, info);
-	}
-	
-	return count;
+	return files;
 }
 
-} // anonymous namespace
-
-void probe_bin_files(const extract_options & o, const setup::info & info,
-                     const fs::path & setup_file, bool external) {
+//! Find all series of .bin files next to the installer that are not used by it.
+std::vector<std::vector<fs::path> > find_bin_files(const setup::info & info, const fs::path & setup_file,
+                                                   bool external) {
 	
 	boost::filesystem::path dir = setup_file.parent_path();
 	std::string basename = util::as_string(setup_file.stem());
 	
-	size_t bin_count = 0;
-	bin_count += probe_bin_file_series(o, info, dir, basename + ".bin");
-	bin_count += probe_bin_file_series(o, info, dir, basename + "-0" + ".bin");
+	std::vector<std::vector<fs::path> > result;
+	result.push_back(find_bin_file_series(dir, basename + ".bin"));
+	result.push_back(find_bin_file_series(dir, basename + "-0" + ".bin"));
 	
-
 	boost::uint32_t max_slice = 0;
 	if(external) {
 		for(const setup::data_entry & location : info.data_entries) {
@@ -518,7 +496,7 @@ void probe_bin_files(const extract_options & o, const setup::info & info,
 	if(external && info.header.slices_per_disk == 1) {
 		slice = size_t(max_slice) + 1;
 	}
-	bin_count += probe_bin_file_series(o, info, dir, basename, format, slice);
+	result.push_back(find_bin_file_series(dir, basename, format, slice));
 	
 	slice = 0;
 	format = 2;
@@ -526,7 +504,31 @@ void probe_bin_files(const extract_options & o, const setup::info & info,
 		slice = size_t(max_slice) + 1;
 		format = info.header.slices_per_disk;
 	}
-	bin_count += probe_bin_file_series(o, info, dir, basename, format, slice);
+	result.push_back(find_bin_file_series(dir, basename, format, slice));
+	
+	result.erase(std::remove_if(result.begin(), result.end(),
+	                            [](const std::vector<fs::path> & files) { return files.empty(); }),
+	             result.end());
+	
+	return result;
+}
+
+} // anonymous namespace
+
+void probe_bin_files(const extract_options & o, const setup::info & info,
+                     const fs::path & setup_file, bool external) {
+	
+	size_t bin_count = 0;
+	for(const std::vector<fs::path> & files : find_bin_files(info, setup_file, external)) {
+		if(!o.gog) {
+			for(const fs::path & file : files) {
+				log_warning << file.filename() << " is not part of the installer!";
+				bin_count++;
+			}
+		} else {
+			process_bin_files(files, o, info);
+		}
+	}
 	
 	if(bin_count) {
 		const char * verb = "inspecting";
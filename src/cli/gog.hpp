@@ -40,6 +40,10 @@ namespace gog {
 //! \return the GOG.com game ID for this installer or an empty string
 std::string get_game_id(const setup::info & info);
 
+/*!
+ * Look for .bin files next to the installer and handle them if \ref extract_options::gog
+ * is set or warn about them otherwise.
+ */
 void probe_bin_files(const extract_options & o, const setup::info & info,
                      const boost::filesystem::path & setup_file, bool external);
 
@@ -20,8 +20,10 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <limits>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -33,13 +35,17 @@
 #include "release.hpp"
 
 #include "cli/extract.hpp"
+#include "cli/scan.hpp"
 
 #include "setup/version.hpp"
 
 #include "util/console.hpp"
 #include "util/fstream.hpp"
 #include "util/log.hpp"
+#include "util/output.hpp"
+#include "util/outputbatch.hpp"
 #include "util/time.hpp"
+#include "util/trace.hpp"
 #include "util/windows.hpp"
 
 namespace fs = boost::filesystem;
@@ -142,6 +148,9 @@ int main(int argc, char * argv[]) {
 		("show-password", "Show password check information")
 		("check-password", "Abort if the password is incorrect")
 		("data-version,V", "Only print the data version")
+		("scan", po::value< std::vector<std::string> >(), "Find installers in a directory as JSON lines")
+		("plan", po::value<std::string>(), "Write the files to process as JSON, \"-\" for stdout")
+		("diff", "Compare the files of two installers without extracting them")
 		#ifdef DEBUG
 		("dump-headers", "Dump decompressed setup headers")
 		#endif
@@ -158,11 +167,20 @@ int main(int argc, char * argv[]) {
 		("lowercase,L", "Convert extracted filenames to lower-case")
 		("timestamps,T", po::value<std::string>(), "Timezone for file times or \"local\" or \"none\"")
 		("output-dir,d", po::value<std::string>(), "Extract files into the given directory")
+		("output-batch", po::value<size_t>(), "Write up to this many small files at once using io_uring")
+		("output-buffer", po::value<std::string>(), "Write buffer size for each output file")
+		("output-cache", po::value<std::string>(), "Page cache use for output files")
+		("output-format", po::value<std::string>(), "Write files to a directory or a tar archive")
+		("output-file", po::value<std::string>(), "Archive file to write, \"-\" for stdout")
 		("password,P", po::value<std::string>(), "Password for encrypted files")
 		("password-file", po::value<std::string>(), "File to load password from")
 		("gog,g", "Extract additional archives from GOG.com installers")
 		("no-gog-galaxy", "Don't re-assemble GOG Galaxy file parts")
 		("no-extract-unknown,n", "Don't extract unknown Inno Setup versions")
+		("shard", po::value<std::string>(), "Only process part i of N of the data (\"i/N\")")
+		("from-plan", po::value<std::string>(), "Process the files listed in a plan")
+		("store", po::value<std::string>(), "Share file contents with other installers in this directory")
+		("store-links", "Hard-link files to the store instead of copying them")
 	;
 	
 	po::options_description filter("Filters");
@@ -181,6 +199,9 @@ int main(int argc, char * argv[]) {
 		("no-warn-unused", "Don't warn on unused .bin files")
 		("color,c", po::value<bool>()->implicit_value(true), "Enable/disable color output")
 		("progress,p", po::value<bool>()->implicit_value(true), "Enable/disable the progress bar")
+		("stats", "Print timing and throughput statistics")
+		("stats-format", po::value<std::string>(), "Statistics format: \"text\" or \"json\"")
+		("trace", po::value<std::string>(), "Write a Chrome trace of the extraction to this file")
 		#ifdef DEBUG
 		("debug", "Output debug information")
 		#endif
@@ -216,8 +237,45 @@ int main(int argc, char * argv[]) {
 	
 	::extract_options o;
 	
+	// Output format, an archive written to stdout replaces all other output.
+	{
+		po::variables_map::const_iterator i = options.find("output-format");
+		if(i != options.end()) {
+			std::string format = i->second.as<std::string>();
+			if(format == "files") {
+				o.output_format = DirectoryOutput;
+			} else if(format == "tar") {
+				o.output_format = TarOutput;
+			} else {
+				color::init(color::disable, color::disable);
+				log_error << "Unsupported --output-format value: " << format;
+				return ExitUserError;
+			}
+		}
+	}
+	{
+		po::variables_map::const_iterator i = options.find("output-file");
+		if(i != options.end()) {
+			o.output_file = i->second.as<std::string>();
+		}
+	}
+	bool archive_to_stdout = (o.output_format == TarOutput && o.output_file == "-");
+	{
+		po::variables_map::const_iterator i = options.find("plan");
+		if(i != options.end()) {
+			o.plan_file = i->second.as<std::string>();
+		}
+	}
+	{
+		po::variables_map::const_iterator i = options.find("from-plan");
+		if(i != options.end()) {
+			o.from_plan = i->second.as<std::string>();
+		}
+	}
+	bool plan_to_stdout = (o.plan_file == "-");
+	
 	// Verbosity settings.
-	o.silent = (options.count("silent") != 0);
+	o.silent = archive_to_stdout || plan_to_stdout || (options.count("silent") != 0);
 	o.quiet = o.silent || options.count("quiet");
 	logger::quiet = o.quiet;
 #ifdef DEBUG
@@ -278,9 +336,19 @@ int main(int argc, char * argv[]) {
 		o.gog_game_id = true;
 		o.show_password = true;
 	}
+	bool diff = (options.count("diff") != 0);
 	bool explicit_action = o.list || o.test || o.extract || o.list_languages
 	                       || o.gog_game_id || o.show_password || o.check_password
-	                       || o.list_components;
+	                       || o.list_components || !o.plan_file.empty() || diff;
+	if(!o.plan_file.empty() && (o.list || o.test || o.extract || o.crack)) {
+		log_error << "Combining --plan with --list, --test or --extract is not allowed";
+		return ExitUserError;
+	}
+	if(diff && (o.list || o.test || o.extract || o.crack || o.list_languages || o.list_components
+	            || o.gog_game_id || o.show_password || o.check_password)) {
+		log_error << "Combining --diff with other actions except --plan is not allowed";
+		return ExitUserError;
+	}
 	if(!explicit_action) {
 		o.extract = true;
 	}
@@ -374,6 +442,16 @@ int main(int argc, char * argv[]) {
 		}
 	}
 	
+	if(options.count("scan") != 0) {
+		if(explicit_action || options.count("data-version") != 0 || options.count("setup-files") != 0) {
+			log_error << "Combining --scan with other actions or setup files is not allowed";
+			return ExitUserError;
+		}
+		const std::vector<std::string> & dirs = options["scan"].as< std::vector<std::string> >();
+		scan_directories(std::vector<fs::path>(dirs.begin(), dirs.end()));
+		return logger::total_errors == 0 ? ExitSuccess : ExitDataError;
+	}
+	
 	if(options.count("setup-files") == 0) {
 		if(!o.silent) {
 			std::cout << get_command(argv[0]) << ": no input files specified\n";
@@ -395,6 +473,77 @@ int main(int argc, char * argv[]) {
 			o.output_dir = i->second.as<std::string>();
 		}
 	}
+	{
+		po::variables_map::const_iterator i = options.find("output-buffer");
+		if(i != options.end()) {
+			boost::uint64_t size;
+			if(!parse_bytes(i->second.as<std::string>(), size) || size == 0
+			   || size > boost::uint64_t(std::numeric_limits<size_t>::max() / 2)) {
+				log_error << "Invalid --output-buffer size: " << i->second.as<std::string>();
+				return ExitUserError;
+			}
+			o.output_buffer_size = size_t(size);
+		}
+	}
+	{
+		po::variables_map::const_iterator i = options.find("output-batch");
+		if(i != options.end()) {
+			o.output_batch = i->second.as<size_t>();
+			if(o.output_batch > util::output_batch::max_window) {
+				log_error << "Invalid --output-batch count: " << o.output_batch
+				          << " (maximum is " << util::output_batch::max_window << ')';
+				return ExitUserError;
+			}
+		}
+	}
+	{
+		po::variables_map::const_iterator i = options.find("output-cache");
+		if(i != options.end()) {
+			std::string mode = i->second.as<std::string>();
+			if(mode == "keep") {
+				o.output_cache = util::KeepCache;
+			} else if(mode == "drop") {
+				o.output_cache = util::DropCache;
+			} else if(mode == "direct") {
+				o.output_cache = util::DirectIO;
+			} else {
+				log_error << "Unsupported --output-cache value: " << mode;
+				return ExitUserError;
+			}
+		}
+	}
+	
+	{
+		po::variables_map::const_iterator i = options.find("shard");
+		if(i != options.end()) {
+			const std::string & value = i->second.as<std::string>();
+			std::istringstream iss(value);
+			char slash = 0;
+			if(!(iss >> o.shard >> slash >> o.shard_count) || slash != '/' || !(iss >> std::ws).eof()
+			   || o.shard == 0 || o.shard > o.shard_count) {
+				log_error << "Invalid --shard value: " << value;
+				return ExitUserError;
+			}
+			o.shard--;
+		}
+	}
+	{
+		if(options.count("stats")) {
+			o.stats = TextStats;
+		}
+		po::variables_map::const_iterator i = options.find("stats-format");
+		if(i != options.end()) {
+			std::string format = i->second.as<std::string>();
+			if(format == "text") {
+				o.stats = TextStats;
+			} else if(format == "json") {
+				o.stats = JsonStats;
+			} else {
+				log_error << "Unsupported --stats-format value: " << format;
+				return ExitUserError;
+			}
+		}
+	}
 	
 	{
 		po::variables_map::const_iterator password = options.find("password");
@@ -439,6 +588,56 @@ int main(int argc, char * argv[]) {
 	o.gog = (options.count("gog") != 0);
 	o.gog_galaxy = (options.count("no-gog-galaxy") == 0);
 	
+	if(o.output_format == TarOutput && o.extract) {
+		if(o.gog || o.iss_file || o.compiledcode) {
+			log_error << "Combining --output-format tar with --gog, --iss-file or --compiledcode is not allowed";
+			return ExitUserError;
+		}
+		if(archive_to_stdout && explicit_list) {
+			log_error << "Combining --list with an archive written to stdout is not allowed";
+			return ExitUserError;
+		}
+		if(options["setup-files"].as< std::vector<std::string> >().size() > 1) {
+			log_error << "Only one installer can be extracted into a tar archive";
+			return ExitUserError;
+		}
+	} else if(options.count("output-file") != 0) {
+		log_warning << "--output-file is only used when extracting with --output-format tar";
+	}
+	{
+		po::variables_map::const_iterator i = options.find("store");
+		if(i != options.end()) {
+			if(o.output_format == TarOutput) {
+				log_error << "Combining --store with --output-format tar is not allowed";
+				return ExitUserError;
+			}
+			if(!o.extract) {
+				log_warning << "--store is only used when extracting files";
+			}
+			o.store = i->second.as<std::string>();
+		}
+		o.store_links = (options.count("store-links") != 0);
+		if(o.store_links && o.store.empty()) {
+			log_warning << "--store-links is only used with --store";
+		}
+	}
+	
+	if(diff) {
+		if(options["setup-files"].as< std::vector<std::string> >().size() != 2) {
+			log_error << "--diff needs exactly two installers";
+			return ExitUserError;
+		}
+		if(!o.from_plan.empty()) {
+			log_error << "Combining --diff with --from-plan is not allowed";
+			return ExitUserError;
+		}
+	} else if(!o.plan_file.empty() || !o.from_plan.empty()) {
+		if(options["setup-files"].as< std::vector<std::string> >().size() > 1) {
+			log_error << "Only one installer can be used with --plan or --from-plan";
+			return ExitUserError;
+		}
+	}
+	
 	o.data_version = (options.count("data-version") != 0);
 	if(o.data_version) {
 		logger::quiet = true;
@@ -463,12 +662,24 @@ int main(int argc, char * argv[]) {
 	const std::vector<std::string> & files = options["setup-files"]
 	                                         .as< std::vector<std::string> >();
 	
+	{
+		po::variables_map::const_iterator i = options.find("trace");
+		if(i != options.end() && !util::trace::open(i->second.as<std::string>())) {
+			log_error << "Could not open trace file \"" << i->second.as<std::string>() << '"';
+			return ExitUserError;
+		}
+	}
+	
 	bool suggest_bug_report = false;
 	try {
-		for(const std::string & file : files) {
-			process_file(file, o);
-			if(!o.data_version && files.size() > 1) {
-				std::cout << '\n';
+		if(diff) {
+			diff_installers(files[0], files[1], o);
+		} else {
+			for(const std::string & file : files) {
+				process_file(file, o);
+				if(!o.data_version && files.size() > 1) {
+					std::cout << '\n';
+				}
 			}
 		}
 	} catch(const std::ios_base::failure & e) {
@@ -484,6 +695,8 @@ int main(int argc, char * argv[]) {
 		log_error << "Not a supported Inno Setup installer!";
 	}
 	
+	util::trace::close();
+	
 	if(suggest_bug_report) {
 		std::cerr << color::blue << "If you are sure the setup file is not corrupted,"
 		          << " consider \nfiling a bug report at "
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "cli/scan.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <boost/system/error_code.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "loader/offsets.hpp"
+#include "setup/version.hpp"
+#include "stream/slice.hpp"
+#include "util/boostfs_compat.hpp"
+#include "util/fstream.hpp"
+#include "util/log.hpp"
+#include "util/output.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+//! Smaller than the default stream buffer - only a few small reads are needed per file.
+const size_t scan_buffer_size = 4096;
+
+bool is_file(const fs::path & file) {
+	boost::system::error_code ec;
+	return fs::is_regular_file(file, ec);
+}
+
+/*!
+ * Count the external slice files next to an installer.
+ *
+ * The slice naming scheme is not known without loading the headers, so both
+ * \c $base-$disk.bin and \c $base-$disk$letter.bin are tried.
+ *
+ * \param slices_per_disk Receives the number of slices in the first disk.
+ */
+size_t count_slices(const fs::path & dir, const std::string & basename, size_t & slices_per_disk) {
+	
+	size_t count = 0;
+	while(is_file(dir / stream::slice_reader::slice_filename(basename, count))) {
+		count++;
+	}
+	if(count != 0) {
+		slices_per_disk = 1;
+		return count;
+	}
+	
+	slices_per_disk = 0;
+	while(slices_per_disk < 26 && is_file(dir / stream::slice_reader::slice_filename(basename, slices_per_disk, 26))) {
+		slices_per_disk++;
+	}
+	if(slices_per_disk != 0) {
+		while(is_file(dir / stream::slice_reader::slice_filename(basename, count, slices_per_disk))) {
+			count++;
+		}
+	}
+	
+	return count;
+}
+
+/*!
+ * Probe a single file.
+ *
+ * \return \c false if the file is not an Inno Setup installer.
+ */
+bool scan_file(const fs::path & file, std::string & result) {
+	
+	std::vector<char> buffer(scan_buffer_size);
+	util::ifstream ifs;
+	ifs.rdbuf()->pubsetbuf(&buffer.front(), std::streamsize(buffer.size()));
+	try {
+		ifs.open(file, std::ios_base::in | std::ios_base::binary);
+	} catch(...) {
+		return false;
+	}
+	if(!ifs.is_open()) {
+		return false;
+	}
+	
+	loader::offsets offsets;
+	offsets.load(ifs);
+	
+	setup::version version;
+	bool valid = true;
+	try {
+		ifs.seekg(offsets.header_offset);
+		version.load(ifs);
+		valid = !ifs.fail();
+	} catch(const setup::version_error &) {
+		valid = false;
+	}
+	if(!valid && !offsets.found_magic) {
+		return false;
+	}
+	
+	std::ostringstream oss;
+	oss << "{\"path\":" << json_string(file.string());
+	
+	if(valid) {
+		std::ostringstream name;
+		name << version;
+		oss << ",\"version\":" << json_string(name.str());
+		oss << ",\"known\":" << (version.known ? "true" : "false");
+	} else {
+		oss << ",\"version\":null";
+	}
+	
+	oss << ",\"loader\":" << (offsets.found_magic ? "true" : "false");
+	oss << ",\"exe_offset\":" << offsets.exe_offset;
+	oss << ",\"header_offset\":" << offsets.header_offset;
+	oss << ",\"data_offset\":" << offsets.data_offset;
+	
+	if(offsets.data_offset != 0) {
+		oss << ",\"data\":\"embedded\"";
+	} else {
+		size_t slices_per_disk = 0;
+		std::string basename = util::as_string(file.stem());
+		if(!offsets.found_magic && basename.length() > 2
+		   && basename.compare(basename.length() - 2, 2, "-0") == 0) {
+			// Headers in a separate setup-0.bin file
+			basename.resize(basename.length() - 2);
+		}
+		size_t slices = count_slices(file.parent_path(), basename, slices_per_disk);
+		oss << ",\"data\":\"external\",\"slices\":" << slices;
+		if(slices != 0) {
+			oss << ",\"slices_per_disk\":" << slices_per_disk;
+		}
+	}
+	
+	oss << "}\n";
+	
+	result = oss.str();
+	
+	return true;
+}
+
+/*!
+ * Work shared by the scanning threads.
+ *
+ * Directories are listed by the same threads that probe files. Entries are processed
+ * last in, first out to keep the number of queued paths small.
+ */
+class scanner {
+	
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector<fs::path> pending;
+	size_t busy; //!< Threads currently processing a path
+	
+	std::mutex output_mutex;
+	size_t found;
+	
+	void list(const fs::path & dir, std::vector<fs::path> & entries) {
+		
+		boost::system::error_code ec;
+		fs::directory_iterator end;
+		fs::directory_iterator i(dir, ec);
+		for(; !ec && i != end; i.increment(ec)) {
+			entries.push_back(i->path());
+		}
+		
+		if(ec) {
+			log_warning << "Could not list " << dir << ": " << ec.message();
+		}
+	}
+	
+	void process(const fs::path & path, std::vector<fs::path> & entries) {
+		
+		boost::system::error_code ec;
+		fs::file_status status = fs::symlink_status(path, ec);
+		if(ec) {
+			return;
+		}
+		
+		if(fs::is_symlink(status)) {
+			// Don't follow links to directories to avoid loops
+			status = fs::status(path, ec);
+			if(ec || fs::is_directory(status)) {
+				return;
+			}
+		}
+		
+		if(fs::is_directory(status)) {
+			list(path, entries);
+		} else if(fs::is_regular_file(status)) {
+			std::string line;
+			if(scan_file(path, line)) {
+				std::lock_guard<std::mutex> lock(output_mutex);
+				std::cout << line;
+				found++;
+			}
+		}
+	}
+	
+	void run() {
+		
+		std::vector<fs::path> entries;
+		
+		std::unique_lock<std::mutex> lock(mutex);
+		
+		for(;;) {
+			
+			while(pending.empty() && busy != 0) {
+				condition.wait(lock);
+			}
+			if(pending.empty()) {
+				// No work left and no thread that could add more
+				condition.notify_all();
+				return;
+			}
+			
+			fs::path path = pending.back();
+			pending.pop_back();
+			busy++;
+			lock.unlock();
+			
+			entries.clear();
+			process(path, entries);
+			
+			lock.lock();
+			busy--;
+			pending.insert(pending.end(), entries.rbegin(), entries.rend());
+			condition.notify_all();
+		}
+	}
+	
+public:
+	
+	scanner() : busy(0), found(0) { }
+	
+	size_t scan(const std::vector<fs::path> & roots) {
+		
+		pending.assign(roots.rbegin(), roots.rend());
+		
+		// Mostly waiting for the file system, so use more threads than cores
+		size_t count = std::max(size_t(std::thread::hardware_concurrency()) * 2, size_t(4));
+		
+		std::vector<std::thread> threads;
+		for(size_t i = 0; i < count; i++) {
+			threads.push_back(std::thread(&scanner::run, this));
+		}
+		for(std::thread & thread : threads) {
+			thread.join();
+		}
+		
+		std::cout.flush();
+		
+		return found;
+	}
+	
+};
+
+} // anonymous namespace
+
+size_t scan_directories(const std::vector<fs::path> & roots) {
+	scanner s;
+	return s.scan(roots);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Bulk detection of Inno Setup installers in directory trees.
+ */
+#ifndef INNOEXTRACT_CLI_SCAN_HPP
+#define INNOEXTRACT_CLI_SCAN_HPP
+
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+/*!
+ * Find Inno Setup installers in directory trees and print one JSON object per line.
+ *
+ * Directories are listed and files are probed by several threads. Only the loader
+ * offsets and the setup data version are read from each file.
+ *
+ * \param roots Directories (or individual files) to scan.
+ *
+ * \return the number of installers found.
+ */
+size_t scan_directories(const std::vector<boost::filesystem::path> & roots);
+
+#endif // INNOEXTRACT_CLI_SCAN_HPP
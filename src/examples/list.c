@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Example for the libinnoextract C interface: list the files in an installer and verify
+ * their checksums.
+ *
+ * Usage: innoextract-example-list <setup.exe> [password]
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "lib/innoextract.h"
+
+struct totals {
+	uint64_t bytes;
+	size_t valid;
+	size_t corrupted;
+};
+
+static int begin_file(void * user, size_t file) {
+	(void)user, (void)file;
+	return 1; /* Extract every file */
+}
+
+static int write_data(void * user, size_t file, const char * data, size_t size) {
+	struct totals * totals = (struct totals *)user;
+	(void)file, (void)data;
+	totals->bytes += size;
+	return 0;
+}
+
+static int end_file(void * user, size_t file, int status) {
+	struct totals * totals = (struct totals *)user;
+	(void)file;
+	if(status == INNOEXTRACT_OK) {
+		totals->valid++;
+	} else {
+		totals->corrupted++;
+	}
+	return 0;
+}
+
+int main(int argc, char * argv[]) {
+	
+	innoextract_installer * installer;
+	innoextract_callbacks callbacks;
+	struct totals totals = { 0, 0, 0 };
+	size_t count, i;
+	
+	if(argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s <setup.exe> [password]\n", argv[0]);
+		return 1;
+	}
+	
+	installer = innoextract_open(argv[1], argc > 2 ? argv[2] : NULL);
+	if(!installer) {
+		fprintf(stderr, "Could not open %s: %s\n", argv[1], innoextract_last_error());
+		return 1;
+	}
+	
+	printf("Inno Setup %s\n", innoextract_setup_version(installer));
+	
+	count = innoextract_file_count(installer);
+	for(i = 0; i < count; i++) {
+		innoextract_file file;
+		if(innoextract_get_file(installer, i, &file) != INNOEXTRACT_OK) {
+			fprintf(stderr, "%s\n", innoextract_last_error());
+			innoextract_close(installer);
+			return 1;
+		}
+		printf("%s (%" PRIu64 " bytes)%s\n", file.path, file.size, file.locked ? " [encrypted]" : "");
+	}
+	
+	callbacks.begin = begin_file;
+	callbacks.write = write_data;
+	callbacks.end = end_file;
+	if(innoextract_extract_all(installer, &callbacks, &totals) != INNOEXTRACT_OK) {
+		fprintf(stderr, "Extraction failed: %s\n", innoextract_last_error());
+		innoextract_close(installer);
+		return 1;
+	}
+	
+	printf("%lu files verified, %lu corrupted, %" PRIu64 " bytes\n",
+	       (unsigned long)totals.valid, (unsigned long)totals.corrupted, totals.bytes);
+	
+	innoextract_close(installer);
+	
+	return totals.corrupted == 0 ? 0 : 1;
+}
@@ -0,0 +1,485 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Read-only FUSE filesystem exposing the files stored in an installer.
+ */
+
+#define FUSE_USE_VERSION 31
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <fuse.h>
+
+#include <ctime>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "fusefs/reader.hpp"
+#include "lib/installer.hpp"
+#include "setup/data.hpp"
+#include "setup/directory.hpp"
+#include "setup/file.hpp"
+#include "setup/filename.hpp"
+#include "setup/version.hpp"
+#include "stream/slice.hpp"
+#include "util/fstream.hpp"
+#include "util/log.hpp"
+#include "util/output.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+const boost::uint64_t default_cache_size = boost::uint64_t(256) << 20;
+
+struct node {
+	
+	bool directory;
+	
+	size_t file; //!< Index in the installer's file list
+	
+	std::map<std::string, size_t> children; //!< Indices of child nodes
+	
+	node() : directory(true), file(0) { }
+	
+};
+
+//! A part of a file's contents stored in a single data entry.
+struct part {
+	
+	boost::uint64_t start;
+	size_t location;
+	
+	part(boost::uint64_t offset, size_t index) : start(offset), location(index) { }
+	
+};
+
+class filesystem {
+	
+	std::vector<node> nodes_;
+	std::vector< std::vector<part> > parts_;
+	
+	::timespec mtime_; //!< Timestamp for directories
+	
+	size_t create(const std::string & path, bool directory);
+	
+public:
+	
+	innoextract::installer installer;
+	
+	util::ifstream ifs;
+	boost::scoped_ptr<stream::slice_reader> slices;
+	boost::scoped_ptr<fusefs::data_reader> reader;
+	std::mutex lock;
+	
+	explicit filesystem(const fs::path & file);
+	
+	//! \return the node index for a path or \c size_t(-1) if it does not exist.
+	size_t lookup(const char * path) const;
+	
+	const node & get(size_t index) const { return nodes_[index]; }
+	
+	void stat(size_t index, struct stat * st) const;
+	
+	size_t read(size_t file, boost::uint64_t offset, char * buffer, size_t size);
+	
+};
+
+filesystem::filesystem(const fs::path & file) : installer(file) {
+	
+	nodes_.push_back(node());
+	
+	::memset(&mtime_, 0, sizeof(mtime_));
+	mtime_.tv_sec = std::time_t(fs::last_write_time(file));
+	
+	setup::filename_map filenames;
+	filenames.set_expand(true);
+	for(const setup::directory_entry & directory : installer.info().directories) {
+		create(filenames.convert(directory.name), true);
+	}
+	
+	parts_.resize(installer.file_count());
+	for(size_t i = 0; i < installer.file_count(); i++) {
+		
+		size_t index = create(installer.path(i), false);
+		if(index == size_t(-1)) {
+			log_warning << "Ignoring duplicate file " << installer.path(i);
+			continue;
+		}
+		nodes_[index].file = i;
+		
+		const setup::file_entry & entry = installer.entry(i);
+		boost::uint64_t offset = 0;
+		parts_[i].push_back(part(offset, entry.location));
+		for(boost::uint32_t location : entry.additional_locations) {
+			offset += installer.info().data_entries[parts_[i].back().location].uncompressed_size;
+			parts_[i].push_back(part(offset, location));
+		}
+		
+	}
+	
+}
+
+size_t filesystem::create(const std::string & path, bool directory) {
+	
+	size_t current = 0;
+	
+	size_t start = 0;
+	while(start < path.size()) {
+		
+		size_t end = path.find('/', start);
+		if(end == std::string::npos) {
+			end = path.size();
+		}
+		std::string name = path.substr(start, end - start);
+		start = end + 1;
+		if(name.empty()) {
+			continue;
+		}
+		
+		bool last = (start >= path.size());
+		
+		std::map<std::string, size_t>::const_iterator it = nodes_[current].children.find(name);
+		if(it != nodes_[current].children.end()) {
+			current = it->second;
+			if(!nodes_[current].directory || (last && !directory)) {
+				return size_t(-1);
+			}
+			continue;
+		}
+		
+		size_t index = nodes_.size();
+		nodes_.push_back(node());
+		nodes_[index].directory = !last || directory;
+		nodes_[current].children[name] = index;
+		current = index;
+		
+	}
+	
+	return current;
+}
+
+size_t filesystem::lookup(const char * path) const {
+	
+	size_t current = 0;
+	
+	std::string remaining = path;
+	size_t start = 0;
+	while(start < remaining.size()) {
+		size_t end = remaining.find('/', start);
+		if(end == std::string::npos) {
+			end = remaining.size();
+		}
+		if(end != start) {
+			std::map<std::string, size_t>::const_iterator it
+				= nodes_[current].children.find(remaining.substr(start, end - start));
+			if(it == nodes_[current].children.end()) {
+				return size_t(-1);
+			}
+			current = it->second;
+		}
+		start = end + 1;
+	}
+	
+	return current;
+}
+
+void filesystem::stat(size_t index, struct stat * st) const {
+	
+	::memset(st, 0, sizeof(*st));
+	
+	const node & n = nodes_[index];
+	if(n.directory) {
+		st->st_mode = S_IFDIR | 0555;
+		st->st_nlink = 2;
+		st->st_mtim = mtime_;
+	} else {
+		st->st_mode = S_IFREG | 0444;
+		st->st_nlink = 1;
+		st->st_size = off_t(installer.size(n.file));
+		const setup::data_entry & data = installer.data(n.file);
+		st->st_mtim.tv_sec = std::time_t(data.timestamp);
+		st->st_mtim.tv_nsec = long(data.timestamp_nsec);
+	}
+	st->st_ctim = st->st_mtim;
+	st->st_atim = st->st_mtim;
+	
+}
+
+size_t filesystem::read(size_t file, boost::uint64_t offset, char * buffer, size_t size) {
+	
+	const std::vector<part> & parts = parts_[file];
+	
+	size_t total = 0;
+	for(size_t i = 0; i < parts.size() && total < size; i++) {
+		
+		boost::uint64_t end = (i + 1 < parts.size()) ? parts[i + 1].start : boost::uint64_t(-1);
+		if(offset >= end) {
+			continue;
+		}
+		
+		size_t n = reader->read(parts[i].location, offset - parts[i].start, buffer + total, size - total);
+		total += n;
+		offset += n;
+		
+		if(end != boost::uint64_t(-1) && offset < end) {
+			break; // Data entry shorter than expected
+		}
+		
+	}
+	
+	return total;
+}
+
+filesystem * get_filesystem() {
+	return static_cast<filesystem *>(fuse_get_context()->private_data);
+}
+
+int fs_getattr(const char * path, struct stat * st, struct fuse_file_info * /* fi */) {
+	
+	filesystem * self = get_filesystem();
+	
+	size_t index = self->lookup(path);
+	if(index == size_t(-1)) {
+		return -ENOENT;
+	}
+	
+	self->stat(index, st);
+	
+	return 0;
+}
+
+int fs_readdir(const char * path, void * buffer, fuse_fill_dir_t filler, off_t /* offset */,
+               struct fuse_file_info * /* fi */, enum fuse_readdir_flags /* flags */) {
+	
+	filesystem * self = get_filesystem();
+	
+	size_t index = self->lookup(path);
+	if(index == size_t(-1)) {
+		return -ENOENT;
+	}
+	const node & directory = self->get(index);
+	if(!directory.directory) {
+		return -ENOTDIR;
+	}
+	
+	filler(buffer, ".", NULL, 0, fuse_fill_dir_flags(0));
+	filler(buffer, "..", NULL, 0, fuse_fill_dir_flags(0));
+	for(const std::map<std::string, size_t>::value_type & child : directory.children) {
+		struct stat st;
+		self->stat(child.second, &st);
+		if(filler(buffer, child.first.c_str(), &st, 0, fuse_fill_dir_flags(0))) {
+			break;
+		}
+	}
+	
+	return 0;
+}
+
+int fs_open(const char * path, struct fuse_file_info * fi) {
+	
+	filesystem * self = get_filesystem();
+	
+	size_t index = self->lookup(path);
+	if(index == size_t(-1)) {
+		return -ENOENT;
+	}
+	const node & file = self->get(index);
+	if(file.directory) {
+		return -EISDIR;
+	}
+	if((fi->flags & O_ACCMODE) != O_RDONLY) {
+		return -EROFS;
+	}
+	if(self->installer.is_locked(file.file)) {
+		return -EACCES;
+	}
+	
+	fi->fh = file.file;
+	fi->keep_cache = 1;
+	
+	return 0;
+}
+
+int fs_read(const char * /* path */, char * buffer, size_t size, off_t offset,
+            struct fuse_file_info * fi) {
+	
+	filesystem * self = get_filesystem();
+	
+	if(offset < 0) {
+		return -EINVAL;
+	}
+	
+	try {
+		std::lock_guard<std::mutex> guard(self->lock);
+		return int(self->read(size_t(fi->fh), boost::uint64_t(offset), buffer, size));
+	} catch(const std::exception & e) {
+		log_error << "Error reading " << self->installer.path(size_t(fi->fh)) << ": " << e.what();
+		return -EIO;
+	}
+	
+}
+
+void * fs_init(struct fuse_conn_info * /* conn */, struct fuse_config * cfg) {
+	cfg->kernel_cache = 1;
+	return get_filesystem();
+}
+
+struct options {
+	
+	char * cache_size;
+	char * password;
+	char * installer;
+	int help;
+	
+};
+
+enum option_key {
+	KeyHelp
+};
+
+const struct fuse_opt option_spec[] = {
+	{ "--cache-size=%s", offsetof(options, cache_size), 0 },
+	{ "--password=%s", offsetof(options, password), 0 },
+	FUSE_OPT_KEY("-h", KeyHelp),
+	FUSE_OPT_KEY("--help", KeyHelp),
+	FUSE_OPT_END
+};
+
+int process_option(void * data, const char * arg, int key, struct fuse_args * /* outargs */) {
+	
+	options * o = static_cast<options *>(data);
+	
+	if(key == KeyHelp) {
+		o->help = 1;
+		return 1; // Also show FUSE options
+	}
+	
+	if(key == FUSE_OPT_KEY_NONOPT && !o->installer) {
+		o->installer = ::strdup(arg);
+		return 0;
+	}
+	
+	return 1;
+}
+
+void print_help(const char * command) {
+	std::cout << "Usage: " << command << " [options] <installer> <mountpoint>\n\n";
+	std::cout << "Mount the files stored in an Inno Setup installer as a read-only filesystem.\n\n";
+	std::cout << "Options:\n";
+	std::cout << "    --cache-size=SIZE      Memory for decompressed data (default: 256M)\n";
+	std::cout << "    --password=PASSWORD    Password for encrypted files\n\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char * argv[]) {
+	
+	struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
+	
+	options o;
+	o.cache_size = NULL;
+	o.password = NULL;
+	o.installer = NULL;
+	o.help = 0;
+	
+	if(fuse_opt_parse(&args, &o, option_spec, process_option) != 0) {
+		return 1;
+	}
+	
+	fs::path installer;
+	if(o.installer) {
+		installer = o.installer;
+		::free(o.installer);
+	}
+	
+	struct fuse_operations operations;
+	::memset(&operations, 0, sizeof(operations));
+	operations.init = fs_init;
+	operations.getattr = fs_getattr;
+	operations.readdir = fs_readdir;
+	operations.open = fs_open;
+	operations.read = fs_read;
+	
+	if(o.help) {
+		print_help(argv[0]);
+		int ret = fuse_main(args.argc, args.argv, &operations, NULL);
+		fuse_opt_free_args(&args);
+		return ret;
+	}
+	
+	if(installer.empty()) {
+		print_help(argv[0]);
+		fuse_opt_free_args(&args);
+		return 1;
+	}
+	
+	boost::uint64_t cache_size = default_cache_size;
+	if(o.cache_size && !parse_bytes(o.cache_size, cache_size)) {
+		log_error << "Invalid --cache-size: " << o.cache_size;
+		fuse_opt_free_args(&args);
+		return 1;
+	}
+	
+	boost::scoped_ptr<filesystem> self;
+	try {
+		self.reset(new filesystem(installer));
+		if(o.password && !self->installer.set_password(o.password)) {
+			log_error << "Incorrect password provided";
+			fuse_opt_free_args(&args);
+			return 1;
+		}
+		self->ifs.open(installer, std::ios_base::in | std::ios_base::binary);
+		self->slices.reset(innoextract::open_slices(installer, &self->ifs, self->installer.offsets(),
+		                                            self->installer.info()));
+		self->reader.reset(new fusefs::data_reader(self->installer.info(), *self->slices,
+		                                           self->installer.key(), cache_size));
+	} catch(const setup::version_error &) {
+		log_error << "Not a supported Inno Setup installer!";
+		fuse_opt_free_args(&args);
+		return 1;
+	} catch(const std::exception & e) {
+		log_error << e.what();
+		fuse_opt_free_args(&args);
+		return 1;
+	}
+	
+	int ret = fuse_main(args.argc, args.argv, &operations, self.get());
+	
+	fuse_opt_free_args(&args);
+	
+	return ret;
+}
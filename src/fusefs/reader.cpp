@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "fusefs/reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto/checksum.hpp"
+#include "setup/data.hpp"
+#include "setup/info.hpp"
+#include "stream/slice.hpp"
+#include "util/load.hpp"
+#include "util/log.hpp"
+
+namespace fusefs {
+
+namespace {
+
+struct chunk_offset_less {
+	
+	const setup::info & info;
+	
+	explicit chunk_offset_less(const setup::info & i) : info(i) { }
+	
+	bool operator()(size_t a, size_t b) const {
+		return info.data_entries[a].file.offset < info.data_entries[b].file.offset;
+	}
+	
+};
+
+} // anonymous namespace
+
+data_reader::data_reader(const setup::info & info, stream::slice_reader & slices,
+                         const std::string & key, boost::uint64_t cache_size)
+	: info_(info), slices_(slices), key_(key)
+	, cache_size_(cache_size), cached_(0)
+	, chunk_offset_(0)
+	, location_(size_t(-1)), file_offset_(0)
+{
+	
+	for(size_t i = 0; i < info_.data_entries.size(); i++) {
+		chunks_[info_.data_entries[i].chunk].push_back(i);
+	}
+	
+	for(chunk_map::value_type & chunk : chunks_) {
+		std::stable_sort(chunk.second.begin(), chunk.second.end(), chunk_offset_less(info_));
+	}
+	
+}
+
+data_reader::~data_reader() {
+	// The file reader references the chunk reader
+	file_source_.reset();
+	chunk_source_.reset();
+}
+
+bool data_reader::is_cacheable(const setup::data_entry & data) const {
+	return data.uncompressed_size <= cache_size_ / 4;
+}
+
+void data_reader::seek(size_t location) {
+	
+	const setup::data_entry & data = info_.data_entries[location];
+	
+	if(file_source_) {
+		bool done = (file_offset_ == info_.data_entries[location_].uncompressed_size);
+		file_source_.reset();
+		location_ = size_t(-1);
+		if(!done) {
+			// Position inside the chunk is unknown
+			chunk_source_.reset();
+		}
+	}
+	
+	if(!chunk_source_ || !(chunk_ == data.chunk) || chunk_offset_ > data.file.offset) {
+		chunk_source_.reset();
+		chunk_source_ = stream::chunk_reader::get(slices_, data.chunk, key_);
+		chunk_ = data.chunk;
+		chunk_offset_ = 0;
+	}
+	
+	// Data entries before the requested one need to be decompressed anyway
+	for(size_t other : chunks_[data.chunk]) {
+		const setup::data_entry & entry = info_.data_entries[other];
+		if(entry.file.offset < chunk_offset_) {
+			continue;
+		}
+		if(entry.file.offset >= data.file.offset) {
+			break;
+		}
+		if(is_cacheable(entry) && cache_.find(other) == cache_.end()) {
+			util::discard(*chunk_source_, entry.file.offset - chunk_offset_);
+			chunk_offset_ = entry.file.offset;
+			decode(other);
+		}
+	}
+	
+	util::discard(*chunk_source_, data.file.offset - chunk_offset_);
+	chunk_offset_ = data.file.offset;
+	
+}
+
+void data_reader::decode(size_t location) {
+	
+	const setup::data_entry & data = info_.data_entries[location];
+	
+	crypto::checksum checksum;
+	stream::file_reader::pointer source = stream::file_reader::get(*chunk_source_, data.file, &checksum);
+	
+	std::vector<char> buffer(size_t(data.uncompressed_size));
+	source->read(buffer.data(), std::streamsize(buffer.size()));
+	buffer.resize(size_t(source->gcount()));
+	while(!source->eof()) {
+		// Read to the end to finalize the checksum
+		char extra[1024];
+		std::streamsize n = source->read(extra, std::streamsize(sizeof(extra))).gcount();
+		buffer.insert(buffer.end(), extra, extra + n);
+	}
+	source.reset();
+	chunk_offset_ = data.file.offset + data.file.size;
+	
+	if(checksum != data.file.checksum || buffer.size() != data.uncompressed_size) {
+		log_warning << "Checksum mismatch for data entry " << location;
+	}
+	
+	insert(location, buffer);
+	
+}
+
+void data_reader::insert(size_t location, std::vector<char> & data) {
+	
+	while(cached_ + data.size() > cache_size_ && !lru_.empty()) {
+		cache_map::iterator it = cache_.find(lru_.back());
+		cached_ -= it->second.data.size();
+		cache_.erase(it);
+		lru_.pop_back();
+	}
+	
+	cache_entry & entry = cache_[location];
+	entry.data.swap(data);
+	lru_.push_front(location);
+	entry.lru = lru_.begin();
+	cached_ += entry.data.size();
+	
+}
+
+size_t data_reader::read_stream(boost::uint64_t offset, char * buffer, size_t size) {
+	
+	if(offset > file_offset_) {
+		util::discard(*file_source_, offset - file_offset_);
+		file_offset_ = offset;
+	}
+	
+	file_source_->read(buffer, std::streamsize(size));
+	size_t n = size_t(file_source_->gcount());
+	file_offset_ += n;
+	
+	return n;
+}
+
+size_t data_reader::read(size_t location, boost::uint64_t offset, char * buffer, size_t size) {
+	
+	const setup::data_entry & data = info_.data_entries[location];
+	if(offset >= data.uncompressed_size) {
+		return 0;
+	}
+	size = size_t(std::min(boost::uint64_t(size), data.uncompressed_size - offset));
+	
+	cache_map::iterator it = cache_.find(location);
+	if(it == cache_.end() && is_cacheable(data)) {
+		seek(location);
+		decode(location);
+		it = cache_.find(location);
+	}
+	if(it != cache_.end()) {
+		lru_.splice(lru_.begin(), lru_, it->second.lru);
+		if(offset >= it->second.data.size()) {
+			return 0;
+		}
+		size = size_t(std::min(boost::uint64_t(size), it->second.data.size() - offset));
+		std::memcpy(buffer, it->second.data.data() + offset, size);
+		return size;
+	}
+	
+	if(!file_source_ || location_ != location || file_offset_ > offset) {
+		seek(location);
+		file_source_ = stream::file_reader::get(*chunk_source_, data.file, NULL);
+		location_ = location;
+		file_offset_ = 0;
+		chunk_offset_ = data.file.offset + data.file.size;
+	}
+	
+	return read_stream(offset, buffer, size);
+}
+
+} // namespace fusefs
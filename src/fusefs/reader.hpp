@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Random access to file data stored in compressed chunks.
+ */
+#ifndef INNOEXTRACT_FUSEFS_READER_HPP
+#define INNOEXTRACT_FUSEFS_READER_HPP
+
+#include <stddef.h>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "stream/chunk.hpp"
+#include "stream/file.hpp"
+
+namespace setup { struct data_entry; struct info; }
+
+namespace fusefs {
+
+/*!
+ * Reads arbitrary ranges of data entries.
+ *
+ * Chunks can only be decompressed sequentially, so data entries that are small enough are
+ * decoded completely and kept in a LRU cache. Data entries that are passed while seeking
+ * to the requested data inside a solid chunk are cached as well.
+ *
+ * Larger entries are streamed: consecutive reads continue where the last read stopped,
+ * reading backwards requires decompressing the chunk again up to that point.
+ */
+class data_reader : private boost::noncopyable {
+	
+	const setup::info & info_;
+	stream::slice_reader & slices_;
+	std::string key_;
+	
+	typedef std::list<size_t> lru_list;
+	struct cache_entry {
+		std::vector<char> data;
+		lru_list::iterator lru;
+	};
+	typedef std::unordered_map<size_t, cache_entry> cache_map;
+	
+	boost::uint64_t cache_size_; //!< Maximum total size of cached data
+	boost::uint64_t cached_; //!< Current total size of cached data
+	cache_map cache_;
+	lru_list lru_; //!< Cached locations, most recently used first
+	
+	//! Data locations for each chunk, sorted by their offset in the chunk.
+	typedef std::map<stream::chunk, std::vector<size_t> > chunk_map;
+	chunk_map chunks_;
+	
+	//! Chunk that is currently being decompressed
+	stream::chunk chunk_;
+	stream::chunk_reader::pointer chunk_source_;
+	boost::uint64_t chunk_offset_; //!< Position in the decompressed chunk
+	
+	//! Data entry that is currently being streamed
+	size_t location_;
+	stream::file_reader::pointer file_source_;
+	boost::uint64_t file_offset_;
+	
+	bool is_cacheable(const setup::data_entry & data) const;
+	
+	void seek(size_t location);
+	
+	void decode(size_t location);
+	
+	void insert(size_t location, std::vector<char> & data);
+	
+	size_t read_stream(boost::uint64_t offset, char * buffer, size_t size);
+	
+public:
+	
+	/*!
+	 * \param info       Setup headers including the data entries.
+	 * \param slices     Reader for the installer's data slices.
+	 * \param key        Password for encrypted chunks.
+	 * \param cache_size Maximum amount of decompressed data to keep in memory.
+	 */
+	data_reader(const setup::info & info, stream::slice_reader & slices, const std::string & key,
+	            boost::uint64_t cache_size);
+	
+	~data_reader();
+	
+	/*!
+	 * Read data from a data entry.
+	 *
+	 * \param location Index of the data entry.
+	 * \param offset   Position in the decompressed data entry.
+	 *
+	 * \return the number of bytes read, which is less than \c size only at the end of the data.
+	 */
+	size_t read(size_t location, boost::uint64_t offset, char * buffer, size_t size);
+	
+	//! \return the total size of the currently cached data.
+	boost::uint64_t cached() const { return cached_; }
+	
+};
+
+} // namespace fusefs
+
+#endif // INNOEXTRACT_FUSEFS_READER_HPP
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "lib/innoextract.h"
+
+#include <exception>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "lib/installer.hpp"
+#include "setup/data.hpp"
+#include "setup/file.hpp"
+#include "setup/version.hpp"
+
+struct innoextract_installer {
+	
+	innoextract::installer installer;
+	std::string version;
+	
+	explicit innoextract_installer(const char * path) : installer(path) {
+		std::ostringstream oss;
+		oss << installer.info().version;
+		version = oss.str();
+	}
+	
+};
+
+namespace {
+
+thread_local std::string last_error;
+thread_local bool has_error = false;
+
+void set_error(const std::string & error) {
+	last_error = error;
+	has_error = true;
+}
+
+//! Thrown to stop extraction when a callback returns non-zero.
+struct aborted { };
+
+class callback_sink : public innoextract::sink {
+	
+	innoextract_write_fn write_;
+	void * user_;
+	size_t file_;
+	
+public:
+	
+	callback_sink(innoextract_write_fn callback, void * user, size_t file)
+		: write_(callback), user_(user), file_(file) { }
+	
+	void write(const char * data, size_t n) {
+		if(write_(user_, file_, data, n) != 0) {
+			throw aborted();
+		}
+	}
+	
+};
+
+class callback_adapter : public innoextract::extract_callback {
+	
+	const innoextract_callbacks & callbacks_;
+	void * user_;
+	callback_sink sink_;
+	
+public:
+	
+	callback_adapter(const innoextract_callbacks & callbacks, void * user)
+		: callbacks_(callbacks), user_(user), sink_(callbacks.write, user, 0) { }
+	
+	innoextract::sink * begin(size_t file) {
+		if(callbacks_.begin && callbacks_.begin(user_, file) == 0) {
+			return NULL;
+		}
+		sink_ = callback_sink(callbacks_.write, user_, file);
+		return &sink_;
+	}
+	
+	void end(size_t file, bool valid) {
+		int status = valid ? INNOEXTRACT_OK : INNOEXTRACT_CHECKSUM_MISMATCH;
+		if(callbacks_.end && callbacks_.end(user_, file, status) != 0) {
+			throw aborted();
+		}
+	}
+	
+};
+
+} // anonymous namespace
+
+#define INNOEXTRACT_API_CATCH(Result) \
+	catch(const aborted &) { \
+		set_error("Aborted by callback"); \
+		return INNOEXTRACT_ABORTED; \
+	} catch(const setup::version_error &) { \
+		set_error("Not a supported Inno Setup installer"); \
+		return Result; \
+	} catch(const std::exception & e) { \
+		set_error(e.what()); \
+		return Result; \
+	} catch(...) { \
+		set_error("Unknown error"); \
+		return Result; \
+	}
+
+extern "C" {
+
+const char * innoextract_last_error(void) {
+	return has_error ? last_error.c_str() : NULL;
+}
+
+innoextract_installer * innoextract_open(const char * path, const char * password) {
+	
+	innoextract_installer * result = NULL;
+	
+	try {
+		result = new innoextract_installer(path);
+		if(password && !result->installer.set_password(password)) {
+			delete result;
+			set_error("Incorrect password provided");
+			return NULL;
+		}
+		return result;
+	} catch(const setup::version_error &) {
+		set_error("Not a supported Inno Setup installer");
+	} catch(const std::exception & e) {
+		set_error(e.what());
+	} catch(...) {
+		set_error("Unknown error");
+	}
+	
+	return NULL;
+}
+
+void innoextract_close(innoextract_installer * installer) {
+	delete installer;
+}
+
+const char * innoextract_setup_version(innoextract_installer * installer) {
+	return installer->version.c_str();
+}
+
+size_t innoextract_file_count(const innoextract_installer * installer) {
+	return installer->installer.file_count();
+}
+
+int innoextract_get_file(const innoextract_installer * installer, size_t file,
+                         innoextract_file * info) {
+	
+	const innoextract::installer & setup = installer->installer;
+	if(file >= setup.file_count()) {
+		set_error("File index out of range");
+		return INNOEXTRACT_ERROR;
+	}
+	
+	info->path = setup.path(file).c_str();
+	info->components = setup.entry(file).components.c_str();
+	info->languages = setup.entry(file).languages.c_str();
+	info->size = setup.size(file);
+	info->timestamp = setup.data(file).timestamp;
+	info->timestamp_nsec = setup.data(file).timestamp_nsec;
+	info->locked = setup.is_locked(file) ? 1 : 0;
+	
+	return INNOEXTRACT_OK;
+}
+
+int innoextract_extract(innoextract_installer * installer, size_t file,
+                        innoextract_write_fn write, void * user) {
+	
+	if(file >= installer->installer.file_count()) {
+		set_error("File index out of range");
+		return INNOEXTRACT_ERROR;
+	}
+	
+	try {
+		callback_sink sink(write, user, file);
+		return installer->installer.extract(file, sink) ? INNOEXTRACT_OK : INNOEXTRACT_CHECKSUM_MISMATCH;
+	} INNOEXTRACT_API_CATCH(INNOEXTRACT_ERROR)
+	
+}
+
+int innoextract_extract_all(innoextract_installer * installer,
+                            const innoextract_callbacks * callbacks, void * user) {
+	
+	try {
+		callback_adapter adapter(*callbacks, user);
+		installer->installer.extract_all(adapter);
+		return INNOEXTRACT_OK;
+	} INNOEXTRACT_API_CATCH(INNOEXTRACT_ERROR)
+	
+}
+
+} // extern "C"
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * C interface to open installers and extract files.
+ *
+ * All functions returning \c int return \ref INNOEXTRACT_OK on success and a negative
+ * value on failure. A description of the last error in the current thread can be
+ * retrieved using \ref innoextract_last_error().
+ */
+#ifndef INNOEXTRACT_LIB_INNOEXTRACT_H
+#define INNOEXTRACT_LIB_INNOEXTRACT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+	INNOEXTRACT_OK = 0,
+	INNOEXTRACT_ERROR = -1,           /*!< See innoextract_last_error() */
+	INNOEXTRACT_ABORTED = -2,         /*!< A callback requested to stop extraction */
+	INNOEXTRACT_CHECKSUM_MISMATCH = -3 /*!< The file was extracted but is corrupted */
+};
+
+typedef struct innoextract_installer innoextract_installer;
+
+/*! Information about a file stored in an installer. */
+typedef struct innoextract_file {
+	
+	const char * path;       /*!< Output path, valid until the installer is closed */
+	const char * components; /*!< Components expression, may be empty */
+	const char * languages;  /*!< Languages expression, may be empty */
+	
+	uint64_t size;
+	
+	int64_t timestamp;       /*!< Modification time in seconds since the Unix epoch */
+	uint32_t timestamp_nsec;
+	
+	int locked;              /*!< Non-zero if the file is encrypted and no valid password was set */
+	
+} innoextract_file;
+
+/*!
+ * Receives extracted data.
+ *
+ * \return zero to continue or non-zero to abort extraction.
+ */
+typedef int (*innoextract_write_fn)(void * user, size_t file, const char * data, size_t size);
+
+/*! Callbacks for innoextract_extract_all(). */
+typedef struct innoextract_callbacks {
+	
+	/*! Called before extracting a file. Return non-zero to extract it or zero to skip it. */
+	int (*begin)(void * user, size_t file);
+	
+	innoextract_write_fn write;
+	
+	/*!
+	 * Called after all data for a file has been written.
+	 * \c status is INNOEXTRACT_OK or INNOEXTRACT_CHECKSUM_MISMATCH.
+	 * Return non-zero to abort extraction.
+	 */
+	int (*end)(void * user, size_t file, int status);
+	
+} innoextract_callbacks;
+
+/*! \return a description of the last error in the current thread or NULL. */
+const char * innoextract_last_error(void);
+
+/*!
+ * Open an installer.
+ *
+ * \param path     Path to the setup executable, encoded as UTF-8.
+ * \param password Password for encrypted files encoded as UTF-8, or NULL.
+ *                 An incorrect password is reported as an error.
+ *
+ * \return a new installer handle or NULL on error.
+ */
+innoextract_installer * innoextract_open(const char * path, const char * password);
+
+void innoextract_close(innoextract_installer * installer);
+
+/*! \return a string describing the Inno Setup version of the installer. */
+const char * innoextract_setup_version(innoextract_installer * installer);
+
+/*! \return the number of files that can be extracted. */
+size_t innoextract_file_count(const innoextract_installer * installer);
+
+int innoextract_get_file(const innoextract_installer * installer, size_t file,
+                         innoextract_file * info);
+
+/*!
+ * Extract a single file.
+ *
+ * \return INNOEXTRACT_OK, INNOEXTRACT_CHECKSUM_MISMATCH or a negative error code.
+ */
+int innoextract_extract(innoextract_installer * installer, size_t file,
+                        innoextract_write_fn write, void * user);
+
+/*!
+ * Extract all selected files, decompressing each chunk only once.
+ *
+ * Files are passed to the callbacks in the order they are stored in the installer.
+ * Encrypted files are skipped if no valid password has been set.
+ *
+ * Unlike the innoextract command-line tool, no filters are applied and files with the
+ * same path are all passed to the callbacks - use the begin callback to select files.
+ */
+int innoextract_extract_all(innoextract_installer * installer,
+                            const innoextract_callbacks * callbacks, void * user);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // INNOEXTRACT_LIB_INNOEXTRACT_H
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "lib/installer.hpp"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "crypto/checksum.hpp"
+#include "crypto/hasher.hpp"
+#include "setup/data.hpp"
+#include "setup/file.hpp"
+#include "setup/version.hpp"
+#include "stream/chunk.hpp"
+#include "stream/file.hpp"
+#include "stream/slice.hpp"
+#include "util/boostfs_compat.hpp"
+#include "util/load.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace innoextract {
+
+namespace {
+
+//! A file that is currently being extracted.
+struct output {
+	
+	size_t file;
+	sink * target;
+	crypto::hasher checksum;
+	bool valid;
+	
+	output(size_t index, sink * s, crypto::checksum_type type)
+		: file(index), target(s), checksum(type), valid(true) { }
+	
+};
+
+/*!
+ * Read one file from a chunk and pass its contents to all outputs.
+ *
+ * The chunk must already be positioned at the start of the file.
+ */
+void copy_file(stream::chunk_reader::type & chunk, const setup::data_entry & data,
+               std::vector<output> & outputs) {
+	
+	crypto::checksum checksum;
+	stream::file_reader::pointer source = stream::file_reader::get(chunk, data.file, &checksum);
+	
+	boost::uint64_t size = 0;
+	while(!source->eof()) {
+		char buffer[8192 * 10];
+		std::streamsize n = source->read(buffer, std::streamsize(sizeof(buffer))).gcount();
+		if(n > 0) {
+			for(output & out : outputs) {
+				out.checksum.update(buffer, size_t(n));
+				out.target->write(buffer, size_t(n));
+			}
+			size += boost::uint64_t(n);
+		}
+	}
+	
+	if(checksum != data.file.checksum || size != data.uncompressed_size) {
+		for(output & out : outputs) {
+			out.valid = false;
+		}
+	}
+	
+}
+
+bool verify(output & out, const setup::file_entry & entry) {
+	if(entry.checksum.type != crypto::None && out.checksum.finalize() != entry.checksum) {
+		return false;
+	}
+	return out.valid;
+}
+
+} // anonymous namespace
+
+stream::slice_reader * open_slices(const fs::path & installer, std::istream * is,
+                                   const loader::offsets & offsets, const setup::info & info) {
+	
+	if(offsets.data_offset) {
+		std::shared_ptr<stream::slice_table> table;
+		try {
+			table = std::make_shared<stream::slice_table>(installer, offsets.data_offset);
+		} catch(const stream::slice_error &) {
+			// Fall back to the stream, which can only be read by one thread at a time
+			table = std::make_shared<stream::slice_table>(is, offsets.data_offset);
+		}
+		return new stream::slice_reader(table);
+	}
+	
+	fs::path dir = installer.parent_path();
+	std::string basename = util::as_string(installer.stem());
+	std::string basename2 = info.header.base_filename;
+	// Prevent access to unexpected files
+	std::replace(basename2.begin(), basename2.end(), '/', '_');
+	std::replace(basename2.begin(), basename2.end(), '\\', '_');
+	// Older Inno Setup versions used the basename stored in the headers, change our default accordingly
+	if(info.version < INNO_VERSION(4, 1, 7) && !basename2.empty()) {
+		std::swap(basename2, basename);
+	}
+	
+	return new stream::slice_reader(dir, basename, basename2, info.header.slices_per_disk);
+}
+
+setup::info::entry_types installer::default_entries() {
+	return setup::info::Components | setup::info::DataEntries | setup::info::Directories
+	       | setup::info::Files | setup::info::Languages | setup::info::Tasks | setup::info::Types;
+}
+
+installer::installer(const fs::path & file, setup::info::entry_types entries,
+                     util::codepage_id codepage) : path_(file) {
+	
+	try {
+		ifs_.open(file, std::ios_base::in | std::ios_base::binary);
+		if(!ifs_.is_open()) {
+			throw std::exception();
+		}
+	} catch(...) {
+		throw std::runtime_error("Could not open file \"" + file.string() + '"');
+	}
+	
+	offsets_.load(ifs_);
+	
+	ifs_.seekg(offsets_.header_offset);
+	info_.load(ifs_, entries | setup::info::Files | setup::info::DataEntries, codepage);
+	
+	for(size_t i = 0; i < info_.files.size(); i++) {
+		if(info_.files[i].location < info_.data_entries.size()) {
+			files_.push_back(i);
+		}
+	}
+	
+	setup::filename_map filenames;
+	filenames.set_expand(true);
+	convert_paths(filenames);
+	
+}
+
+installer::~installer() { }
+
+stream::slice_reader & installer::slices() {
+	if(!slices_) {
+		slices_.reset(open_slices(path_, &ifs_, offsets_, info_));
+	}
+	return *slices_;
+}
+
+bool installer::is_readable(const setup::data_entry & data) const {
+	return data.chunk.encryption == stream::Plaintext || !password_.empty();
+}
+
+bool installer::set_password(const std::string & password) {
+	
+	std::string converted;
+	util::from_utf8(password, converted, info_.codepage);
+	
+	if(info_.header.options & setup::header::Password) {
+		crypto::hasher checksum(info_.header.password.type);
+		checksum.update(info_.header.password_salt.c_str(), info_.header.password_salt.length());
+		checksum.update(converted.c_str(), converted.length());
+		if(checksum.finalize() == info_.header.password) {
+			password_ = converted;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+void installer::convert_paths(const setup::filename_map & filenames) {
+	paths_.clear();
+	paths_.reserve(files_.size());
+	for(size_t file : files_) {
+		paths_.push_back(filenames.convert(info_.files[file].destination));
+	}
+}
+
+const setup::file_entry & installer::entry(size_t file) const {
+	return info_.files[files_[file]];
+}
+
+const setup::data_entry & installer::data(size_t file) const {
+	return info_.data_entries[entry(file).location];
+}
+
+boost::uint64_t installer::size(size_t file) const {
+	const setup::file_entry & e = entry(file);
+	boost::uint64_t result = info_.data_entries[e.location].uncompressed_size;
+	for(boost::uint32_t location : e.additional_locations) {
+		result += info_.data_entries[location].uncompressed_size;
+	}
+	return result;
+}
+
+bool installer::is_locked(size_t file) const {
+	const setup::file_entry & e = entry(file);
+	if(!is_readable(info_.data_entries[e.location])) {
+		return true;
+	}
+	for(boost::uint32_t location : e.additional_locations) {
+		if(!is_readable(info_.data_entries[location])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool installer::extract(size_t file, sink & target) {
+	
+	if(is_locked(file)) {
+		throw std::runtime_error("File \"" + path(file) + "\" is encrypted");
+	}
+	
+	const setup::file_entry & e = entry(file);
+	
+	std::vector<output> outputs;
+	outputs.push_back(output(file, &target, e.checksum.type));
+	
+	std::vector<boost::uint32_t> locations(1, e.location);
+	locations.insert(locations.end(), e.additional_locations.begin(), e.additional_locations.end());
+	
+	for(boost::uint32_t location : locations) {
+		const setup::data_entry & data = info_.data_entries[location];
+		stream::chunk_reader::pointer chunk = stream::chunk_reader::get(slices(), data.chunk, password_);
+		util::discard(*chunk, data.file.offset);
+		copy_file(*chunk, data, outputs);
+	}
+	
+	return verify(outputs.front(), e);
+}
+
+void installer::extract_all(extract_callback & callback) {
+	
+	// Group files stored in a single location by chunk and position within the chunk
+	typedef std::map<stream::file, std::vector<size_t> > Files;
+	typedef std::map<stream::chunk, Files> Chunks;
+	Chunks chunks;
+	std::vector<size_t> multipart;
+	for(size_t file = 0; file < files_.size(); file++) {
+		if(is_locked(file)) {
+			continue;
+		}
+		if(!entry(file).additional_locations.empty()) {
+			multipart.push_back(file);
+			continue;
+		}
+		const setup::data_entry & location = data(file);
+		chunks[location.chunk][location.file].push_back(file);
+	}
+	
+	for(const Chunks::value_type & chunk : chunks) {
+		
+		stream::chunk_reader::pointer source;
+		boost::uint64_t offset = 0;
+		
+		for(const Files::value_type & location : chunk.second) {
+			
+			std::vector<output> outputs;
+			for(size_t file : location.second) {
+				sink * target = callback.begin(file);
+				if(target) {
+					outputs.push_back(output(file, target, entry(file).checksum.type));
+				}
+			}
+			if(outputs.empty()) {
+				continue;
+			}
+			
+			if(!source) {
+				source = stream::chunk_reader::get(slices(), chunk.first, password_);
+				Chunks::const_iterator next = chunks.upper_bound(chunk.first);
+				if(next != chunks.end()) {
+					stream::chunk_reader::prefetch(slices(), next->first);
+				}
+			}
+			if(location.first.offset < offset) {
+				std::ostringstream oss;
+				oss << "Bad offset while extracting files: file start (" << location.first.offset
+				    << ") is before end of previous file (" << offset << ")!";
+				throw std::runtime_error(oss.str());
+			}
+			util::discard(*source, location.first.offset - offset);
+			offset = location.first.offset + location.first.size;
+			
+			copy_file(*source, data(outputs.front().file), outputs);
+			
+			for(output & out : outputs) {
+				callback.end(out.file, verify(out, entry(out.file)));
+			}
+			
+		}
+		
+	}
+	
+	for(size_t file : multipart) {
+		sink * target = callback.begin(file);
+		if(target) {
+			callback.end(file, extract(file, *target));
+		}
+	}
+	
+}
+
+} // namespace innoextract
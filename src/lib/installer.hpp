@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * C++ interface to open installers and extract files without the command-line frontend.
+ */
+#ifndef INNOEXTRACT_LIB_INSTALLER_HPP
+#define INNOEXTRACT_LIB_INSTALLER_HPP
+
+#include <stddef.h>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include "loader/offsets.hpp"
+#include "setup/filename.hpp"
+#include "setup/info.hpp"
+#include "util/encoding.hpp"
+#include "util/fstream.hpp"
+
+namespace setup { struct data_entry; struct file_entry; }
+namespace stream { class slice_reader; }
+
+//! Library interface, see \ref lib/installer.hpp and \ref lib/innoextract.h
+namespace innoextract {
+
+//! Receives the contents of an extracted file.
+class sink {
+	
+public:
+	
+	virtual ~sink() { }
+	
+	//! Receive the next block of data. Throw an exception to abort extraction.
+	virtual void write(const char * data, size_t n) = 0;
+	
+};
+
+//! Selects the files to extract in \ref installer::extract_all().
+class extract_callback {
+	
+public:
+	
+	virtual ~extract_callback() { }
+	
+	/*!
+	 * Called before a file is extracted.
+	 *
+	 * \return the sink to write the file to or \c NULL to skip the file.
+	 *         The sink must remain valid until \ref end() is called for the file.
+	 */
+	virtual sink * begin(size_t file) = 0;
+	
+	/*!
+	 * Called after all data for a file has been written to its sink.
+	 *
+	 * \param valid \c true if all checksums for the file matched.
+	 */
+	virtual void end(size_t file, bool valid) = 0;
+	
+};
+
+/*!
+ * Open the data slices of an installer.
+ *
+ * \param installer The setup executable.
+ * \param is        Stream for the setup executable, only used if the data is stored inside it
+ *                  and the setup file cannot be opened again.
+ * \param offsets   Loader offsets of the setup executable.
+ * \param info      Setup headers, only the header needs to be loaded.
+ *
+ * \return a new slice reader owned by the caller. Copies of the reader can be used to read
+ *         from the same slices in other threads.
+ */
+stream::slice_reader * open_slices(const boost::filesystem::path & installer, std::istream * is,
+                                   const loader::offsets & offsets, const setup::info & info);
+
+/*!
+ * An opened Inno Setup installer.
+ *
+ * Only files that have data stored in the installer are listed. The paths are converted
+ * using the same rules as the innoextract command-line tool with default options.
+ *
+ * This is a separate, simpler extraction path than the one used by the command-line tool.
+ * Files are listed as stored: there are no language, component or path filters, files
+ * with the same path are not merged or renamed, and temporary files are included. The
+ * caller decides which files to extract and where to write them.
+ *
+ * Methods of the same installer object must not be called concurrently.
+ *
+ * Errors are reported using exceptions derived from \c std::runtime_error
+ * and \ref setup::version_error for unsupported files.
+ */
+class installer : private boost::noncopyable {
+	
+	boost::filesystem::path path_;
+	util::ifstream ifs_;
+	loader::offsets offsets_;
+	setup::info info_;
+	
+	std::string password_; //!< Password in the installer's encoding
+	
+	std::vector<size_t> files_; //!< Indices of the files with data in \ref setup::info::files
+	std::vector<std::string> paths_;
+	
+	boost::scoped_ptr<stream::slice_reader> slices_;
+	
+	stream::slice_reader & slices();
+	
+	bool is_readable(const setup::data_entry & data) const;
+	
+public:
+	
+	//! Entry types loaded by default.
+	static setup::info::entry_types default_entries();
+	
+	/*!
+	 * Open an installer and load its headers.
+	 *
+	 * \param file     The setup executable or the header file for installers with external headers.
+	 * \param entries  Additional entry types to load. File and data entries are always loaded.
+	 * \param codepage Windows codepage to use for strings in ANSI installers, or \c 0 to detect it.
+	 */
+	explicit installer(const boost::filesystem::path & file,
+	                   setup::info::entry_types entries = default_entries(),
+	                   util::codepage_id codepage = 0);
+	
+	~installer();
+	
+	//! All loaded setup headers.
+	const setup::info & info() const { return info_; }
+	
+	const loader::offsets & offsets() const { return offsets_; }
+	
+	/*!
+	 * Set the password used to decrypt encrypted files.
+	 *
+	 * \param password The password encoded as UTF-8.
+	 *
+	 * \return \c false if the password is incorrect. It is not used in that case.
+	 */
+	bool set_password(const std::string & password);
+	
+	//! Password in the installer's encoding, empty if no valid password has been set.
+	const std::string & key() const { return password_; }
+	
+	//! Convert the file paths using a different filename map.
+	void convert_paths(const setup::filename_map & filenames);
+	
+	//! \return the number of files that can be extracted.
+	size_t file_count() const { return files_.size(); }
+	
+	const std::string & path(size_t file) const { return paths_[file]; }
+	
+	const setup::file_entry & entry(size_t file) const;
+	
+	//! Data entry for the first part of the file's contents.
+	const setup::data_entry & data(size_t file) const;
+	
+	boost::uint64_t size(size_t file) const;
+	
+	//! \return \c true if the file is encrypted and no valid password has been set.
+	bool is_locked(size_t file) const;
+	
+	/*!
+	 * Extract a single file.
+	 *
+	 * The chunk containing the file is decompressed up to the end of the file. Use
+	 * \ref extract_all() to extract many files, which decompresses each chunk only once.
+	 *
+	 * \return \c true if all checksums for the file matched.
+	 */
+	bool extract(size_t file, sink & output);
+	
+	/*!
+	 * Extract files in the order they are stored in the installer.
+	 *
+	 * \ref extract_callback::begin() is called for every file that can be extracted,
+	 * files that are encrypted when no valid password has been set are skipped.
+	 *
+	 * Files stored in a single location are extracted while reading each chunk once.
+	 * Files split over several locations are extracted separately at the end using
+	 * \ref extract(), which may decompress their chunks again.
+	 */
+	void extract_all(extract_callback & callback);
+	
+};
+
+} // namespace innoextract
+
+#endif // INNOEXTRACT_LIB_INSTALLER_HPP
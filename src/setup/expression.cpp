@@ -21,6 +21,7 @@
 #include "setup/expression.hpp"
 
 #include <stddef.h>
+#include <algorithm>
 #include <cstring>
 #include <vector>
 #include <stdexcept>
@@ -157,8 +158,119 @@ struct evaluator {
 	
 };
 
+/*!
+ * Parser that collects the distinct identifiers of an expression.
+ *
+ * Uses the same grammar (and stops at the same point) as \ref evaluator.
+ */
+struct identifier_collector : public evaluator {
+	
+	std::vector<std::string> & identifiers;
+	
+	identifier_collector(const std::string & expression, std::vector<std::string> & result)
+		: evaluator(expression, empty()), identifiers(result) { }
+	
+	static const std::string & empty() {
+		static const std::string value;
+		return value;
+	}
+	
+	void collect_factor() {
+		if(token == paren_left) {
+			next();
+			collect_expression();
+			if(token != paren_right) {
+				throw std::runtime_error("expected closing parenthesis");
+			}
+			next();
+		} else if(token == op_not) {
+			next();
+			collect_factor();
+		} else if(token == identifier) {
+			std::string name(token_start, token_length);
+			if(std::find(identifiers.begin(), identifiers.end(), name) == identifiers.end()) {
+				identifiers.push_back(name);
+			}
+			next();
+		} else {
+			throw std::runtime_error("unexpected token");
+		}
+	}
+	
+	void collect_term() {
+		collect_factor();
+		while(token == op_and) {
+			next();
+			collect_factor();
+		}
+	}
+	
+	void collect_expression() {
+		collect_term();
+		while(token == op_or || token == identifier) {
+			if(token == op_or) {
+				next();
+			}
+			collect_term();
+		}
+	}
+	
+	void collect() {
+		next();
+		collect_expression();
+	}
+	
+};
+
 } // anonymous namespace
 
+compiled_expression::compiled_expression(const std::string & expression)
+	: default_result_(true), valid_(true) {
+	
+	std::vector<std::string> names;
+	try {
+		identifier_collector(expression, names).collect();
+	} catch(const std::runtime_error &) {
+		// Keep the original expression so that errors are reported the same way
+		valid_ = false;
+		expression_ = expression;
+		return;
+	}
+	
+	// Only one variable is ever set, so the result for each identifier is all we need
+	default_result_ = evaluator(expression, identifier_collector::empty()).eval();
+	identifiers_.reserve(names.size());
+	for(const std::string & name : names) {
+		identifiers_.push_back(identifier(name, evaluator(expression, name).eval()));
+	}
+	
+}
+
+bool compiled_expression::match(const std::string & test) const {
+	
+	if(!valid_) {
+		return expression_match(test, expression_);
+	}
+	
+	for(const identifier & entry : identifiers_) {
+		if(entry.first == test) {
+			return entry.second;
+		}
+	}
+	
+	return default_result_;
+}
+
+const compiled_expression & expression_cache::get(const std::string & expression) {
+	
+	map_type::iterator it = expressions_.find(expression);
+	if(it == expressions_.end()) {
+		it = expressions_.insert(map_type::value_type(expression, compiled_expression(expression))).first;
+	}
+	
+	return it->second;
+}
+
 bool expression_match(const std::string & test, const std::string & expression) {
 	try {
 		return evaluator(expression, test).eval();
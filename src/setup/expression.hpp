@@ -27,6 +27,9 @@
 #define INNOEXTRACT_SETUP_EXPRESSION_HPP
 
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace setup {
 
@@ -37,6 +40,61 @@ bool expression_match(const std::string & test, const std::string & expression);
 
 bool is_simple_expression(const std::string & expression);
 
+/*!
+ * Pre-compiled form of a boolean expression.
+ *
+ * As only a single variable is ever set to true, the expression is reduced to a truth
+ * table with one entry per distinct identifier plus the result when no identifier matches.
+ * Matching then only requires comparing the test variable against the identifiers.
+ */
+class compiled_expression {
+	
+	typedef std::pair<std::string, bool> identifier;
+	
+	std::vector<identifier> identifiers_;
+	bool default_result_;
+	
+	bool valid_;
+	std::string expression_;
+	
+public:
+	
+	explicit compiled_expression(const std::string & expression);
+	
+	//! Same as \ref expression_match, but without re-parsing the expression.
+	bool match(const std::string & test) const;
+	
+	//! \return false if the expression could not be parsed.
+	bool valid() const { return valid_; }
+	
+};
+
+/*!
+ * Cache of compiled expressions.
+ *
+ * Installers tend to use only a handful of distinct expressions for all their files,
+ * so each distinct expression string only needs to be compiled once.
+ */
+class expression_cache {
+	
+	typedef std::unordered_map<std::string, compiled_expression> map_type;
+	
+	map_type expressions_;
+	
+public:
+	
+	//! Get the compiled form of an expression, compiling it on first use.
+	const compiled_expression & get(const std::string & expression);
+	
+	//! Same as \ref expression_match, but with the compiled expression being memoised.
+	bool match(const std::string & test, const std::string & expression) {
+		return get(expression).match(test);
+	}
+	
+	void clear() { expressions_.clear(); }
+	
+};
+
 } // namespace setup
 
 #endif // INNOEXTRACT_SETUP_EXPRESSION_HPP
@@ -24,6 +24,8 @@
 #include <algorithm>
 #include <cctype>
 
+#include <boost/algorithm/string/case_conv.hpp>
+
 namespace setup {
 
 namespace {
@@ -60,6 +62,44 @@ std::string replace_unsafe_chars(const std::string & str) {
 	return result;
 }
 
+/*!
+ * Find the last path separator that is not part of a variable.
+ *
+ * \return the position of the separator or \c std::string::npos if there is no such
+ *         separator or if the variables in the path are not balanced.
+ */
+size_t find_last_separator(const std::string & path) {
+	
+	size_t result = std::string::npos;
+	size_t depth = 0;
+	
+	for(size_t i = 0; i < path.size(); i++) {
+		if(path[i] == '{') {
+			if(i + 1 < path.size() && path[i + 1] == '{') {
+				i++; // '{{' escape sequence
+			} else {
+				depth++;
+			}
+		} else if(path[i] == '}') {
+			if(depth != 0) {
+				depth--;
+			}
+		} else if(depth == 0 && is_path_separator()(path[i])) {
+			result = i;
+		}
+	}
+	
+	return (depth == 0) ? result : std::string::npos;
+}
+
+//! Check if a path segment can be appended to a shortened path as-is.
+bool is_simple_segment(const std::string & segment) {
+	if(segment.empty() || segment == "." || segment == "..") {
+		return false;
+	}
+	return std::find_if(segment.begin(), segment.end(), is_path_separator()) == segment.end();
+}
+
 } // anonymous namespace
 
 std::string filename_map::lookup(const std::string & key) const {
@@ -163,22 +203,82 @@ std::string filename_map::shorten_path(const std::string & path) {
 	return result;
 }
 
-std::string filename_map::convert(std::string path) const {
+std::string filename_map::convert_expanded(const std::string & path) const {
+	
+	it begin = path.begin();
+	std::string expanded = expand_variables(begin, path.end());
+	
+	return shorten_path(expanded);
+}
+
+const filename_map::converted_directory &
+filename_map::convert_directory(const std::string & path) const {
+	
+	directory_cache::iterator i = directories.find(path);
+	if(i == directories.end()) {
+		converted_directory dir;
+		dir.path = convert_expanded(path);
+		dir.key = lowercase ? dir.path : boost::algorithm::to_lower_copy(dir.path);
+		i = directories.insert(directory_cache::value_type(path, dir)).first;
+	}
+	
+	return i->second;
+}
+
+std::string filename_map::convert(std::string path, std::string * key) const {
 	
 	// Convert paths to lower-case if requested
 	if(lowercase) {
 		std::transform(path.begin(), path.end(), path.begin(), ::tolower);
 	}
 	
-	// Don't expand variables if requested
-	if(!expand) {
-		return path;
+	size_t sep = expand ? find_last_separator(path) : std::string::npos;
+	if(sep == std::string::npos) {
+		// Don't expand variables if requested
+		std::string result = expand ? convert_expanded(path) : path;
+		if(key) {
+			*key = lowercase ? result : boost::algorithm::to_lower_copy(result);
+		}
+		return result;
 	}
 	
-	it begin = path.begin();
-	std::string expanded = expand_variables(begin, path.end());
+	// Only the last path component is unique to this path, re-use the converted parent
+	it begin = path.begin() + ptrdiff_t(sep) + 1;
+	std::string leaf = expand_variables(begin, path.end());
+	path.resize(sep);
+	const converted_directory & dir = convert_directory(path);
 	
-	return shorten_path(expanded);
+	if(!is_simple_segment(leaf)) {
+		std::string result = shorten_path(dir.path + path_sep + leaf);
+		if(key) {
+			*key = lowercase ? result : boost::algorithm::to_lower_copy(result);
+		}
+		return result;
+	}
+	
+	std::string result;
+	result.reserve(dir.path.size() + 1 + leaf.size());
+	result.append(dir.path);
+	if(!dir.path.empty()) {
+		result.push_back(path_sep);
+	}
+	result.append(leaf);
+	
+	if(key) {
+		if(lowercase) {
+			*key = result;
+		} else {
+			key->clear();
+			key->reserve(result.size());
+			key->append(dir.key);
+			if(!dir.key.empty()) {
+				key->push_back(path_sep);
+			}
+			key->append(boost::algorithm::to_lower_copy(leaf));
+		}
+	}
+	
+	return result;
 }
 
 } // namespace setup
@@ -28,6 +28,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 
 namespace setup {
 
@@ -41,6 +42,9 @@ static const char path_sep = '/';
 /*!
  * Map to convert between raw windows file paths stored in the setup file (which can
  * contain variables) and output filenames.
+ *
+ * Converted directory prefixes are memoised as most paths share them with many other
+ * files. Call \ref clear_cache() after modifying the variable map.
  */
 class filename_map : public std::map<std::string, std::string> {
 	
@@ -51,23 +55,53 @@ class filename_map : public std::map<std::string, std::string> {
 	
 	typedef std::string::const_iterator it;
 	
+	//! A converted directory and its lower-case form.
+	struct converted_directory {
+		std::string path;
+		std::string key;
+	};
+	
+	typedef std::unordered_map<std::string, converted_directory> directory_cache;
+	mutable directory_cache directories;
+	
 	std::string expand_variables(it & begin, it end, bool close = false) const;
 	static std::string shorten_path(const std::string & path);
 	
+	std::string convert_expanded(const std::string & path) const;
+	const converted_directory & convert_directory(const std::string & path) const;
+	
+	std::string convert(std::string path, std::string * key) const;
+	
 public:
 	
 	filename_map() : lowercase(false), expand(false) { }
 	
-	std::string convert(std::string path) const;
+	std::string convert(const std::string & path) const { return convert(path, NULL); }
+	
+	/*!
+	 * Convert a path and also get its lower-case form.
+	 *
+	 * This is cheaper than lower-casing the converted path as the lower-case form of the
+	 * directory prefix is memoised as well.
+	 *
+	 * \param path Path as stored in the setup file.
+	 * \param key  Receives the converted path in lower case.
+	 */
+	std::string convert(const std::string & path, std::string & key) const {
+		return convert(path, &key);
+	}
 	
 	//! Set if paths should be converted to lower-case.
-	void set_lowercase(bool enable) { lowercase = enable; }
+	void set_lowercase(bool enable) { lowercase = enable; clear_cache(); }
 	
 	//! Set if paths should be converted to lower-case.
 	bool is_lowercase() const { return lowercase; }
 	
 	//! Set if variables should be expanded and path separators converted.
-	void set_expand(bool enable) { expand = enable; }
+	void set_expand(bool enable) { expand = enable; clear_cache(); }
+	
+	//! Forget all memoised directory conversions.
+	void clear_cache() { directories.clear(); }
 	
 };
 
@@ -45,6 +45,7 @@
 #include "util/load.hpp"
 #include "util/log.hpp"
 #include "util/output.hpp"
+#include "util/trace.hpp"
 
 namespace setup {
 
@@ -143,6 +144,13 @@ void info::try_load(std::istream & is, entry_types entries, util::codepage_id fo
 	
 	debug("trying to load setup headers for version " << version);
 	
+	util::trace::span span("headers", "info::try_load");
+	if(span.active()) {
+		std::ostringstream oss;
+		oss << version;
+		span.arg("version", oss.str());
+	}
+	
 	if((entries & (Messages | NoSkip)) || (!version.is_unicode() && !force_codepage)) {
 		entries |= Languages;
 	}
@@ -234,6 +242,8 @@ void info::try_load(std::istream & is, entry_types entries, util::codepage_id fo
 
 void info::load(std::istream & is, entry_types entries, util::codepage_id force_codepage) {
 	
+	util::trace::span span("headers", "info::load");
+	
 	version.load(is);
 	
 	listed_version = version;
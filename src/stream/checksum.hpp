@@ -31,6 +31,7 @@
 
 #include "crypto/checksum.hpp"
 #include "crypto/hasher.hpp"
+#include "util/stats.hpp"
 
 namespace stream {
 
@@ -66,7 +67,9 @@ public:
 		std::streamsize nread = boost::iostreams::read(src, dest, n);
 		
 		if(nread > 0) {
+			util::stats::timer timer(util::stats::Hash);
 			hasher.update(dest, size_t(nread));
+			timer.add(boost::uint64_t(nread));
 		} else if(output) {
 			*output = hasher.finalize();
 			output = NULL;
@@ -36,7 +36,10 @@
 #include "stream/lzma.hpp"
 #include "stream/restrict.hpp"
 #include "stream/slice.hpp"
+#include "stream/timer.hpp"
+#include "util/endian.hpp"
 #include "util/log.hpp"
+#include "util/stats.hpp"
 
 
 namespace io = boost::iostreams;
@@ -75,7 +78,9 @@ public:
 		
 		std::streamsize length = boost::iostreams::read(src, dest, n);
 		if(length != EOF) {
+			util::stats::timer timer(util::stats::Decrypt);
 			arc4.crypt(dest, dest, size_t(n));
+			timer.add(boost::uint64_t(length));
 		}
 		
 		return length;
@@ -127,8 +132,14 @@ chunk_reader::pointer chunk_reader::get(slice_reader & base, const chunk & chunk
 		throw chunk_error("bad chunk magic");
 	}
 	
+	util::stats::count(util::stats::Chunks);
+	
 	pointer result(new boost::iostreams::chain<boost::iostreams::input>);
 	
+	if(util::stats::enabled && chunk.compression != Stored) {
+		result->push(timer_filter(util::stats::Decompress), 8192);
+	}
+	
 	switch(chunk.compression) {
 		case Stored: break;
 		case Zlib:   result->push(io::zlib_decompressor(), 8192); break;
@@ -168,6 +179,50 @@ chunk_reader::pointer chunk_reader::get(slice_reader & base, const chunk & chunk
 	return result;
 }
 
+void chunk_reader::prefetch(slice_reader & base, const chunk & chunk) {
+	
+	boost::uint64_t size = sizeof(chunk_id) + boost::uint64_t(chunk.size);
+	if(chunk.encryption != Plaintext) {
+		size += 8; // salt
+	}
+	
+	base.prefetch(chunk.first_slice, chunk.offset, size);
+}
+
+boost::uint32_t chunk_reader::dictionary_size(slice_reader & base, const ::stream::chunk & chunk,
+                                              const std::string & key) {
+	
+	if(chunk.compression != LZMA1 && chunk.compression != LZMA2) {
+		return 0;
+	}
+	if(chunk.encryption != Plaintext && key.empty()) {
+		return 0;
+	}
+	
+	// Only decrypt, the properties are stored in front of the compressed data
+	::stream::chunk raw = chunk;
+	raw.compression = Stored;
+	pointer is = get(base, raw, key);
+	
+	char properties[5];
+	std::streamsize length = (chunk.compression == LZMA1) ? 5 : 1;
+	if(io::read(*is, properties, length) != length) {
+		throw chunk_error("could not read LZMA properties");
+	}
+	
+	if(chunk.compression == LZMA1) {
+		return util::little_endian::load<boost::uint32_t>(properties + 1);
+	}
+	
+	boost::uint8_t prop = boost::uint8_t(properties[0]);
+	if(prop > 40) {
+		throw chunk_error("bad LZMA2 dictionary size property");
+	} else if(prop == 40) {
+		return boost::uint32_t(-1);
+	}
+	return boost::uint32_t(2 | (prop & 1)) << (prop / 2 + 11);
+}
+
 } // namespace stream
 
 NAMES(stream::compression_method, "Compression Method",
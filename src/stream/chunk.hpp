@@ -121,6 +121,29 @@ public:
 	 */
 	static pointer get(slice_reader & base, const ::stream::chunk & chunk, const std::string & key);
 	
+	/*!
+	 * Hint that a chunk will be read soon so that its data can be read ahead.
+	 *
+	 * \param base  The slice reader for the setup file(s).
+	 * \param chunk Information specifying the chunk that will be read.
+	 */
+	static void prefetch(slice_reader & base, const ::stream::chunk & chunk);
+	
+	/*!
+	 * Read the LZMA dictionary size from the start of a chunk without decompressing it.
+	 *
+	 * \param base  The slice reader for the setup file(s).
+	 * \param chunk Information specifying the chunk to inspect.
+	 * \param key   Key used for encrypted chunks.
+	 *
+	 * \throws chunk_error if the chunk header could not be read or was invalid.
+	 *
+	 * \return the dictionary size in bytes or \c 0 if the chunk is not LZMA-compressed
+	 *         or is encrypted and no key is available.
+	 */
+	static boost::uint32_t dictionary_size(slice_reader & base, const ::stream::chunk & chunk,
+	                                       const std::string & key);
+	
 };
 
 } // namespace stream
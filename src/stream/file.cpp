@@ -20,12 +20,16 @@
 
 #include "stream/file.hpp"
 
+#include <algorithm>
+
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
 
 #include "stream/checksum.hpp"
 #include "stream/exefilter.hpp"
 #include "stream/restrict.hpp"
+#include "stream/timer.hpp"
+#include "util/stats.hpp"
 
 namespace io = boost::iostreams;
 
@@ -54,6 +58,8 @@ bool file::operator==(const file & o) const {
 file_reader::pointer file_reader::get(base_type & base, const file & file,
                                       crypto::checksum * checksum) {
 	
+	util::stats::count(util::stats::Files);
+	
 	std::unique_ptr<io::filtering_istream> result(new io::filtering_istream);
 	
 	if(file.filter == ZlibFilter) {
@@ -64,6 +70,10 @@ file_reader::pointer file_reader::get(base_type & base, const file & file,
 		result->push(stream::checksum_filter(checksum, file.checksum.type), 8192);
 	}
 	
+	if(util::stats::enabled && file.filter != NoFilter && file.filter != ZlibFilter) {
+		result->push(stream::timer_filter(util::stats::ExeFilter), 8192);
+	}
+	
 	switch(file.filter) {
 		case NoFilter: break;
 		case InstructionFilter4108: result->push(stream::inno_exe_decoder_4108(), 8192); break;
@@ -79,4 +89,59 @@ file_reader::pointer file_reader::get(base_type & base, const file & file,
 	return pointer(result.release());
 }
 
+void file_reader_context::open(base_type & base, const file & file, crypto::checksum * checksum) {
+	
+	filtered_.reset();
+	
+	if(file.filter != NoFilter) {
+		remaining_ = 0;
+		checksum_ = NULL;
+		filtered_ = file_reader::get(base, file, checksum);
+		return;
+	}
+	
+	util::stats::count(util::stats::Files);
+	
+	base_ = &base;
+	remaining_ = file.size;
+	checksum_ = checksum;
+	if(checksum_) {
+		hasher_ = crypto::hasher(file.checksum.type);
+	}
+	
+}
+
+size_t file_reader_context::read(char * buffer, size_t n) {
+	
+	if(filtered_) {
+		return size_t(filtered_->read(buffer, std::streamsize(n)).gcount());
+	}
+	
+	std::streamsize nread = 0;
+	if(remaining_ != 0 && n != 0) {
+		std::streamsize bytes = std::streamsize(std::min(boost::uint64_t(n), remaining_));
+		nread = io::read(*base_, buffer, bytes);
+	}
+	
+	if(nread <= 0) {
+		// End of the file or of the chunk
+		remaining_ = 0;
+		if(checksum_) {
+			*checksum_ = hasher_.finalize();
+			checksum_ = NULL;
+		}
+		return 0;
+	}
+	
+	remaining_ -= boost::uint64_t(nread);
+	
+	if(checksum_) {
+		util::stats::timer timer(util::stats::Hash);
+		hasher_.update(buffer, size_t(nread));
+		timer.add(boost::uint64_t(nread));
+	}
+	
+	return size_t(nread);
+}
+
 } // namespace stream
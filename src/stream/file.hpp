@@ -28,9 +28,11 @@
 
 #include <istream>
 
+#include <boost/noncopyable.hpp>
 #include <boost/iostreams/chain.hpp>
 
 #include "crypto/checksum.hpp"
+#include "crypto/hasher.hpp"
 
 namespace stream {
 
@@ -95,6 +97,47 @@ public:
 	
 };
 
+/*!
+ * Reads the files of a \ref chunk_reader one after the other.
+ *
+ * Unlike \ref file_reader, the state is kept between files: files without an additional
+ * filter are read directly from the chunk and hashed in place without allocating anything.
+ * Filtered files fall back to a \ref file_reader stream.
+ */
+class file_reader_context : private boost::noncopyable {
+	
+	typedef boost::iostreams::chain<boost::iostreams::input> base_type;
+	
+	base_type * base_;
+	boost::uint64_t remaining_; //!< Bytes left to read from the current unfiltered file.
+	crypto::hasher hasher_;
+	crypto::checksum * checksum_;
+	file_reader::pointer filtered_; //!< Stream for the current filtered file.
+	
+public:
+	
+	file_reader_context()
+		: base_(NULL), remaining_(0), hasher_(crypto::None), checksum_(NULL) { }
+	
+	/*!
+	 * Start reading the next file.
+	 *
+	 * The parameters are the same as for \ref file_reader::get().
+	 * Any remaining data of the previous file is ignored.
+	 */
+	void open(base_type & base, const file & file, crypto::checksum * checksum);
+	
+	/*!
+	 * Read data from the current file.
+	 *
+	 * The checksum is stored once the end of the file has been reached.
+	 *
+	 * \return the number of bytes read or \c 0 at the end of the file.
+	 */
+	size_t read(char * buffer, size_t n);
+	
+};
+
 } // namespace stream
 
 #endif // INNOEXTRACT_STREAM_FILE_HPP
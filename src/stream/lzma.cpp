@@ -20,6 +20,9 @@
 
 #include "stream/lzma.hpp"
 
+#include <mutex>
+#include <vector>
+
 #include <boost/cstdint.hpp>
 
 #include <lzma.h>
@@ -29,23 +32,101 @@
 
 namespace stream {
 
-static lzma_stream * init_raw_lzma_stream(lzma_vli filter, lzma_options_lzma & options) {
+namespace {
+
+/*!
+ * Decoders that have finished a chunk, kept so that the next chunk with the same filter
+ * and dictionary size does not need to allocate and fault in a new dictionary buffer.
+ *
+ * liblzma re-uses the existing allocations when a decoder is initialized again with the
+ * same dictionary size.
+ */
+class decoder_pool : private boost::noncopyable {
+	
+	struct decoder {
+		lzma_vli filter;
+		boost::uint32_t dict_size;
+		lzma_stream * stream;
+	};
+	
+	//! Maximum number of idle decoders, limits how much dictionary memory stays allocated
+	static const size_t capacity = 2;
+	
+	std::mutex mutex;
+	std::vector<decoder> decoders; // Least recently used first
+	
+	static void free(lzma_stream * strm) {
+		lzma_end(strm);
+		delete strm;
+	}
+	
+public:
 	
+	~decoder_pool() {
+		for(const decoder & idle : decoders) {
+			free(idle.stream);
+		}
+	}
+	
+	//! \return an idle decoder for the filter and dictionary size or \c NULL if there is none.
+	lzma_stream * get(lzma_vli filter, boost::uint32_t dict_size) {
+		std::lock_guard<std::mutex> lock(mutex);
+		for(std::vector<decoder>::iterator i = decoders.end(); i != decoders.begin(); ) {
+			--i;
+			if(i->filter == filter && i->dict_size == dict_size) {
+				lzma_stream * strm = i->stream;
+				decoders.erase(i);
+				return strm;
+			}
+		}
+		return NULL;
+	}
+	
+	void put(lzma_vli filter, boost::uint32_t dict_size, lzma_stream * strm) {
+		decoder idle = { filter, dict_size, strm };
+		lzma_stream * evicted = NULL;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			decoders.push_back(idle);
+			if(decoders.size() > capacity) {
+				evicted = decoders.front().stream;
+				decoders.erase(decoders.begin());
+			}
+		}
+		if(evicted) {
+			free(evicted);
+		}
+	}
+	
+};
+
+decoder_pool pool;
+
+} // anonymous namespace
+
+void lzma_decompressor_impl_base::init(boost::uint64_t filter, void * options_ptr) {
+	
+	lzma_options_lzma & options = *static_cast<lzma_options_lzma *>(options_ptr);
 	options.preset_dict = NULL;
 	
-	lzma_stream * strm = new lzma_stream;
-	lzma_stream tmp = LZMA_STREAM_INIT;
-	*strm = tmp;
-	strm->allocator = NULL;
+	lzma_stream * strm = pool.get(filter, options.dict_size);
+	if(!strm) {
+		strm = new lzma_stream;
+		lzma_stream tmp = LZMA_STREAM_INIT;
+		*strm = tmp;
+		strm->allocator = NULL;
+	}
 	
 	const lzma_filter filters[2] = { { filter,  &options }, { LZMA_VLI_UNKNOWN, NULL } };
 	lzma_ret ret = lzma_raw_decoder(strm, filters);
 	if(ret != LZMA_OK) {
-		delete strm;
+		delete strm; // liblzma already freed the decoder state
 		throw lzma_error("inno lzma init error", ret);
 	}
 	
-	return strm;
+	stream = strm;
+	filter_id = filter;
+	dict_size = options.dict_size;
 }
 
 bool lzma_decompressor_impl_base::filter(const char * & begin_in, const char * end_in,
@@ -78,9 +159,9 @@ bool lzma_decompressor_impl_base::filter(const char * & begin_in, const char * e
 void lzma_decompressor_impl_base::close() {
 	
 	if(stream) {
-		lzma_stream * strm = static_cast<lzma_stream *>(stream);
-		lzma_end(strm);
-		delete strm, stream = NULL;
+		// The decoder is re-initialized before it is used again
+		pool.put(filter_id, dict_size, static_cast<lzma_stream *>(stream));
+		stream = NULL;
 	}
 }
 
@@ -110,7 +191,7 @@ bool inno_lzma1_decompressor_impl::filter(const char * & begin_in, const char *
 		
 		options.dict_size = util::little_endian::load<boost::uint32_t>(header + 1);
 		
-		stream = init_raw_lzma_stream(LZMA_FILTER_LZMA1, options);
+		init(LZMA_FILTER_LZMA1, &options);
 	}
 	
 	return lzma_decompressor_impl_base::filter(begin_in, end_in, begin_out, end_out, flush);
@@ -139,7 +220,7 @@ bool inno_lzma2_decompressor_impl::filter(const char * & begin_in, const char *
 			options.dict_size = ((boost::uint32_t(2) | boost::uint32_t((prop) & 1)) << ((prop) / 2 + 11));
 		}
 		
-		stream = init_raw_lzma_stream(LZMA_FILTER_LZMA2, options);
+		init(LZMA_FILTER_LZMA2, &options);
 	}
 	
 	return lzma_decompressor_impl_base::filter(begin_in, end_in, begin_out, end_out, flush);
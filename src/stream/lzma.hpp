@@ -33,6 +33,7 @@
 #include <stddef.h>
 #include <iosfwd>
 
+#include <boost/cstdint.hpp>
 #include <boost/iostreams/filter/symmetric.hpp>
 #include <boost/noncopyable.hpp>
 
@@ -68,10 +69,23 @@ public:
 protected:
 	
 	//! Abstract base class, subclasses need to intialize stream.
-	lzma_decompressor_impl_base() : stream(NULL) { }
+	lzma_decompressor_impl_base() : stream(NULL), filter_id(0), dict_size(0) { }
+	
+	/*!
+	 * Initialize \ref stream for a raw LZMA stream, re-using an idle decoder if possible.
+	 *
+	 * \param filter  liblzma filter ID.
+	 * \param options Pointer to the filter's \c lzma_options_lzma.
+	 */
+	void init(boost::uint64_t filter, void * options);
 	
 	void * stream;
 	
+private:
+	
+	boost::uint64_t filter_id;
+	boost::uint32_t dict_size;
+	
 };
 
 class inno_lzma1_decompressor_impl : public lzma_decompressor_impl_base {
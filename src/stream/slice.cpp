@@ -20,21 +20,39 @@
 
 #include "stream/slice.hpp"
 
-#include <sstream>
+#include <algorithm>
 #include <cstring>
+#include <exception>
 #include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include <boost/cstdint.hpp>
-#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/file_descriptor.hpp>
 // Debian Buster has Boost Filesystem 1.67.0.1 installed by default
 // directory.hpp was split from the main in 1.72
 // https://www.boost.org/users/history/version_1_72_0.html
 // #include <boost/filesystem/directory.hpp>
 
+#include "configure.hpp"
+
+#if INNOEXTRACT_HAVE_PREAD
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#if INNOEXTRACT_HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
+
 #include "util/console.hpp"
-#include "util/load.hpp"
+#include "util/endian.hpp"
 #include "util/log.hpp"
+#include "util/stats.hpp"
+#include "util/trace.hpp"
 
 namespace stream {
 
@@ -45,216 +63,601 @@ const char slice_ids[][8] = {
 	{ 'i', 'd', 's', 'k', 'a', '3', '2', 0x1a },
 };
 
+//! Size of the magic number and size field at the start of each slice file.
+const boost::uint32_t slice_header_size = 12;
+
+//! Maximum number of bytes to read ahead for one request.
+const boost::uint64_t max_readahead = boost::uint64_t(32) << 20;
+
+//! Maximum number of slice files to keep open at the same time.
+const size_t max_open_slices = 16;
+
 } // anonymous namespace
 
-slice_reader::slice_reader(std::istream * istream, boost::uint32_t offset)
-	: data_offset(offset),
-	  slices_per_disk(1), current_slice(0), slice_size(0),
-	  is(istream) {
+class slice_table::file : private boost::noncopyable {
 	
-	std::streampos max_size = std::streampos(std::numeric_limits<boost::int32_t>::max());
+public:
 	
-	std::streampos file_size = is->seekg(0, std::ios_base::end).tellg();
+	path_type path;
+	boost::uint32_t size; //!< End of the slice data in the file.
 	
-	slice_size = boost::uint32_t(std::min(file_size, max_size));
-	if(is->seekg(data_offset).fail()) {
-		throw slice_error("could not seek to data");
+	boost::iostreams::file_descriptor fd;
+	std::istream * is; //!< Stream to read from instead of \ref fd, or \c NULL.
+	std::mutex mutex;  //!< Serializes reads that have to change the file position.
+	
+	file() : size(0), is(NULL) { }
+	
+	std::streamsize read(boost::uint64_t offset, char * buffer, std::streamsize bytes);
+	
+	//! Ask the operating system to read a file range into the page cache.
+	void readahead(boost::uint64_t offset, boost::uint64_t bytes);
+	
+};
+
+std::streamsize slice_table::file::read(boost::uint64_t offset, char * buffer,
+                                        std::streamsize bytes) {
+	
+	if(is) {
+		std::lock_guard<std::mutex> lock(mutex);
+		is->clear();
+		if(is->seekg(std::streamoff(offset)).fail()) {
+			return -1;
+		}
+		is->read(buffer, bytes);
+		return is->bad() ? -1 : is->gcount();
+	}
+	
+	std::streamsize nread = 0;
+	
+	#if INNOEXTRACT_HAVE_PREAD
+	
+	while(bytes > 0) {
+		ssize_t result = ::pread(fd.handle(), buffer, size_t(bytes), off_t(offset));
+		if(result < 0 && errno == EINTR) {
+			continue;
+		}
+		if(result < 0) {
+			return -1;
+		}
+		if(result == 0) {
+			break;
+		}
+		nread += result, buffer += result, bytes -= result, offset += boost::uint64_t(result);
 	}
+	
+	#else
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	try {
+		fd.seek(boost::iostreams::stream_offset(offset), std::ios_base::beg);
+		while(bytes > 0) {
+			std::streamsize result = fd.read(buffer, bytes);
+			if(result <= 0) {
+				break;
+			}
+			nread += result, buffer += result, bytes -= result;
+		}
+	} catch(...) {
+		return -1;
+	}
+	
+	#endif
+	
+	return nread;
 }
 
-slice_reader::slice_reader(const path_type & dirname, const std::string & basename,
-                           const std::string & basename2, size_t disk_slice_count)
-	: data_offset(0),
-	  dir(dirname), base_file(basename), base_file2(basename2),
-	  slices_per_disk(disk_slice_count), current_slice(0), slice_size(0),
-	  is(&ifs) { }
+void slice_table::file::readahead(boost::uint64_t offset, boost::uint64_t bytes) {
+	#if INNOEXTRACT_HAVE_POSIX_FADVISE
+	if(!is && fd.is_open()) {
+		(void)posix_fadvise(fd.handle(), off_t(offset), off_t(bytes), POSIX_FADV_WILLNEED);
+	}
+	#else
+	(void)offset, (void)bytes;
+	#endif
+}
 
-void slice_reader::seek(size_t slice) {
+
+/*!
+ * Finds the files for external slices.
+ *
+ * Used by both the reader and the prefetch thread. The directory is only listed once for
+ * case-insensitive lookups.
+ */
+class slice_table::slice_locator : private boost::noncopyable {
 	
-	if(slice == current_slice && is_open()) {
-		return;
+	const path_type dir;
+	const std::string base_file;
+	const std::string base_file2;
+	const size_t slices_per_disk;
+	
+	std::mutex mutex;
+	bool listed;
+	std::multimap<std::string, path_type> listing; //!< Files in dir by lower-case name
+	
+public:
+	
+	slice_locator(const path_type & dirname, const std::string & basename,
+	              const std::string & basename2, size_t disk_slice_count)
+		: dir(dirname), base_file(basename), base_file2(basename2)
+		, slices_per_disk(disk_slice_count), listed(false) { }
+		
+	//! File names to try for a slice, in order.
+	std::vector<std::string> names(size_t slice) const {
+		std::vector<std::string> result;
+		result.push_back(slice_reader::slice_filename(base_file, slice, slices_per_disk));
+		if(!base_file2.empty()) {
+			std::string name2 = slice_reader::slice_filename(base_file2, slice, slices_per_disk);
+			if(name2 != result.front()) {
+				result.push_back(name2);
+			}
+		}
+		return result;
 	}
 	
-	if(data_offset != 0) {
-		throw slice_error("cannot change slices in single-file setup");
+	//! Files in the slice directory whose name matches ignoring case.
+	std::vector<path_type> matches(const std::string & name) {
+		
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		if(!listed) {
+			boost::filesystem::directory_iterator end;
+			for(boost::filesystem::directory_iterator i(dir.empty() ? path_type(".") : dir); i != end; ++i) {
+				path_type filename = i->path().filename();
+				listing.insert(std::make_pair(boost::to_lower_copy(filename.string()), filename));
+			}
+			listed = true;
+		}
+		
+		std::vector<path_type> result;
+		typedef std::multimap<std::string, path_type>::const_iterator iterator;
+		std::pair<iterator, iterator> range = listing.equal_range(boost::to_lower_copy(name));
+		for(iterator i = range.first; i != range.second; ++i) {
+			result.push_back(dir / i->second);
+		}
+		
+		return result;
 	}
 	
-	open(slice);
-}
+	/*!
+	 * Try the candidate files for a slice until one can be opened.
+	 *
+	 * \param slice    The slice to look for.
+	 * \param try_file Function that attempts to open a file and returns \c true on success.
+	 *
+	 * \return \c true if \c try_file succeeded for one of the candidates.
+	 */
+	template <typename Function>
+	bool find(size_t slice, Function try_file) {
+		
+		std::vector<std::string> candidates = names(slice);
+		
+		for(const std::string & name : candidates) {
+			if(try_file(dir / name)) {
+				return true;
+			}
+		}
+		
+		for(const std::string & name : candidates) {
+			for(const path_type & file : matches(name)) {
+				if(try_file(file)) {
+					return true;
+				}
+			}
+		}
+		
+		return false;
+	}
+	
+};
+
 
-bool slice_reader::open_file(const path_type & file) {
+/*!
+ * Background thread that opens upcoming slices and reads ahead data.
+ *
+ * Errors are ignored here - they are reported when a reader opens the slice itself.
+ */
+class slice_table::prefetcher : private boost::noncopyable {
 	
-	if(!boost::filesystem::exists(file)) {
-		return false;
+	struct request {
+		size_t slice;
+		boost::uint64_t offset;
+		boost::uint64_t size;
+	};
+	
+	slice_table & table;
+	
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<request> requests;
+	bool stop;
+	
+	std::thread thread;
+	
+	void run() {
+		
+		std::unique_lock<std::mutex> lock(mutex);
+		
+		for(;;) {
+			
+			while(!stop && requests.empty()) {
+				condition.wait(lock);
+			}
+			if(stop) {
+				return;
+			}
+			
+			request next = requests.front();
+			requests.pop_front();
+			lock.unlock();
+			
+			boost::uint64_t size = std::min(next.size, max_readahead);
+			while(size > 0) {
+				handle slice;
+				try {
+					util::trace::span span("slice", "prefetch");
+					span.arg("slice", next.slice);
+					slice = table.find(next.slice);
+				} catch(...) {
+					// Reported when the slice is opened by a reader
+					break;
+				}
+				if(next.offset >= slice->size) {
+					break;
+				}
+				boost::uint64_t n = std::min(size, slice->size - next.offset);
+				slice->readahead(next.offset, n);
+				size -= n;
+				next.slice++;
+				next.offset = slice_header_size;
+			}
+			
+			lock.lock();
+		}
 	}
 	
-	log_info << "Opening \"" << color::cyan << file.string() << color::reset << '"';
+public:
 	
-	ifs.close();
-	ifs.clear();
+	explicit prefetcher(slice_table & slices)
+		: table(slices), stop(false)
+		, thread(&prefetcher::run, this) { }
+		
+	~prefetcher() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		condition.notify_all();
+		thread.join();
+	}
 	
-	ifs.open(file, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
-	if(ifs.fail()) {
-		return false;
+	//! Queue a range to read ahead.
+	void prefetch(size_t slice, boost::uint64_t offset, boost::uint64_t size) {
+		request next = { slice, offset, size };
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			requests.push_back(next);
+		}
+		condition.notify_all();
 	}
 	
-	std::streampos file_size = ifs.tellg();
-	ifs.seekg(0);
+};
+
+slice_table::slice_table(const path_type & setup, boost::uint32_t offset)
+	: data_offset_(offset), embedded(std::make_shared<file>()) {
+	
+	embedded->path = setup;
+	try {
+		embedded->fd.open(setup, std::ios_base::in | std::ios_base::binary);
+	} catch(...) {
+		// Reported below
+	}
+	if(!embedded->fd.is_open()) {
+		throw slice_error("could not open \"" + setup.string() + '"');
+	}
 	
-	char magic[8];
-	if(ifs.read(magic, 8).fail()) {
-		ifs.close();
-		throw slice_error("could not read slice magic number in \"" + file.string() + "\"");
+	boost::iostreams::stream_offset file_size = embedded->fd.seek(0, std::ios_base::end);
+	
+	boost::iostreams::stream_offset max_size = std::numeric_limits<boost::int32_t>::max();
+	embedded->size = boost::uint32_t(std::max(std::min(file_size, max_size),
+	                                          boost::iostreams::stream_offset(0)));
+	if(data_offset_ > embedded->size) {
+		throw slice_error("could not seek to data");
+	}
+}
+
+slice_table::slice_table(std::istream * istream, boost::uint32_t offset)
+	: data_offset_(offset), embedded(std::make_shared<file>()) {
+	
+	embedded->is = istream;
+	
+	std::streampos max_size = std::streampos(std::numeric_limits<boost::int32_t>::max());
+	
+	std::streampos file_size = istream->seekg(0, std::ios_base::end).tellg();
+	
+	embedded->size = boost::uint32_t(std::min(file_size, max_size));
+	if(istream->seekg(data_offset_).fail()) {
+		throw slice_error("could not seek to data");
+	}
+}
+
+slice_table::slice_table(const path_type & dirname, const std::string & basename,
+                         const std::string & basename2, size_t disk_slice_count)
+	: data_offset_(0),
+	  locator(new slice_locator(dirname, basename, basename2, disk_slice_count)) { }
+
+slice_table::~slice_table() {
+	// Stop the background thread before the table it uses goes away
+	background.reset();
+}
+
+slice_table::handle slice_table::open_file(const path_type & path) {
+	
+	if(!boost::filesystem::exists(path)) {
+		return handle();
+	}
+	
+	handle result = std::make_shared<file>();
+	result->path = path;
+	try {
+		result->fd.open(path, std::ios_base::in | std::ios_base::binary);
+	} catch(...) {
+		return handle();
+	}
+	if(!result->fd.is_open()) {
+		return handle();
+	}
+	
+	boost::iostreams::stream_offset file_size = result->fd.seek(0, std::ios_base::end);
+	
+	char header[slice_header_size];
+	if(read(result, 0, header, 8) != 8) {
+		throw slice_error("could not read slice magic number in \"" + path.string() + "\"");
 	}
 	bool found = false;
-	for(size_t i = 0; std::size(slice_ids); i++) {
-		if(!std::memcmp(magic, slice_ids[i], 8)) {
+	for(size_t i = 0; i < std::size(slice_ids); i++) {
+		if(!std::memcmp(header, slice_ids[i], 8)) {
 			found = true;
 			break;
 		}
 	}
 	if(!found) {
-		ifs.close();
-		throw slice_error("bad slice magic number in \"" + file.string() + "\"");
+		throw slice_error("bad slice magic number in \"" + path.string() + "\"");
 	}
 	
-	slice_size = util::load<boost::uint32_t>(ifs);
-	if(ifs.fail()) {
-		ifs.close();
-		throw slice_error("could not read slice size in \"" + file.string() + "\"");
-	} else if(std::streampos(slice_size) > file_size) {
-		ifs.close();
+	if(read(result, 8, header + 8, 4) != 4) {
+		throw slice_error("could not read slice size in \"" + path.string() + "\"");
+	}
+	result->size = util::little_endian::load<boost::uint32_t>(header + 8);
+	if(boost::iostreams::stream_offset(result->size) > file_size) {
 		std::ostringstream oss;
-		oss << "bad slice size in " << file << ": " << slice_size << " > " << file_size;
+		oss << "bad slice size in " << path << ": " << result->size << " > " << file_size;
 		throw slice_error(oss.str());
-	} else if(std::streampos(slice_size) < ifs.tellg()) {
-		ifs.close();
+	} else if(result->size < slice_header_size) {
 		std::ostringstream oss;
-		oss << "bad slice size in " << file << ": " << slice_size << " < " << ifs.tellg();
+		oss << "bad slice size in " << path << ": " << result->size << " < " << slice_header_size;
 		throw slice_error(oss.str());
 	}
 	
-	return true;
+	util::stats::count(util::stats::Slices);
+	
+	return result;
 }
 
-std::string slice_reader::slice_filename(const std::string & basename, size_t slice,
-                                         size_t slices_per_disk) {
+slice_table::handle slice_table::find(size_t slice) {
 	
-	std::ostringstream oss;
-	oss << basename << '-';
+	if(embedded) {
+		if(slice != 0) {
+			throw slice_error("cannot change slices in single-file setup");
+		}
+		return embedded;
+	}
 	
-	if(slices_per_disk == 0) {
-		throw slice_error("slices per disk must not be zero");
+	std::unique_lock<std::mutex> lock(mutex);
+	
+	for(;;) {
+		std::map<size_t, handle>::const_iterator it = opened.find(slice);
+		if(it != opened.end()) {
+			return it->second;
+		}
+		if(opening.find(slice) == opening.end()) {
+			break;
+		}
+		condition.wait(lock);
 	}
 	
-	if(slices_per_disk == 1) {
-		oss << (slice + 1);
-	} else {
-		size_t major = (slice / slices_per_disk) + 1;
-		size_t minor = slice % slices_per_disk;
-		oss << major << char(boost::uint8_t('a') + minor);
+	opening.insert(slice);
+	lock.unlock();
+	
+	handle result;
+	std::exception_ptr error;
+	try {
+		util::trace::span span("slice", "slice_table::open");
+		span.arg("slice", slice);
+		locator->find(slice, [&](const path_type & path) {
+			result = open_file(path);
+			return bool(result);
+		});
+	} catch(...) {
+		error = std::current_exception();
 	}
 	
-	oss << ".bin";
+	lock.lock();
+	opening.erase(slice);
+	if(result) {
+		opened[slice] = result;
+		open_order.push_back(slice);
+		// Readers still using a closed slice keep their own reference to it
+		while(open_order.size() > max_open_slices) {
+			opened.erase(open_order.front());
+			open_order.pop_front();
+		}
+	}
+	condition.notify_all();
+	lock.unlock();
 	
-	return oss.str();
-}
-
-bool slice_reader::open_file_case_insensitive(const path_type & dirname, const path_type & filename) {
+	if(error) {
+		std::rethrow_exception(error);
+	}
 	
-	boost::filesystem::directory_iterator end;
-	for(boost::filesystem::directory_iterator i(dirname); i != end; ++i) {
-		path_type actual_filename = i->path().filename();
-		if(boost::iequals(actual_filename.string(), filename.string()) && open_file(dirname / actual_filename)) {
-			return true;
+	if(!result) {
+		std::vector<std::string> names = locator->names(slice);
+		std::ostringstream oss;
+		oss << "could not open slice " << slice << ": " << names.front();
+		if(names.size() > 1) {
+			oss << " or " << names.back();
 		}
+		throw slice_error(oss.str());
 	}
 	
-	return false;
+	return result;
 }
 
-void slice_reader::open(size_t slice) {
+slice_table::handle slice_table::open(size_t slice) {
 	
-	current_slice = slice;
-	is = &ifs;
-	ifs.close();
+	handle result = find(slice);
 	
-	path_type slice_file = slice_filename(base_file, slice, slices_per_disk);
-	if(open_file(dir / slice_file)) {
-		return;
+	// Get the next slice ready while this one is being read
+	queue_prefetch(slice + 1, slice_header_size, max_readahead);
+	
+	return result;
+}
+
+std::streamsize slice_table::read(const handle & slice, boost::uint64_t offset,
+                                  char * buffer, std::streamsize bytes) {
+	return slice->read(offset, buffer, bytes);
+}
+
+const slice_table::path_type & slice_table::path(const handle & slice) {
+	return slice->path;
+}
+
+boost::uint32_t slice_table::size(const handle & slice) {
+	return slice->size;
+}
+
+void slice_table::prefetch(size_t slice, boost::uint32_t offset, boost::uint64_t size) {
+	if(size != 0) {
+		queue_prefetch(slice, offset, size);
 	}
+}
+
+void slice_table::queue_prefetch(size_t slice, boost::uint64_t offset, boost::uint64_t size) {
 	
-	path_type slice_file2 = slice_filename(base_file2, slice, slices_per_disk);
-	if(!base_file2.empty() && slice_file2 != slice_file && open_file(dir / slice_file2)) {
-		return;
+	if(!locator) {
+		return; // Embedded data is read directly
 	}
 	
-	if(open_file_case_insensitive(dir, slice_file)) {
+	std::call_once(background_started, [this]() { background.reset(new prefetcher(*this)); });
+	
+	background->prefetch(slice, offset, size);
+}
+
+slice_reader::slice_reader(const std::shared_ptr<slice_table> & table)
+	: slices(table), current_slice(0), position(0) { }
+
+slice_reader::slice_reader(std::istream * istream, boost::uint32_t offset)
+	: slices(std::make_shared<slice_table>(istream, offset)),
+	  current_slice(0), position(0) { }
+
+slice_reader::slice_reader(const path_type & dirname, const std::string & basename,
+                           const std::string & basename2, size_t disk_slice_count)
+	: slices(std::make_shared<slice_table>(dirname, basename, basename2, disk_slice_count)),
+	  current_slice(0), position(0) { }
+
+void slice_reader::seek(size_t slice) {
+	
+	if(slice == current_slice && file) {
 		return;
 	}
 	
-	if(!base_file2.empty() && slice_file2 != slice_file && open_file_case_insensitive(dir, slice_file2)) {
-		return;
+	file.reset();
+	current_slice = slice;
+	file = slices->open(slice);
+	
+	if(slices->data_offset() != 0) {
+		position = slices->data_offset();
+	} else {
+		position = slice_header_size;
+		const path_type & path = slice_table::path(file);
+		log_info << "Opening \"" << color::cyan << path.string() << color::reset << '"';
 	}
+}
+
+std::string slice_reader::slice_filename(const std::string & basename, size_t slice,
+                                         size_t slices_per_disk) {
 	
 	std::ostringstream oss;
-	oss << "could not open slice " << slice << ": " << slice_file;
-	if(!base_file2.empty() && slice_file2 != slice_file) {
-		oss << " or " << slice_file2;
+	oss << basename << '-';
+	
+	if(slices_per_disk == 0) {
+		throw slice_error("slices per disk must not be zero");
+	}
+	
+	if(slices_per_disk == 1) {
+		oss << (slice + 1);
+	} else {
+		size_t major = (slice / slices_per_disk) + 1;
+		size_t minor = slice % slices_per_disk;
+		oss << major << char(boost::uint8_t('a') + minor);
 	}
-	throw slice_error(oss.str());
+	
+	oss << ".bin";
+	
+	return oss.str();
 }
 
 bool slice_reader::seek(size_t slice, boost::uint32_t offset) {
 	
 	seek(slice);
 	
-	offset += data_offset;
+	util::stats::count(util::stats::Seeks);
 	
-	if(offset > slice_size) {
+	boost::uint64_t file_offset = boost::uint64_t(offset) + slices->data_offset();
+	if(file_offset > slice_table::size(file)) {
 		return false;
 	}
 	
-	if(is->seekg(offset).fail()) {
-		return false;
-	}
+	position = file_offset;
 	
 	return true;
 }
 
 std::streamsize slice_reader::read(char * buffer, std::streamsize bytes) {
 	
+	util::stats::timer timer(util::stats::SliceRead);
+	
 	seek(current_slice);
 	
 	std::streamsize nread = 0;
 	
 	while(bytes > 0) {
 		
-		boost::uint32_t read_pos = boost::uint32_t(is->tellg());
-		if(read_pos > slice_size) {
+		boost::uint32_t slice_size = slice_table::size(file);
+		if(position > slice_size) {
 			break;
 		}
-		boost::uint32_t remaining = slice_size - read_pos;
-		if(!remaining) {
+		if(position == slice_size) {
 			seek(current_slice + 1);
-			read_pos = boost::uint32_t(is->tellg());
-			if(read_pos > slice_size) {
-				break;
-			}
-			remaining = slice_size - read_pos;
+			continue;
 		}
 		
-		boost::uint64_t toread = std::min(boost::uint64_t(remaining), boost::uint64_t(bytes));
-		toread = std::min(toread, boost::uint64_t(std::numeric_limits<std::streamsize>::max()));
-		if(is->read(buffer, std::streamsize(toread)).fail()) {
+		boost::uint64_t toread = std::min(slice_size - position, boost::uint64_t(bytes));
+		std::streamsize read = slice_table::read(file, position, buffer, std::streamsize(toread));
+		if(read <= 0) {
 			break;
 		}
 		
-		std::streamsize read = is->gcount();
 		nread += read, buffer += read, bytes -= read;
+		position += boost::uint64_t(read);
 	}
 	
+	timer.add(boost::uint64_t(nread));
+	
 	return (nread != 0 || bytes == 0) ? nread : -1;
 }
 
+void slice_reader::prefetch(size_t slice, boost::uint32_t offset, boost::uint64_t size) {
+	slices->prefetch(slice, offset, size);
+}
+
 } // namespace stream
@@ -26,23 +26,148 @@
 #ifndef INNOEXTRACT_STREAM_SLICE_HPP
 #define INNOEXTRACT_STREAM_SLICE_HPP
 
+#include <condition_variable>
+#include <deque>
 #include <ios>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/iostreams/concepts.hpp>
 #include <boost/filesystem/path.hpp>
 
-#include "util/fstream.hpp"
-
 namespace stream {
 
-//! Error thrown by \ref slice_reader if there was a problem.
+//! Error thrown by \ref slice_reader and \ref slice_table if there was a problem.
 struct slice_error : public std::ios_base::failure {
 	
 	explicit slice_error(const std::string & msg) : std::ios_base::failure(msg) { }
 	
 };
 
+/*!
+ * Shared table of opened setup data slices.
+ *
+ * Slices are opened on first use and read using positional reads, so a single table
+ * can be used by any number of \ref slice_reader cursors from different threads at the
+ * same time. Only a limited number of slice files are kept open.
+ *
+ * For external slices, a background thread opens and validates the next slice while
+ * the current one is being read and asks the operating system to read ahead data that
+ * will be needed soon. See \ref prefetch(). The thread is only started once data is read.
+ */
+class slice_table : private boost::noncopyable {
+	
+public:
+	
+	typedef boost::filesystem::path path_type;
+	
+	//! An opened slice - kept alive by readers even if the table closes it.
+	class file;
+	typedef std::shared_ptr<file> handle;
+	
+	/*!
+	 * Construct a table for data inside the setup file.
+	 * Only the zeroeth slice is available.
+	 *
+	 * \param setup  The setup executable.
+	 * \param offset The offset within the setup executable where the setup data starts.
+	 *               This offset is given by \ref loader::offsets::data_offset.
+	 *
+	 * \throws slice_error if the setup file could not be opened.
+	 */
+	slice_table(const path_type & setup, boost::uint32_t offset);
+	
+	/*!
+	 * Construct a table for data inside the setup file using an existing stream.
+	 *
+	 * Reads from the stream are serialized - prefer the constructor taking a path.
+	 *
+	 * \param istream A seekable input stream for the setup executable.
+	 *                The read position of the stream is changed by reads.
+	 * \param offset  The offset within the given stream where the setup data starts.
+	 */
+	slice_table(std::istream * istream, boost::uint32_t offset);
+	
+	/*!
+	 * Construct a table for external data slices (aka disks).
+	 *
+	 * See \ref slice_reader::slice_reader(const path_type &, const std::string &,
+	 * const std::string &, size_t) for how slice files are named.
+	 */
+	slice_table(const path_type & dirname, const std::string & basename,
+	            const std::string & basename2, size_t disk_slice_count);
+	
+	~slice_table();
+	
+	//! \return the start of the setup data in the zeroeth slice, or \c 0 for external slices.
+	boost::uint32_t data_offset() const { return data_offset_; }
+	
+	/*!
+	 * Get an opened slice, opening it if needed.
+	 *
+	 * Concurrent calls for the same slice wait for the first one to open it.
+	 *
+	 * \throws slice_error if the slice could not be opened or is not valid.
+	 */
+	handle open(size_t slice);
+	
+	/*!
+	 * Read from an opened slice without changing any shared read position.
+	 *
+	 * \param slice  The opened slice to read from.
+	 * \param offset File position to start reading at.
+	 * \param buffer Buffer to receive the bytes read.
+	 * \param bytes  Number of bytes to read. Reads are not limited to the slice size.
+	 *
+	 * \return the number of bytes read, which is only less than \c bytes at the end of the
+	 *         file, or \c -1 if there was an error.
+	 */
+	static std::streamsize read(const handle & slice, boost::uint64_t offset,
+	                            char * buffer, std::streamsize bytes);
+	
+	//! \return the file for an opened slice.
+	static const path_type & path(const handle & slice);
+	
+	//! \return the size in bytes of an opened slice, including the header.
+	static boost::uint32_t size(const handle & slice);
+	
+	//! \see slice_reader::prefetch()
+	void prefetch(size_t slice, boost::uint32_t offset, boost::uint64_t size);
+	
+private:
+	
+	class slice_locator;
+	class prefetcher;
+	
+	handle open_file(const path_type & file);
+	
+	//! Open a slice without reading ahead the next one.
+	handle find(size_t slice);
+	
+	//! Queue a range to read ahead, starting the background thread if needed.
+	void queue_prefetch(size_t slice, boost::uint64_t offset, boost::uint64_t size);
+	
+	const boost::uint32_t data_offset_;
+	handle embedded; //!< The setup file for embedded data
+	
+	std::unique_ptr<slice_locator> locator; //!< Finds slice files for external data.
+	std::unique_ptr<prefetcher> background; //!< Read-ahead thread for external slices.
+	std::once_flag background_started;
+	
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::map<size_t, handle> opened;
+	std::deque<size_t> open_order; //!< Opened slices, oldest first
+	std::set<size_t> opening;      //!< Slices currently being opened by some thread
+	
+};
+
 /*!
  * Abstraction for reading either data embedded inside the setup executable or from
  * multiple external slices.
@@ -53,38 +178,32 @@ struct slice_error : public std::ios_base::failure {
  * The contained data is made up of one or more \ref chunk "chunks"
  * (read by \ref chunk_reader), which in turn contain one or more  \ref file "files"
  * (read by \ref file_reader).
+ *
+ * A slice reader is a cursor into a \ref slice_table. Copies of a reader share the same
+ * table and opened files but have their own position, so that each thread can read
+ * different chunks using its own copy.
  */
 class slice_reader : public boost::iostreams::source {
 	
 	typedef boost::filesystem::path path_type;
 	
-	// Information for reading embedded setup data
-	const boost::uint32_t data_offset;
-	
-	// Information for eading external setup data
-	path_type    dir;             //!< Slice directory specified at construction.
-	std::string  base_file;       //!< Base file name for slices.
-	std::string  base_file2;      //!< Fallback base filename for slices.
-	const size_t slices_per_disk; //!< Number of slices grouped into each disk (for names).
-	
-	// Information about the current slice
-	size_t          current_slice; //!< Number of the currently opened slice.
-	boost::uint32_t slice_size;    //!< Size in bytes of the currently opened slice.
+	std::shared_ptr<slice_table> slices;
 	
-	// Streams
-	util::ifstream ifs; //!< File input stream used when reading from external slices.
-	std::istream * is;  //!< Input stream to read from.
+	size_t current_slice; //!< Number of the current slice.
+	slice_table::handle file; //!< The current slice, or \c NULL if it has not been opened.
+	boost::uint64_t position; //!< Read position within the current slice file.
 	
+	//! Make a slice current, positioned at the start of its data.
 	void seek(size_t slice);
-	bool open_file(const path_type & file);
-	bool open_file_case_insensitive(const path_type & dirname, const path_type & filename);
-	void open(size_t slice);
 	
 public:
 	
 	static std::string slice_filename(const std::string & basename, size_t slice,
 	                                  size_t slices_per_disk = 1);
 	
+	//! Construct a reader for an existing table, starting at the zeroeth slice.
+	explicit slice_reader(const std::shared_ptr<slice_table> & table);
+	
 	/*!
 	 * Construct a \ref slice_reader to read from data inside the setup file.
 	 * Seeking to anything except the zeroeth slice is not allowed.
@@ -123,8 +242,10 @@ public:
 	 * \param slice  The slice to seek to.
 	 * \param offset The byte offset to seek to within the given slice.
 	 *
-	 * \return \c false if the requested slice could not be opened, or if the requested
-	 *         offset is not a valid position in that slice - \c true otherwise.
+	 * \return \c false if the requested offset is not a valid position in that slice
+	 *         - \c true otherwise.
+	 *
+	 * \throws slice_error if the requested slice could not be opened.
 	 */
 	bool seek(size_t slice, boost::uint32_t offset);
 	
@@ -145,11 +266,26 @@ public:
 	 */
 	std::streamsize read(char * buffer, std::streamsize bytes);
 	
+	/*!
+	 * Hint that a range of data will be read soon.
+	 *
+	 * The range may continue into the following slices. The data is read ahead in the
+	 * background where supported. This is a no-op for data inside the setup file.
+	 *
+	 * \param slice  The slice where the range starts.
+	 * \param offset The byte offset of the range within that slice.
+	 * \param size   Number of bytes in the range.
+	 */
+	void prefetch(size_t slice, boost::uint32_t offset, boost::uint64_t size);
+	
 	//! \return the number currently opened slice.
 	size_t slice() { return current_slice; }
 	
 	//! \return true a slice is currently open.
-	bool is_open() { return (is != &ifs || ifs.is_open()); }
+	bool is_open() { return file != NULL; }
+	
+	//! \return the table shared by all copies of this reader.
+	const std::shared_ptr<slice_table> & table() const { return slices; }
 	
 };
 
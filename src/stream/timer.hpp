@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Filter to be used with boost::iostreams for attributing time to a pipeline stage.
+ */
+#ifndef INNOEXTRACT_STREAM_TIMER_HPP
+#define INNOEXTRACT_STREAM_TIMER_HPP
+
+#include <boost/iostreams/concepts.hpp>
+#include <boost/iostreams/read.hpp>
+
+#include "util/stats.hpp"
+
+namespace stream {
+
+/*!
+ * Pass-through filter that times reads from the filter below it.
+ *
+ * Push this on top of a filter that is not instrumented itself. Nested stages that use
+ * \ref util::stats::timer are not counted. This adds a buffer to the chain, so only use
+ * it if \ref util::stats::enabled is set.
+ */
+class timer_filter : public boost::iostreams::multichar_input_filter {
+	
+private:
+	
+	typedef boost::iostreams::multichar_input_filter base_type;
+	
+public:
+	
+	typedef base_type::char_type char_type;
+	typedef base_type::category category;
+	
+	explicit timer_filter(util::stats::stage stage) : stage_(stage) { }
+	
+	template <typename Source>
+	std::streamsize read(Source & src, char * dest, std::streamsize n) {
+		
+		util::stats::timer timer(stage_);
+		
+		std::streamsize nread = boost::iostreams::read(src, dest, n);
+		if(nread > 0) {
+			timer.add(boost::uint64_t(nread));
+		}
+		
+		return nread;
+	}
+	
+private:
+	
+	util::stats::stage stage_;
+	
+};
+
+} // namespace stream
+
+#endif // INNOEXTRACT_STREAM_TIMER_HPP
@@ -0,0 +1,480 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Benchmarks for the decompression, filter, checksum and conversion code.
+ *
+ * Results are printed as JSON so that they can be compared across releases.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/program_options.hpp>
+
+#include "configure.hpp"
+
+#include "crypto/adler32.hpp"
+#if INNOEXTRACT_HAVE_ARC4
+#include "crypto/arc4.hpp"
+#endif
+#include "crypto/crc32.hpp"
+#include "crypto/md5.hpp"
+#include "crypto/sha1.hpp"
+#include "lib/installer.hpp"
+#include "loader/offsets.hpp"
+#include "setup/info.hpp"
+#include "setup/version.hpp"
+#include "stream/block.hpp"
+#include "stream/exefilter.hpp"
+#include "stream/lzma.hpp"
+#include "tools/compress.hpp"
+#include "util/console.hpp"
+#include "util/encoding.hpp"
+#include "util/endian.hpp"
+#include "util/fstream.hpp"
+#include "util/log.hpp"
+#include "util/output.hpp"
+
+#include "release.hpp"
+
+namespace io = boost::iostreams;
+namespace po = boost::program_options;
+
+namespace {
+
+struct result {
+	
+	std::string name;
+	boost::uint64_t iterations;
+	boost::uint64_t bytes; //!< Bytes processed per iteration
+	double seconds;
+	
+};
+
+class runner {
+	
+	std::string filter_;
+	double min_time_;
+	std::vector<result> results_;
+	
+public:
+	
+	runner(const std::string & filter, double min_time) : filter_(filter), min_time_(min_time) { }
+	
+	bool enabled(const std::string & name) const {
+		return filter_.empty() || name.find(filter_) != std::string::npos;
+	}
+	
+	/*!
+	 * Run a benchmark repeatedly until the minimum time has elapsed.
+	 *
+	 * \param name  Name of the benchmark.
+	 * \param bytes Number of bytes processed by each call to \c function.
+	 */
+	template <typename Function>
+	void run(const std::string & name, boost::uint64_t bytes, Function function) {
+		
+		if(!enabled(name)) {
+			return;
+		}
+		
+		function(); // Warm up
+		
+		typedef std::chrono::steady_clock clock;
+		clock::time_point start = clock::now();
+		
+		result r;
+		r.name = name;
+		r.bytes = bytes;
+		r.iterations = 0;
+		do {
+			function();
+			r.iterations++;
+			r.seconds = std::chrono::duration<double>(clock::now() - start).count();
+		} while(r.seconds < min_time_);
+		
+		std::cerr << name << ": " << print_bytes(double(bytes * r.iterations) / r.seconds) << "/s\n";
+		
+		results_.push_back(r);
+	}
+	
+	void write_json(std::ostream & os) const {
+		
+		os << "{\n";
+		os << "  \"version\": \"" << innoextract_version << "\",\n";
+		os << "  \"benchmarks\": [";
+		for(size_t i = 0; i < results_.size(); i++) {
+			const result & r = results_[i];
+			os << (i == 0 ? "\n" : ",\n");
+			os << "    { \"name\": \"" << r.name << "\""
+			   << ", \"iterations\": " << r.iterations
+			   << ", \"bytes\": " << r.bytes
+			   << ", \"seconds\": " << r.seconds
+			   << ", \"bytes_per_second\": " << (double(r.bytes * r.iterations) / r.seconds)
+			   << " }";
+		}
+		os << "\n  ]\n";
+		os << "}\n";
+	}
+	
+};
+
+//! Read a stream to the end and return the number of bytes read.
+boost::uint64_t drain(std::istream & is) {
+	boost::uint64_t total = 0;
+	char buffer[64 * 1024];
+	while(is.read(buffer, std::streamsize(sizeof(buffer))) || is.gcount() > 0) {
+		total += boost::uint64_t(is.gcount());
+	}
+	return total;
+}
+
+template <typename Filter>
+boost::uint64_t decode(const std::string & input, const Filter & filter) {
+	io::filtering_istream is;
+	is.push(filter, 8192);
+	is.push(io::array_source(input.data(), input.size()));
+	return drain(is);
+}
+
+void bench_decompression(runner & r, const std::string & data) {
+	
+	struct method {
+		const char * name;
+		stream::compression_method type;
+	};
+	static const method methods[] = {
+		{ "decompress/zlib", stream::Zlib },
+		{ "decompress/bzip2", stream::BZip2 },
+		#if INNOEXTRACT_HAVE_LZMA
+		{ "decompress/lzma1", stream::LZMA1 },
+		{ "decompress/lzma2", stream::LZMA2 },
+		#endif
+	};
+	
+	for(const method & m : methods) {
+		
+		if(!r.enabled(m.name)) {
+			continue;
+		}
+		
+		std::string compressed = tools::compress(m.type, data);
+		
+		switch(m.type) {
+			case stream::Zlib: {
+				r.run(m.name, data.size(), [&]() { decode(compressed, io::zlib_decompressor()); });
+				break;
+			}
+			case stream::BZip2: {
+				r.run(m.name, data.size(), [&]() { decode(compressed, io::bzip2_decompressor()); });
+				break;
+			}
+			#if INNOEXTRACT_HAVE_LZMA
+			case stream::LZMA1: {
+				r.run(m.name, data.size(), [&]() { decode(compressed, stream::inno_lzma1_decompressor()); });
+				break;
+			}
+			case stream::LZMA2: {
+				r.run(m.name, data.size(), [&]() { decode(compressed, stream::inno_lzma2_decompressor()); });
+				break;
+			}
+			#endif
+			default: break;
+		}
+		
+	}
+	
+}
+
+void bench_filters(runner & r, const std::string & data) {
+	
+	r.run("filter/exe_4108", data.size(), [&]() { decode(data, stream::inno_exe_decoder_4108()); });
+	
+	r.run("filter/exe_5200", data.size(), [&]() { decode(data, stream::inno_exe_decoder_5200(false)); });
+	
+	r.run("filter/exe_5309", data.size(), [&]() { decode(data, stream::inno_exe_decoder_5200(true)); });
+	
+	if(r.enabled("filter/block")) {
+		
+		// Stored header block with a CRC32 checksum before every 4 KiB
+		std::string block;
+		for(size_t pos = 0; pos < data.size(); pos += 4096) {
+			std::string part = data.substr(pos, 4096);
+			crypto::crc32 crc;
+			crc.init();
+			crc.update(part.data(), part.size());
+			char checksum[4];
+			util::little_endian::store(crc.finalize(), checksum);
+			block.append(checksum, sizeof(checksum));
+			block.append(part);
+		}
+		char header[9];
+		util::little_endian::store(boost::uint32_t(block.size()), header + 4);
+		header[8] = 0;
+		crypto::crc32 crc;
+		crc.init();
+		crc.update(header + 4, 5);
+		util::little_endian::store(crc.finalize(), header);
+		block.insert(0, header, sizeof(header));
+		
+		setup::version version(5, 5, 0);
+		r.run("filter/block", data.size(), [&]() {
+			io::array_source source(block.data(), block.size());
+			io::stream<io::array_source> is(source);
+			stream::block_reader::pointer reader = stream::block_reader::get(is, version);
+			// Block readers throw on EOF
+			std::vector<char> buffer(64 * 1024);
+			for(size_t pos = 0; pos < data.size(); pos += buffer.size()) {
+				reader->read(buffer.data(), std::streamsize(std::min(buffer.size(), data.size() - pos)));
+			}
+		});
+		
+	}
+	
+}
+
+void bench_checksums(runner & r, const std::string & data) {
+	
+	r.run("checksum/crc32", data.size(), [&]() {
+		crypto::crc32 crc;
+		crc.init();
+		crc.update(data.data(), data.size());
+		volatile boost::uint32_t result = crc.finalize();
+		(void)result;
+	});
+	
+	r.run("checksum/adler32", data.size(), [&]() {
+		crypto::adler32 adler;
+		adler.init();
+		adler.update(data.data(), data.size());
+		volatile boost::uint32_t result = adler.finalize();
+		(void)result;
+	});
+	
+	r.run("checksum/md5", data.size(), [&]() {
+		crypto::md5 md5;
+		md5.init();
+		md5.update(data.data(), data.size());
+		char result[16];
+		md5.finalize(result);
+	});
+	
+	r.run("checksum/sha1", data.size(), [&]() {
+		crypto::sha1 sha1;
+		sha1.init();
+		sha1.update(data.data(), data.size());
+		char result[20];
+		sha1.finalize(result);
+	});
+	
+	#if INNOEXTRACT_HAVE_ARC4
+	std::string output(data.size(), '\0');
+	r.run("crypt/arc4", data.size(), [&]() {
+		crypto::arc4 arc4;
+		arc4.init("0123456789abcdef", 16);
+		arc4.discard(1000);
+		arc4.crypt(data.data(), &output[0], data.size());
+	});
+	#endif
+	
+}
+
+void bench_encoding(runner & r, const std::string & data) {
+	
+	// Printable characters that are defined in Windows-1252
+	std::string ansi = data;
+	for(char & c : ansi) {
+		boost::uint8_t value = boost::uint8_t(0x20 + boost::uint8_t(c) % 0xc0);
+		c = char(value < 0x80 ? value : value + 0x20);
+	}
+	r.run("encoding/windows1252", ansi.size(), [&]() {
+		std::string buffer = ansi;
+		util::to_utf8(buffer, util::cp_windows1252);
+	});
+	
+	std::string utf16;
+	utf16.reserve(data.size());
+	for(size_t i = 0; i + 1 < data.size(); i += 2) {
+		// Mostly ASCII with some characters outside of Latin-1
+		utf16.push_back(char(0x20 + (boost::uint8_t(data[i]) % 0x5f)));
+		utf16.push_back((data[i + 1] & 7) == 0 ? '\x04' : '\0');
+	}
+	r.run("encoding/utf16le", utf16.size(), [&]() {
+		std::string buffer = utf16;
+		util::to_utf8(buffer, util::cp_utf16le);
+	});
+	
+}
+
+void bench_installer(runner & r, const std::string & file) {
+	
+	util::ifstream ifs(file, std::ios_base::in | std::ios_base::binary);
+	if(!ifs.is_open()) {
+		throw std::runtime_error("Could not open file \"" + file + '"');
+	}
+	loader::offsets offsets;
+	offsets.load(ifs);
+	
+	const setup::info::entry_types entries = setup::info::entry_types::all()
+		& ~(setup::info::entry_types(setup::info::NoSkip) | setup::info::NoUnknownVersion);
+	
+	std::streamoff header_size = 0;
+	{
+		setup::info info;
+		ifs.seekg(offsets.header_offset);
+		info.load(ifs, entries);
+		header_size = std::streamoff(ifs.tellg()) - std::streamoff(offsets.header_offset);
+	}
+	
+	r.run("setup/info_load", boost::uint64_t(header_size), [&]() {
+		setup::info info;
+		ifs.clear();
+		ifs.seekg(offsets.header_offset);
+		info.load(ifs, entries);
+	});
+	
+	if(r.enabled("extract")) {
+		
+		class null_sink : public innoextract::sink, public innoextract::extract_callback {
+			
+		public:
+			
+			boost::uint64_t bytes;
+			size_t invalid;
+			
+			null_sink() : bytes(0), invalid(0) { }
+			
+			void write(const char * /* data */, size_t n) { bytes += n; }
+			
+			innoextract::sink * begin(size_t /* file */) { return this; }
+			
+			void end(size_t /* file */, bool valid) { invalid += !valid; }
+			
+		};
+		
+		boost::uint64_t total = 0;
+		{
+			innoextract::installer installer(file);
+			for(size_t i = 0; i < installer.file_count(); i++) {
+				if(!installer.is_locked(i)) {
+					total += installer.size(i);
+				}
+			}
+		}
+		
+		r.run("extract", total, [&]() {
+			innoextract::installer installer(file);
+			null_sink sink;
+			installer.extract_all(sink);
+			if(sink.invalid) {
+				throw std::runtime_error("Checksum mismatch while extracting");
+			}
+		});
+		
+	}
+	
+}
+
+} // anonymous namespace
+
+int main(int argc, char * argv[]) {
+	
+	color::init(color::disable, color::disable);
+	
+	po::options_description options_desc("Options");
+	options_desc.add_options()
+		("help,h", "Show supported options")
+		("filter,f", po::value<std::string>(), "Only run benchmarks containing this string")
+		("min-time", po::value<double>()->default_value(1.0), "Minimum time per benchmark in seconds")
+		("size", po::value<std::string>()->default_value("16M"), "Input size for micro-benchmarks")
+		("input,i", po::value<std::string>(), "Installer for the setup loading and extraction benchmarks")
+		("output,o", po::value<std::string>(), "Write JSON results to this file instead of stdout")
+	;
+	
+	po::variables_map options;
+	try {
+		po::store(po::parse_command_line(argc, argv, options_desc), options);
+		po::notify(options);
+	} catch(std::exception & e) {
+		std::cerr << "Error parsing command-line: " << e.what() << "\n\n" << options_desc;
+		return 1;
+	}
+	
+	if(options.count("help")) {
+		std::cout << "Usage: " << argv[0] << " [options]\n\n" << options_desc;
+		return 0;
+	}
+	
+	boost::uint64_t size;
+	if(!parse_bytes(options["size"].as<std::string>(), size) || size == 0) {
+		log_error << "Invalid --size: " << options["size"].as<std::string>();
+		return 1;
+	}
+	
+	std::string filter;
+	if(options.count("filter")) {
+		filter = options["filter"].as<std::string>();
+	}
+	runner r(filter, options["min-time"].as<double>());
+	
+	try {
+		
+		std::string data = tools::generate_data(size_t(size), 1);
+		
+		bench_decompression(r, data);
+		bench_filters(r, data);
+		bench_checksums(r, data);
+		bench_encoding(r, data);
+		
+		if(options.count("input")) {
+			bench_installer(r, options["input"].as<std::string>());
+		}
+		
+	} catch(const std::exception & e) {
+		log_error << e.what();
+		return 1;
+	}
+	
+	if(options.count("output")) {
+		std::ofstream ofs(options["output"].as<std::string>().c_str());
+		r.write_json(ofs);
+		if(!ofs) {
+			log_error << "Could not write results";
+			return 1;
+		}
+	} else {
+		r.write_json(std::cout);
+	}
+	
+	return 0;
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "tools/compress.hpp"
+
+#include <stdexcept>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include "configure.hpp"
+
+#if INNOEXTRACT_HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#include "util/endian.hpp"
+
+namespace io = boost::iostreams;
+
+namespace tools {
+
+namespace {
+
+#if INNOEXTRACT_HAVE_LZMA
+
+//! Smallest encodable LZMA2 dictionary size that is not smaller than the requested size.
+boost::uint8_t lzma2_dict_prop(boost::uint32_t dict_size, boost::uint32_t & actual) {
+	boost::uint8_t prop = 0;
+	while(prop < 40 && ((boost::uint32_t(2) | (prop & 1)) << (prop / 2 + 11)) < dict_size) {
+		prop++;
+	}
+	actual = (prop == 40) ? boost::uint32_t(-1)
+	                      : ((boost::uint32_t(2) | (prop & 1)) << (prop / 2 + 11));
+	return prop;
+}
+
+#endif
+
+} // anonymous namespace
+
+struct compressor::impl {
+	
+	stream::compression_method method;
+	
+	std::string buffer;
+	std::unique_ptr<io::filtering_ostream> os;
+	
+	#if INNOEXTRACT_HAVE_LZMA
+	lzma_options_lzma options;
+	lzma_stream strm;
+	
+	void code(const char * data, size_t size, lzma_action action, std::string & output) {
+		
+		strm.next_in = reinterpret_cast<const boost::uint8_t *>(data);
+		strm.avail_in = size;
+		
+		lzma_ret ret;
+		do {
+			boost::uint8_t out[8192];
+			strm.next_out = out;
+			strm.avail_out = sizeof(out);
+			ret = lzma_code(&strm, action);
+			output.append(reinterpret_cast<const char *>(out), sizeof(out) - strm.avail_out);
+		} while(ret == LZMA_OK && (strm.avail_in != 0 || (action == LZMA_FINISH)));
+		
+		if(ret != LZMA_OK && ret != LZMA_STREAM_END) {
+			throw std::runtime_error("LZMA compression failed");
+		}
+	}
+	#endif
+	
+	explicit impl(stream::compression_method m) : method(m) {
+		#if INNOEXTRACT_HAVE_LZMA
+		strm = LZMA_STREAM_INIT;
+		#endif
+	}
+	
+	~impl() {
+		#if INNOEXTRACT_HAVE_LZMA
+		lzma_end(&strm);
+		#endif
+	}
+	
+};
+
+compressor::compressor(stream::compression_method method, boost::uint32_t dict_size)
+	: impl_(new impl(method)) {
+	
+	switch(method) {
+		
+		case stream::Stored: return;
+		
+		case stream::Zlib: {
+			impl_->os.reset(new io::filtering_ostream);
+			impl_->os->push(io::zlib_compressor());
+			impl_->os->push(io::back_inserter(impl_->buffer));
+			return;
+		}
+		
+		case stream::BZip2: {
+			impl_->os.reset(new io::filtering_ostream);
+			impl_->os->push(io::bzip2_compressor());
+			impl_->os->push(io::back_inserter(impl_->buffer));
+			return;
+		}
+		
+		#if INNOEXTRACT_HAVE_LZMA
+		
+		case stream::LZMA1:
+		case stream::LZMA2: {
+			
+			lzma_vli filter;
+			if(method == stream::LZMA1) {
+				// Properties byte for lc=3 lp=0 pb=2 followed by the dictionary size
+				char header[5];
+				header[0] = char((2 * 5 + 0) * 9 + 3);
+				util::little_endian::store(dict_size, header + 1);
+				impl_->buffer.assign(header, sizeof(header));
+				filter = LZMA_FILTER_LZMA1;
+			} else {
+				impl_->buffer.assign(1, char(lzma2_dict_prop(dict_size, dict_size)));
+				filter = LZMA_FILTER_LZMA2;
+			}
+			
+			if(lzma_lzma_preset(&impl_->options, 1)) {
+				throw std::runtime_error("Could not initialize LZMA options");
+			}
+			impl_->options.dict_size = dict_size;
+			
+			const lzma_filter filters[2] = {
+				{ filter, &impl_->options }, { LZMA_VLI_UNKNOWN, NULL }
+			};
+			if(lzma_raw_encoder(&impl_->strm, filters) != LZMA_OK) {
+				throw std::runtime_error("Could not initialize LZMA encoder");
+			}
+			
+			return;
+		}
+		
+		#endif
+		
+		default: break;
+	}
+	
+	throw std::runtime_error("Unsupported compression method");
+}
+
+compressor::~compressor() { }
+
+void compressor::update(const char * data, size_t size, std::string & output) {
+	
+	output.append(impl_->buffer);
+	impl_->buffer.clear();
+	
+	switch(impl_->method) {
+		case stream::Stored: output.append(data, size); break;
+		case stream::Zlib:
+		case stream::BZip2: {
+			impl_->os->write(data, std::streamsize(size));
+			output.append(impl_->buffer);
+			impl_->buffer.clear();
+			break;
+		}
+		#if INNOEXTRACT_HAVE_LZMA
+		case stream::LZMA1:
+		case stream::LZMA2: {
+			if(size) {
+				impl_->code(data, size, LZMA_RUN, output);
+			}
+			break;
+		}
+		#endif
+		default: break;
+	}
+	
+}
+
+void compressor::finish(std::string & output) {
+	
+	output.append(impl_->buffer);
+	impl_->buffer.clear();
+	
+	switch(impl_->method) {
+		case stream::Zlib:
+		case stream::BZip2: {
+			impl_->os->reset();
+			output.append(impl_->buffer);
+			impl_->buffer.clear();
+			break;
+		}
+		#if INNOEXTRACT_HAVE_LZMA
+		case stream::LZMA1:
+		case stream::LZMA2: impl_->code(NULL, 0, LZMA_FINISH, output); break;
+		#endif
+		default: break;
+	}
+	
+}
+
+std::string compress(stream::compression_method method, const std::string & data,
+                     boost::uint32_t dict_size) {
+	
+	std::string result;
+	
+	compressor c(method, dict_size);
+	c.update(data.data(), data.size(), result);
+	c.finish(result);
+	
+	return result;
+}
+
+std::string generate_data(size_t size, boost::uint32_t seed) {
+	
+	static const char * const words[] = {
+		"setup", "file", "data", "install", "program", "windows", "system", "config",
+		"version", "resource", "string", "value", "\r\n", " = ", "0x", "    ",
+	};
+	
+	std::string result;
+	result.reserve(size);
+	
+	boost::uint32_t state = seed ? seed : 1;
+	while(result.size() < size) {
+		state = state * 1103515245u + 12345u;
+		boost::uint32_t r = state >> 8;
+		if((r & 3) == 0) {
+			// Incompressible bytes
+			for(size_t i = 0; i < 8; i++) {
+				state = state * 1103515245u + 12345u;
+				result.push_back(char(state >> 24));
+			}
+		} else {
+			result.append(words[(r >> 2) % (sizeof(words) / sizeof(*words))]);
+		}
+	}
+	
+	result.resize(size);
+	
+	return result;
+}
+
+} // namespace tools
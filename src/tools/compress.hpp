@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Compression in the formats read by \ref stream::chunk_reader, used by development tools.
+ */
+#ifndef INNOEXTRACT_TOOLS_COMPRESS_HPP
+#define INNOEXTRACT_TOOLS_COMPRESS_HPP
+
+#include <memory>
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+#include "stream/chunk.hpp"
+
+namespace tools {
+
+/*!
+ * Compress data for a chunk.
+ *
+ * The result does not include the chunk header.
+ *
+ * \param method    The compression method.
+ * \param data      The data to compress.
+ * \param dict_size Dictionary size for LZMA compression.
+ *
+ * \throws std::runtime_error if the method is not supported by this build.
+ */
+std::string compress(stream::compression_method method, const std::string & data,
+                     boost::uint32_t dict_size = boost::uint32_t(1) << 20);
+
+/*!
+ * Incrementally compress data for a chunk, for inputs that do not fit in memory.
+ *
+ * Produces the same format as \ref compress().
+ */
+class compressor {
+	
+public:
+	
+	/*!
+	 * \throws std::runtime_error if the method is not supported by this build.
+	 */
+	explicit compressor(stream::compression_method method,
+	                    boost::uint32_t dict_size = boost::uint32_t(1) << 20);
+	
+	~compressor();
+	
+	//! Compress more data and append any compressed output that is ready to \c output.
+	void update(const char * data, size_t size, std::string & output);
+	
+	//! Finish the compressed stream and append the remaining output to \c output.
+	void finish(std::string & output);
+	
+private:
+	
+	struct impl;
+	
+	std::unique_ptr<impl> impl_;
+	
+};
+
+/*!
+ * Generate test data that compresses roughly like typical installer contents.
+ *
+ * \param size Number of bytes to generate.
+ * \param seed Seed for the pseudo-random generator.
+ */
+std::string generate_data(size_t size, boost::uint32_t seed);
+
+} // namespace tools
+
+#endif // INNOEXTRACT_TOOLS_COMPRESS_HPP
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "tools/exefilter.hpp"
+
+namespace tools {
+
+void exe_encoder_4108::encode(char * data, size_t size) {
+	
+	for(size_t i = 0; i < size; i++, addr_offset++) {
+		
+		boost::uint8_t byte = boost::uint8_t(data[i]);
+		
+		if(addr_bytes_left == 0) {
+			
+			// Check if this is a CALL or JMP instruction.
+			if(byte == 0xe8 || byte == 0xe9) {
+				addr = addr_offset;
+				addr_bytes_left = 4;
+			}
+			
+		} else {
+			addr += byte;
+			data[i] = char(boost::uint8_t(addr));
+			addr >>= 8;
+			addr_bytes_left--;
+		}
+		
+	}
+	
+}
+
+void exe_encoder_5200::encode(const char * data, size_t size, std::string & output) {
+	
+	for(size_t i = 0; i < size; i++) {
+		
+		boost::uint8_t byte = boost::uint8_t(data[i]);
+		offset++;
+		
+		if(!in_address) {
+			
+			output.push_back(char(byte));
+			
+			// Check if this is a CALL or JMP instruction that does not span blocks.
+			if((byte == 0xe8 || byte == 0xe9) && block_size - ((offset - 1) % block_size) >= 5) {
+				in_address = true;
+				address_bytes = 0;
+			}
+			
+			continue;
+		}
+		
+		buffer[address_bytes++] = byte;
+		if(address_bytes != 4) {
+			continue;
+		}
+		
+		// Only addresses with a high byte of 0x00 or 0xff are transformed.
+		if(buffer[3] == 0x00 || buffer[3] == 0xff) {
+			
+			boost::uint32_t rel = buffer[0] | (boost::uint32_t(buffer[1]) << 8)
+			                                | (boost::uint32_t(buffer[2]) << 16);
+			boost::uint32_t addr = rel + (offset & 0xffffff);
+			buffer[0] = boost::uint8_t(addr);
+			buffer[1] = boost::uint8_t(addr >> 8);
+			buffer[2] = boost::uint8_t(addr >> 16);
+			
+			if(flip_high_byte && (rel & 0x800000)) {
+				buffer[3] = boost::uint8_t(~buffer[3]);
+			}
+			
+		}
+		
+		output.append(reinterpret_cast<const char *>(buffer), 4);
+		in_address = false;
+	}
+	
+}
+
+void exe_encoder_5200::finish(std::string & output) {
+	
+	// Addresses cut off by the end of the file are stored unchanged.
+	if(in_address) {
+		output.append(reinterpret_cast<const char *>(buffer), address_bytes);
+		in_address = false;
+	}
+	
+}
+
+} // namespace tools
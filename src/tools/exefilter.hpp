@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Encoders for the instruction filters undone by \ref stream::inno_exe_decoder_4108
+ * and \ref stream::inno_exe_decoder_5200.
+ */
+#ifndef INNOEXTRACT_TOOLS_EXEFILTER_HPP
+#define INNOEXTRACT_TOOLS_EXEFILTER_HPP
+
+#include <stddef.h>
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+namespace tools {
+
+//! Encoder for the instruction filter used by Inno Setup versions before 5.2.0.
+class exe_encoder_4108 {
+	
+public:
+	
+	exe_encoder_4108() : addr(0), addr_bytes_left(0), addr_offset(5) { }
+	
+	//! Filter the next part of a file in place.
+	void encode(char * data, size_t size);
+	
+private:
+	
+	boost::uint64_t addr;
+	size_t addr_bytes_left;
+	boost::uint32_t addr_offset;
+	
+};
+
+//! Encoder for the instruction filter used by Inno Setup 5.2.0 and newer.
+class exe_encoder_5200 {
+	
+public:
+	
+	/*!
+	 * \param flip_high_bytes true to toggle the high byte of backward addresses like
+	 *                        Inno Setup 5.3.9 and later.
+	 */
+	explicit exe_encoder_5200(bool flip_high_bytes)
+		: flip_high_byte(flip_high_bytes), offset(0), in_address(false), address_bytes(0) { }
+	
+	//! Filter the next part of a file and append the result to \c output.
+	void encode(const char * data, size_t size, std::string & output);
+	
+	//! Append any bytes held back at the end of a file to \c output.
+	void finish(std::string & output);
+	
+private:
+	
+	static const size_t block_size = 0x10000;
+	const bool flip_high_byte;
+	
+	boost::uint32_t offset; //! Total number of bytes consumed.
+	
+	bool in_address; //! Whether the next bytes are the address of a CALL or JMP instruction.
+	size_t address_bytes; //! Number of address bytes already in the buffer.
+	boost::uint8_t buffer[4];
+	
+};
+
+} // namespace tools
+
+#endif // INNOEXTRACT_TOOLS_EXEFILTER_HPP
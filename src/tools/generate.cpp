@@ -0,0 +1,764 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Generator for synthetic installers used in tests and benchmarks.
+ *
+ * The generated setup loader does not contain a runnable setup program - it only has the
+ * structures needed by innoextract.
+ */
+
+#include <stddef.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/program_options.hpp>
+
+#include "configure.hpp"
+
+#if INNOEXTRACT_HAVE_ARC4
+#include "crypto/arc4.hpp"
+#endif
+#include "crypto/hasher.hpp"
+#include "loader/offsets.hpp"
+#include "setup/data.hpp"
+#include "setup/file.hpp"
+#include "setup/header.hpp"
+#include "setup/info.hpp"
+#include "setup/version.hpp"
+#include "tools/compress.hpp"
+#include "tools/exefilter.hpp"
+#include "tools/writer.hpp"
+#include "util/console.hpp"
+#include "util/encoding.hpp"
+#include "util/fstream.hpp"
+#include "util/log.hpp"
+#include "util/output.hpp"
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+namespace {
+
+const char slice_magic[8] = { 'i', 'd', 's', 'k', 'a', '3', '2', 0x1a };
+const char chunk_magic[4] = { 'z', 'l', 'b', 0x1a };
+
+//! Offset of the setup data in single-file installers, after the loader table pointer.
+const boost::uint32_t embedded_data_offset = 0x40;
+
+//! Maximum size of the data that can be embedded in the setup loader.
+const boost::uint64_t max_embedded_size = 0x7fffffff - embedded_data_offset;
+
+struct generator_options {
+	
+	setup::version version;
+	
+	size_t files;
+	size_t unique; //!< Number of distinct file contents, or 0 if all files differ
+	boost::uint64_t min_size;
+	boost::uint64_t max_size;
+	size_t dirs;
+	
+	stream::compression_method compression;
+	boost::uint32_t dict_size;
+	
+	bool solid;
+	boost::uint64_t solid_break;
+	
+	std::string password;
+	
+	bool exe_filter;
+	
+	boost::uint64_t slice_size;
+	
+	boost::uint32_t seed;
+	
+	fs::path output;
+	
+};
+
+/*!
+ * Writes chunk data either after the loader header or to external setup-N.bin slice files.
+ */
+class data_writer {
+	
+public:
+	
+	//! Embed data in the setup loader, starting at the current position.
+	explicit data_writer(util::ofstream & ofs)
+		: os(&ofs), external(false), max_size(max_embedded_size), slice(0), pos(0) { }
+	
+	//! Write data to external slices with the given maximum size.
+	data_writer(const fs::path & installer, boost::uint64_t slice_size)
+		: os(&slice_file), external(true), max_size(slice_size), slice(0), pos(0),
+		  dir(installer.parent_path()), basename(installer.stem().string()) {
+		open_slice();
+	}
+	
+	~data_writer() {
+		close_slice();
+	}
+	
+	//! Start a new chunk and get its slice and offset.
+	void begin_chunk(boost::uint32_t & first_slice, boost::uint32_t & offset) {
+		
+		// Keep the chunk magic and salt in one slice
+		if(external && pos + 16 > max_size) {
+			next_slice();
+		}
+		
+		first_slice = slice;
+		offset = boost::uint32_t(pos);
+	}
+	
+	void write(const char * data, size_t size) {
+		
+		while(size) {
+			
+			if(pos == max_size) {
+				if(!external) {
+					throw std::runtime_error("Setup data too large to embed, use --slice-size");
+				}
+				next_slice();
+			}
+			
+			size_t n = size_t(std::min(boost::uint64_t(size), max_size - pos));
+			os->write(data, std::streamsize(n));
+			if(os->fail()) {
+				throw std::runtime_error("Could not write setup data");
+			}
+			
+			data += n, size -= n, pos += n;
+		}
+		
+	}
+	
+	//! Slice containing the last written byte.
+	boost::uint32_t last_slice() const { return slice; }
+	
+	void finish() {
+		close_slice();
+	}
+	
+private:
+	
+	void open_slice() {
+		
+		std::ostringstream oss;
+		oss << basename << '-' << (slice + 1) << ".bin";
+		
+		slice_file.open(dir / oss.str(), std::ios_base::out | std::ios_base::binary
+		                                | std::ios_base::trunc);
+		if(!slice_file.is_open()) {
+			throw std::runtime_error("Could not open slice \"" + (dir / oss.str()).string() + '"');
+		}
+		
+		slice_file.write(slice_magic, std::streamsize(sizeof(slice_magic)));
+		tools::store(slice_file, boost::uint32_t(0)); // slice size, updated when closing
+		pos = sizeof(slice_magic) + 4;
+	}
+	
+	void close_slice() {
+		
+		if(!slice_file.is_open()) {
+			return;
+		}
+		
+		slice_file.seekp(std::streamoff(sizeof(slice_magic)));
+		tools::store(slice_file, boost::uint32_t(pos));
+		slice_file.close();
+		if(slice_file.fail()) {
+			throw std::runtime_error("Could not write slice");
+		}
+	}
+	
+	void next_slice() {
+		close_slice();
+		slice++;
+		open_slice();
+	}
+	
+	std::ostream * os;
+	bool external;
+	boost::uint64_t max_size;
+	
+	boost::uint32_t slice;
+	boost::uint64_t pos; //!< Position in the current slice or relative to the embedded data.
+	
+	fs::path dir;
+	std::string basename;
+	util::ofstream slice_file;
+	
+};
+
+/*!
+ * Compresses, encrypts and writes the data for one chunk.
+ */
+class chunk_writer {
+	
+public:
+	
+	chunk_writer(data_writer & writer, const generator_options & o, const std::string & key,
+	             std::mt19937 & random)
+		: out(writer), compressor(o.compression, o.dict_size),
+		  encrypted(!key.empty()), uncompressed_size(0) {
+		
+		chunk.compression = o.compression;
+		chunk.encryption = key.empty() ? stream::Plaintext
+		                 : o.version >= INNO_VERSION(5, 3, 9) ? stream::ARC4_SHA1
+		                 : stream::ARC4_MD5;
+		chunk.size = 0;
+		
+		out.begin_chunk(chunk.first_slice, chunk.offset);
+		chunk.sort_offset = chunk.offset;
+		out.write(chunk_magic, sizeof(chunk_magic));
+		
+		if(encrypted) {
+			#if INNOEXTRACT_HAVE_ARC4
+			char salt[8];
+			for(char & c : salt) {
+				c = char(random());
+			}
+			out.write(salt, sizeof(salt));
+			crypto::hasher hasher(chunk.encryption == stream::ARC4_SHA1 ? crypto::SHA1 : crypto::MD5);
+			hasher.update(salt, sizeof(salt));
+			hasher.update(key.c_str(), key.length());
+			crypto::checksum checksum = hasher.finalize();
+			if(chunk.encryption == stream::ARC4_SHA1) {
+				arc4.init(checksum.sha1, sizeof(checksum.sha1));
+			} else {
+				arc4.init(checksum.md5, sizeof(checksum.md5));
+			}
+			arc4.discard(1000);
+			#else
+			(void)random;
+			throw std::runtime_error("ARC4 encryption not supported by this build");
+			#endif
+		}
+		
+	}
+	
+	void write(const char * data, size_t size) {
+		compressor.update(data, size, buffer);
+		uncompressed_size += size;
+		flush();
+	}
+	
+	//! Finish the chunk and get its location.
+	const stream::chunk & finish() {
+		compressor.finish(buffer);
+		flush();
+		chunk.last_slice = out.last_slice();
+		return chunk;
+	}
+	
+	//! Number of bytes written to the chunk before compression.
+	boost::uint64_t size() const { return uncompressed_size; }
+	
+private:
+	
+	void flush() {
+		if(buffer.empty()) {
+			return;
+		}
+		#if INNOEXTRACT_HAVE_ARC4
+		if(encrypted) {
+			arc4.crypt(&buffer[0], &buffer[0], buffer.size());
+		}
+		#endif
+		out.write(buffer.data(), buffer.size());
+		chunk.size += buffer.size();
+		buffer.clear();
+	}
+	
+	data_writer & out;
+	tools::compressor compressor;
+	
+	bool encrypted;
+	#if INNOEXTRACT_HAVE_ARC4
+	crypto::arc4 arc4;
+	#endif
+	
+	stream::chunk chunk;
+	boost::uint64_t uncompressed_size;
+	
+	std::string buffer;
+	
+};
+
+//! Write the contents of one file to a chunk and fill in its data entry.
+void write_file(chunk_writer & chunk, setup::data_entry & data, boost::uint64_t size,
+                boost::uint32_t seed, const setup::version & version) {
+	
+	const size_t block_size = 1 << 20;
+	
+	data.file.offset = chunk.size();
+	data.file.size = size;
+	data.uncompressed_size = size;
+	
+	crypto::hasher checksum(version >= INNO_VERSION(5, 3, 9) ? crypto::SHA1 : crypto::MD5);
+	
+	tools::exe_encoder_4108 encoder_4108;
+	tools::exe_encoder_5200 encoder_5200(data.file.filter == stream::InstructionFilter5309);
+	std::string filtered;
+	
+	for(boost::uint64_t pos = 0, block = 0; pos < size; pos += block_size, block++) {
+		
+		std::string buffer = tools::generate_data(size_t(std::min(size - pos, boost::uint64_t(block_size))),
+		                                          seed + boost::uint32_t(block) * 2654435761u);
+		checksum.update(buffer.data(), buffer.size());
+		
+		switch(data.file.filter) {
+			case stream::InstructionFilter4108: {
+				encoder_4108.encode(&buffer[0], buffer.size());
+				chunk.write(buffer.data(), buffer.size());
+				break;
+			}
+			case stream::InstructionFilter5200:
+			case stream::InstructionFilter5309: {
+				filtered.clear();
+				encoder_5200.encode(buffer.data(), buffer.size(), filtered);
+				chunk.write(filtered.data(), filtered.size());
+				break;
+			}
+			default: chunk.write(buffer.data(), buffer.size());
+		}
+		
+	}
+	
+	filtered.clear();
+	encoder_5200.finish(filtered);
+	chunk.write(filtered.data(), filtered.size());
+	
+	data.file.checksum = checksum.finalize();
+}
+
+void init_header(setup::header & header, const generator_options & o, size_t data_entries) {
+	
+	header.app_name = "Generated Setup";
+	header.app_versioned_name = "Generated Setup 1.0";
+	header.app_id = "Generated Setup";
+	header.app_version = "1.0";
+	header.default_dir_name = "{pf}\\Generated Setup";
+	header.default_group_name = "Generated Setup";
+	header.base_filename = o.output.stem().string();
+	header.uninstall_files_dir = "{app}";
+	
+	header.file_count = o.files;
+	header.data_entry_count = data_entries;
+	
+	header.winver.begin.win_version.major = 4;
+	header.winver.begin.nt_version.major = 5;
+	
+	header.password_salt = "PasswordCheckHash";
+	header.password_salt.resize(header.password_salt.size() + 8, '\0');
+	header.password.type = o.version >= INNO_VERSION(5, 3, 9) ? crypto::SHA1 : crypto::MD5;
+	std::memset(header.password.sha1, 0, sizeof(header.password.sha1));
+	
+	header.slices_per_disk = 1;
+	header.uninstall_log_mode = setup::header::AppendLog;
+	header.dir_exists_warning = setup::header::Auto;
+	header.privileges_required = setup::header::AdminPrivileges;
+	header.show_language_dialog = setup::header::Yes;
+	header.language_detection = setup::header::UILanguage;
+	header.compression = o.compression;
+	header.architectures_allowed = setup::header::architecture_types::all();
+	header.architectures_installed_in_64bit_mode = setup::header::architecture_types::all();
+	header.disable_dir_page = setup::header::Auto;
+	header.disable_program_group_page = setup::header::Auto;
+	
+	header.options |= setup::header::CreateAppDir;
+	header.options |= setup::header::AllowCancelDuringInstall;
+	if(o.version >= INNO_VERSION(5, 5, 0)) {
+		header.options |= setup::header::AllowNetworkDrive;
+	}
+	
+}
+
+std::string password_key(const std::string & password, setup::header & header,
+                         util::codepage_id codepage, std::mt19937 & random) {
+	
+	std::string key;
+	util::from_utf8(password, key, codepage);
+	
+	std::string::iterator salt = header.password_salt.end() - 8;
+	for(; salt != header.password_salt.end(); ++salt) {
+		*salt = char(random());
+	}
+	
+	crypto::hasher checksum(header.password.type);
+	checksum.update(header.password_salt.c_str(), header.password_salt.length());
+	checksum.update(key.c_str(), key.length());
+	header.password = checksum.finalize();
+	
+	header.options |= setup::header::Password;
+	header.options |= setup::header::EncryptionUsed;
+	
+	return key;
+}
+
+void save_headers(std::ostream & os, const setup::info & info) {
+	
+	std::ostringstream primary;
+	tools::save_header(primary, info.header, info.version, info.codepage);
+	for(const setup::file_entry & file : info.files) {
+		tools::save_file(primary, file, info);
+	}
+	
+	// Wizard images
+	if(info.version >= INNO_VERSION(5, 6, 0)) {
+		tools::store(primary, boost::uint32_t(0));
+		tools::store(primary, boost::uint32_t(0));
+	} else {
+		tools::store_string(primary, std::string());
+		tools::store_string(primary, std::string());
+	}
+	if(info.header.compression == stream::BZip2 || info.header.compression == stream::Zlib) {
+		tools::store_string(primary, std::string()); // decompressor dll
+	}
+	if(info.header.options & setup::header::EncryptionUsed) {
+		tools::store_string(primary, std::string()); // decrypt dll
+	}
+	
+	std::ostringstream secondary;
+	for(const setup::data_entry & data : info.data_entries) {
+		tools::save_data(secondary, data, info);
+	}
+	
+	tools::save_version(os, info.version);
+	tools::save_block(os, primary.str(), info.version);
+	tools::save_block(os, secondary.str(), info.version);
+}
+
+void generate(const generator_options & o) {
+	
+	// Separate generators so that file sizes do not depend on the layout
+	std::mt19937 size_random(o.seed);
+	std::mt19937 random(o.seed ^ 0x5a17u);
+	
+	setup::info info;
+	info.version = o.version;
+	info.codepage = o.version.is_unicode() ? util::cp_utf16le : util::cp_windows1252;
+	info.header = setup::header();
+	
+	init_header(info.header, o, o.files);
+	
+	std::string key;
+	if(!o.password.empty()) {
+		key = password_key(o.password, info.header, info.codepage, random);
+	}
+	
+	util::ofstream ofs(o.output, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if(!ofs.is_open()) {
+		throw std::runtime_error("Could not open \"" + o.output.string() + '"');
+	}
+	
+	// Setup loader stub with a pointer to the loader table at 0x30
+	char stub[embedded_data_offset];
+	std::memset(stub, 0, sizeof(stub));
+	stub[0] = 'M', stub[1] = 'Z';
+	std::memcpy(stub + 0x30, "Inno", 4);
+	ofs.write(stub, std::streamsize(sizeof(stub)));
+	
+	loader::offsets offsets = loader::offsets();
+	
+	std::unique_ptr<data_writer> writer;
+	if(o.slice_size) {
+		writer.reset(new data_writer(o.output, o.slice_size));
+	} else {
+		offsets.data_offset = boost::uint32_t(ofs.tellp());
+		writer.reset(new data_writer(ofs));
+	}
+	
+	stream::compression_filter filter = stream::NoFilter;
+	if(o.exe_filter) {
+		filter = o.version < INNO_VERSION(5, 2, 0) ? stream::InstructionFilter4108
+		       : o.version < INNO_VERSION(5, 3, 9) ? stream::InstructionFilter5200
+		       : stream::InstructionFilter5309;
+	}
+	
+	info.files.resize(o.files);
+	info.data_entries.resize(o.files);
+	
+	std::uniform_int_distribution<boost::uint64_t> sizes(o.min_size, o.max_size);
+	std::vector<boost::uint64_t> content_sizes;
+	
+	std::unique_ptr<chunk_writer> chunk;
+	size_t chunk_start = 0;
+	for(size_t i = 0; i <= o.files; i++) {
+		
+		if(chunk && (i == o.files || !o.solid || chunk->size() >= o.solid_break)) {
+			const stream::chunk & location = chunk->finish();
+			for(size_t j = chunk_start; j < i; j++) {
+				info.data_entries[j].chunk = location;
+			}
+			chunk.reset();
+		}
+		if(i == o.files) {
+			break;
+		}
+		if(!chunk) {
+			chunk.reset(new chunk_writer(*writer, o, key, random));
+			chunk_start = i;
+		}
+		
+		setup::file_entry & file = info.files[i];
+		std::ostringstream oss;
+		oss << "{app}\\";
+		if(o.dirs) {
+			oss << "dir" << (i % o.dirs) << '\\';
+		}
+		oss << "file" << i << ".bin";
+		file.destination = oss.str();
+		file.location = boost::uint32_t(i);
+		file.permission = -1;
+		file.options |= setup::file_entry::IgnoreVersion;
+		file.type = setup::file_entry::UserFile;
+		
+		setup::data_entry & data = info.data_entries[i];
+		data.file.filter = filter;
+		data.timestamp = 1577836800 + boost::int64_t(i);
+		data.options |= setup::data_entry::TimeStampInUTC;
+		if(filter != stream::NoFilter) {
+			data.options |= setup::data_entry::CallInstructionOptimized;
+		}
+		if(o.compression != stream::Stored) {
+			data.options |= setup::data_entry::ChunkCompressed;
+		}
+		if(!key.empty()) {
+			data.options |= setup::data_entry::ChunkEncrypted;
+		}
+		
+		size_t content = o.unique ? i % o.unique : i;
+		if(content == content_sizes.size()) {
+			content_sizes.push_back(sizes(size_random));
+		}
+		write_file(*chunk, data, content_sizes[content], o.seed ^ boost::uint32_t(content * 0x9e3779b9u),
+		           o.version);
+		
+	}
+	
+	writer->finish();
+	
+	offsets.header_offset = boost::uint32_t(ofs.tellp());
+	save_headers(ofs, info);
+	
+	boost::uint32_t table_offset = boost::uint32_t(ofs.tellp());
+	tools::save_offsets(ofs, offsets, o.version);
+	
+	ofs.seekp(0x34);
+	tools::store(ofs, table_offset);
+	tools::store(ofs, boost::uint32_t(~table_offset));
+	
+	ofs.close();
+	if(ofs.fail()) {
+		throw std::runtime_error("Could not write \"" + o.output.string() + '"');
+	}
+	
+}
+
+bool parse_version(const std::string & str, setup::version & version) {
+	
+	std::string name = str;
+	setup::version::flags variant = 0;
+	if(!name.empty() && (name[name.size() - 1] == 'u' || name[name.size() - 1] == 'U')) {
+		name.resize(name.size() - 1);
+		variant |= setup::version::Unicode;
+	}
+	
+	unsigned a, b, c;
+	char dot1, dot2;
+	std::istringstream iss(name);
+	if(!(iss >> a >> dot1 >> b >> dot2 >> c) || dot1 != '.' || dot2 != '.' || !iss.eof()
+	   || a > 255 || b > 255 || c > 255) {
+		return false;
+	}
+	if(INNO_VERSION(a, b, c) >= INNO_VERSION(6, 3, 0)) {
+		variant |= setup::version::Unicode;
+	}
+	
+	// Check that the version string is recognized
+	setup::version expected(boost::uint8_t(a), boost::uint8_t(b), boost::uint8_t(c), 0, variant);
+	std::ostringstream oss;
+	tools::save_version(oss, expected);
+	std::istringstream is(oss.str());
+	try {
+		version.load(is);
+	} catch(const setup::version_error &) {
+		return false;
+	}
+	
+	return version.value == expected.value && version.variant == expected.variant
+	       && tools::is_writable(version);
+}
+
+bool parse_compression(const std::string & str, stream::compression_method & method) {
+	
+	const stream::compression_method methods[] = {
+		stream::Stored, stream::Zlib, stream::BZip2, stream::LZMA1, stream::LZMA2
+	};
+	for(stream::compression_method m : methods) {
+		if(str == enum_names<stream::compression_method>::names[m]) {
+			method = m;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool parse_size_range(const std::string & str, boost::uint64_t & min, boost::uint64_t & max) {
+	
+	size_t sep = str.find(':');
+	if(!parse_bytes(str.substr(0, sep), min)) {
+		return false;
+	}
+	if(sep == std::string::npos) {
+		max = min;
+		return true;
+	}
+	
+	return parse_bytes(str.substr(sep + 1), max) && min <= max;
+}
+
+} // anonymous namespace
+
+int main(int argc, char * argv[]) {
+	
+	color::init(color::disable, color::disable);
+	
+	po::options_description options_desc("Options");
+	options_desc.add_options()
+		("help,h", "Show supported options")
+		("output,o", po::value<std::string>()->default_value("setup.exe"), "Setup loader to write")
+		("data-version", po::value<std::string>()->default_value("6.3.0"),
+		 "Setup data version, 5.1.0 or newer with a 'u' suffix for Unicode")
+		("files,n", po::value<size_t>()->default_value(100), "Number of files")
+		("file-size,s", po::value<std::string>()->default_value("64K"),
+		 "Size of each file, or a MIN:MAX range")
+		("dirs", po::value<size_t>()->default_value(0), "Distribute files over this many directories")
+		("unique", po::value<size_t>()->default_value(0),
+		 "Repeat this many distinct file contents, 0 for all distinct")
+		("compression,c", po::value<std::string>()->default_value("lzma2"),
+		 "Compression method: stored, zlib, bzip2, lzma1 or lzma2")
+		("dict-size", po::value<std::string>()->default_value("1M"), "LZMA dictionary size")
+		("solid", "Store multiple files in each chunk")
+		("solid-break", po::value<std::string>(), "Start a new solid chunk after this many bytes")
+		("password,p", po::value<std::string>(), "Encrypt chunks with this password")
+		("exe-filter", "Apply the instruction filter for executables to all files")
+		("slice-size", po::value<std::string>(),
+		 "Write data to external slices of this size instead of embedding it")
+		("seed", po::value<boost::uint32_t>()->default_value(1), "Seed for the generated data")
+	;
+	
+	po::variables_map options;
+	try {
+		po::store(po::parse_command_line(argc, argv, options_desc), options);
+		po::notify(options);
+	} catch(std::exception & e) {
+		std::cerr << "Error parsing command-line: " << e.what() << "\n\n" << options_desc;
+		return 1;
+	}
+	
+	if(options.count("help")) {
+		std::cout << "Usage: " << argv[0] << " [options]\n\n" << options_desc;
+		return 0;
+	}
+	
+	generator_options o;
+	
+	o.output = options["output"].as<std::string>();
+	
+	if(!parse_version(options["data-version"].as<std::string>(), o.version)) {
+		log_error << "Unsupported --data-version: " << options["data-version"].as<std::string>();
+		return 1;
+	}
+	
+	o.files = options["files"].as<size_t>();
+	if(!parse_size_range(options["file-size"].as<std::string>(), o.min_size, o.max_size)) {
+		log_error << "Invalid --file-size: " << options["file-size"].as<std::string>();
+		return 1;
+	}
+	o.dirs = options["dirs"].as<size_t>();
+	o.unique = options["unique"].as<size_t>();
+	
+	if(!parse_compression(options["compression"].as<std::string>(), o.compression)) {
+		log_error << "Invalid --compression: " << options["compression"].as<std::string>();
+		return 1;
+	}
+	if(o.compression == stream::LZMA2 && o.version < INNO_VERSION(5, 3, 9)) {
+		log_error << "LZMA2 compression requires data version 5.3.9 or newer";
+		return 1;
+	}
+	boost::uint64_t dict_size;
+	if(!parse_bytes(options["dict-size"].as<std::string>(), dict_size)
+	   || dict_size < 4096 || dict_size > boost::uint32_t(-1)) {
+		log_error << "Invalid --dict-size: " << options["dict-size"].as<std::string>();
+		return 1;
+	}
+	o.dict_size = boost::uint32_t(dict_size);
+	
+	o.solid = (options.count("solid") != 0);
+	o.solid_break = boost::uint64_t(-1);
+	if(options.count("solid-break")) {
+		if(!parse_bytes(options["solid-break"].as<std::string>(), o.solid_break)) {
+			log_error << "Invalid --solid-break: " << options["solid-break"].as<std::string>();
+			return 1;
+		}
+		o.solid = true;
+	}
+	
+	if(options.count("password")) {
+		o.password = options["password"].as<std::string>();
+	}
+	
+	o.exe_filter = (options.count("exe-filter") != 0);
+	
+	o.slice_size = 0;
+	if(options.count("slice-size")) {
+		if(!parse_bytes(options["slice-size"].as<std::string>(), o.slice_size)
+		   || o.slice_size < 1024 || o.slice_size > 0x7fffffff) {
+			log_error << "Invalid --slice-size: " << options["slice-size"].as<std::string>();
+			return 1;
+		}
+	}
+	
+	o.seed = options["seed"].as<boost::uint32_t>();
+	
+	try {
+		generate(o);
+	} catch(const std::exception & e) {
+		log_error << e.what();
+		return 1;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,587 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "tools/writer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "configure.hpp"
+
+#include "crypto/crc32.hpp"
+#include "loader/offsets.hpp"
+#include "setup/data.hpp"
+#include "setup/file.hpp"
+#include "setup/header.hpp"
+#include "setup/info.hpp"
+#include "setup/windows.hpp"
+#include "stream/chunk.hpp"
+#include "tools/compress.hpp"
+
+namespace tools {
+
+namespace {
+
+void store_checksum(std::ostream & os, const crypto::checksum & checksum,
+                    crypto::checksum_type type) {
+	
+	if(checksum.type != type) {
+		throw std::runtime_error("Unexpected checksum type");
+	}
+	
+	switch(type) {
+		case crypto::MD5: os.write(checksum.md5, std::streamsize(sizeof(checksum.md5))); break;
+		case crypto::SHA1: os.write(checksum.sha1, std::streamsize(sizeof(checksum.sha1))); break;
+		default: throw std::runtime_error("Unexpected checksum type");
+	}
+	
+}
+
+void save_windows_version(std::ostream & os, const setup::windows_version::data & data) {
+	store(os, boost::uint16_t(data.build));
+	store(os, boost::uint8_t(data.minor));
+	store(os, boost::uint8_t(data.major));
+}
+
+void save_windows_version_range(std::ostream & os, const setup::windows_version_range & range) {
+	const setup::windows_version * versions[] = { &range.begin, &range.end };
+	for(const setup::windows_version * version : versions) {
+		save_windows_version(os, version->win_version);
+		save_windows_version(os, version->nt_version);
+		store(os, boost::uint8_t(version->nt_service_pack.minor));
+		store(os, boost::uint8_t(version->nt_service_pack.major));
+	}
+}
+
+//! Store architecture flags in the order of stored_architectures_0 / stored_architectures_1.
+void save_architectures(std::ostream & os, setup::header::architecture_types types,
+                        const setup::version & version) {
+	
+	const setup::header::architecture_types::enum_type values[] = {
+		setup::header::ArchitectureUnknown, setup::header::X86, setup::header::Amd64,
+		setup::header::IA64, setup::header::ARM64,
+	};
+	size_t count = version >= INNO_VERSION(5, 6, 0) ? 5 : 4;
+	
+	boost::uint8_t bits = 0;
+	for(size_t i = 0; i < count; i++) {
+		if(types & values[i]) {
+			bits = boost::uint8_t(bits | (1 << i));
+		}
+	}
+	
+	store(os, bits);
+}
+
+} // anonymous namespace
+
+void store_string(std::ostream & os, const std::string & data) {
+	store(os, boost::uint32_t(data.size()));
+	os.write(data.data(), std::streamsize(data.size()));
+}
+
+void store_string(std::ostream & os, const std::string & utf8, util::codepage_id codepage) {
+	std::string encoded;
+	util::from_utf8(utf8, encoded, codepage);
+	store_string(os, encoded);
+}
+
+bool is_writable(const setup::version & version) {
+	return version.known && version >= INNO_VERSION(5, 1, 0) && version.bits() == 32
+	       && !version.is_isx() && version.d() == 0;
+}
+
+std::string version_name(const setup::version & version) {
+	
+	std::ostringstream oss;
+	oss << "Inno Setup Setup Data (" << version.a() << '.' << version.b() << '.' << version.c() << ')';
+	if(version.is_unicode() && version < INNO_VERSION(6, 3, 0)) {
+		oss << " (u)";
+	}
+	
+	return oss.str();
+}
+
+void save_version(std::ostream & os, const setup::version & version) {
+	
+	std::string name = version_name(version);
+	
+	char buffer[64];
+	std::memset(buffer, 0, sizeof(buffer));
+	std::memcpy(buffer, name.data(), std::min(name.size(), sizeof(buffer)));
+	
+	os.write(buffer, std::streamsize(sizeof(buffer)));
+}
+
+void save_offsets(std::ostream & os, const loader::offsets & offsets,
+                  const setup::version & version) {
+	
+	std::ostringstream table;
+	
+	if(version >= INNO_VERSION(5, 1, 5)) {
+		const char magic[12] = {
+			'r', 'D', 'l', 'P', 't', 'S', char(0xcd), char(0xe6), char(0xd7), '{', 0x0b, '*'
+		};
+		table.write(magic, std::streamsize(sizeof(magic)));
+		store(table, boost::uint32_t(1)); // revision
+	} else {
+		const char magic[12] = { 'r', 'D', 'l', 'P', 't', 'S', '0', '7', char(0x87), 'e', 'V', 'x' };
+		table.write(magic, std::streamsize(sizeof(magic)));
+	}
+	
+	store(table, boost::uint32_t(0));
+	store(table, offsets.exe_offset);
+	store(table, offsets.exe_uncompressed_size);
+	store(table, offsets.exe_checksum.crc32);
+	store(table, offsets.header_offset);
+	store(table, offsets.data_offset);
+	
+	std::string data = table.str();
+	
+	crypto::crc32 checksum;
+	checksum.init();
+	checksum.update(data.data(), data.size());
+	
+	os.write(data.data(), std::streamsize(data.size()));
+	store(os, checksum.finalize());
+}
+
+void save_header(std::ostream & os, const setup::header & header,
+                 const setup::version & version, util::codepage_id codepage) {
+	
+	store_string(os, header.app_name, codepage);
+	store_string(os, header.app_versioned_name, codepage);
+	store_string(os, header.app_id, codepage);
+	store_string(os, header.app_copyright, codepage);
+	store_string(os, header.app_publisher, codepage);
+	store_string(os, header.app_publisher_url, codepage);
+	if(version >= INNO_VERSION(5, 1, 13)) {
+		store_string(os, header.app_support_phone, codepage);
+	}
+	store_string(os, header.app_support_url, codepage);
+	store_string(os, header.app_updates_url, codepage);
+	store_string(os, header.app_version, codepage);
+	store_string(os, header.default_dir_name, codepage);
+	store_string(os, header.default_group_name, codepage);
+	store_string(os, header.base_filename, codepage);
+	if(version < INNO_VERSION(5, 2, 5)) {
+		store_string(os, header.license_text, util::cp_windows1252);
+		store_string(os, header.info_before, util::cp_windows1252);
+		store_string(os, header.info_after, util::cp_windows1252);
+	}
+	store_string(os, header.uninstall_files_dir, codepage);
+	store_string(os, header.uninstall_name, codepage);
+	store_string(os, header.uninstall_icon, codepage);
+	store_string(os, header.app_mutex, codepage);
+	store_string(os, header.default_user_name, codepage);
+	store_string(os, header.default_user_organisation, codepage);
+	store_string(os, header.default_serial, codepage);
+	if(version < INNO_VERSION(5, 2, 5)) {
+		store_string(os, header.compiled_code);
+	}
+	store_string(os, header.app_readme_file, codepage);
+	store_string(os, header.app_contact, codepage);
+	store_string(os, header.app_comments, codepage);
+	store_string(os, header.app_modify_path, codepage);
+	if(version >= INNO_VERSION(5, 3, 8)) {
+		store_string(os, header.create_uninstall_registry_key, codepage);
+	}
+	if(version >= INNO_VERSION(5, 3, 10)) {
+		store_string(os, header.uninstallable, codepage);
+	}
+	if(version >= INNO_VERSION(5, 5, 0)) {
+		store_string(os, header.close_applications_filter, codepage);
+	}
+	if(version >= INNO_VERSION(5, 5, 6)) {
+		store_string(os, header.setup_mutex, codepage);
+	}
+	if(version >= INNO_VERSION(5, 6, 1)) {
+		store_string(os, header.changes_environment, codepage);
+		store_string(os, header.changes_associations, codepage);
+	}
+	if(version >= INNO_VERSION(6, 3, 0)) {
+		store_string(os, header.architectures_allowed_1);
+		store_string(os, header.architectures_installed_in_64bit_mode_1);
+	}
+	if(version >= INNO_VERSION(5, 2, 5)) {
+		store_string(os, header.license_text, util::cp_windows1252);
+		store_string(os, header.info_before, util::cp_windows1252);
+		store_string(os, header.info_after, util::cp_windows1252);
+	}
+	if(version >= INNO_VERSION(5, 2, 1) && version < INNO_VERSION(5, 3, 10)) {
+		store_string(os, header.uninstaller_signature);
+	}
+	if(version >= INNO_VERSION(5, 2, 5)) {
+		store_string(os, header.compiled_code);
+	}
+	
+	if(!version.is_unicode()) {
+		char lead_bytes[32];
+		std::memset(lead_bytes, 0, sizeof(lead_bytes));
+		for(size_t i = 0; i < header.lead_bytes.size(); i++) {
+			if(header.lead_bytes[i]) {
+				lead_bytes[i / 8] = char(lead_bytes[i / 8] | (1 << (i % 8)));
+			}
+		}
+		os.write(lead_bytes, std::streamsize(sizeof(lead_bytes)));
+	}
+	
+	const size_t counts[] = {
+		header.language_count, header.message_count, header.permission_count,
+		header.type_count, header.component_count, header.task_count,
+		header.directory_count, header.file_count, header.data_entry_count,
+		header.icon_count, header.ini_entry_count, header.registry_entry_count,
+		header.delete_entry_count, header.uninstall_delete_entry_count,
+		header.run_entry_count, header.uninstall_run_entry_count,
+	};
+	for(size_t count : counts) {
+		store(os, boost::uint32_t(count));
+	}
+	
+	save_windows_version_range(os, header.winver);
+	
+	store(os, header.back_color);
+	store(os, header.back_color2);
+	if(version < INNO_VERSION(5, 5, 7)) {
+		store(os, header.image_back_color);
+	}
+	
+	if(version >= INNO_VERSION(6, 0, 0)) {
+		store(os, boost::uint8_t(header.wizard_style));
+		store(os, header.wizard_resize_percent_x);
+		store(os, header.wizard_resize_percent_y);
+	}
+	
+	if(version >= INNO_VERSION(5, 5, 7)) {
+		store(os, boost::uint8_t(header.image_alpha_format));
+	}
+	
+	store_checksum(os, header.password, version < INNO_VERSION(5, 3, 9) ? crypto::MD5 : crypto::SHA1);
+	const std::string salt_prefix = "PasswordCheckHash";
+	if(header.password_salt.size() != salt_prefix.size() + 8) {
+		throw std::runtime_error("Unexpected password salt size");
+	}
+	os.write(header.password_salt.data() + salt_prefix.size(), 8);
+	
+	store(os, header.extra_disk_space_required);
+	store(os, boost::uint32_t(header.slices_per_disk));
+	
+	store(os, boost::uint8_t(header.uninstall_log_mode));
+	store(os, boost::uint8_t(header.dir_exists_warning));
+	
+	store(os, boost::uint8_t(header.privileges_required));
+	
+	if(version >= INNO_VERSION(5, 7, 0)) {
+		boost::uint8_t overrides = 0;
+		if(header.privileges_required_override_allowed & setup::header::Commandline) {
+			overrides |= 1;
+		}
+		if(header.privileges_required_override_allowed & setup::header::Dialog) {
+			overrides |= 2;
+		}
+		store(os, overrides);
+	}
+	
+	// stored_bool_yes_no_auto
+	switch(header.show_language_dialog) {
+		case setup::header::Yes: store(os, boost::uint8_t(0)); break;
+		case setup::header::No: store(os, boost::uint8_t(1)); break;
+		case setup::header::Auto: store(os, boost::uint8_t(2)); break;
+	}
+	store(os, boost::uint8_t(header.language_detection));
+	
+	if(header.compression == stream::LZMA2 && version < INNO_VERSION(5, 3, 9)) {
+		throw std::runtime_error("LZMA2 compression requires data version 5.3.9 or newer");
+	}
+	store(os, boost::uint8_t(header.compression));
+	
+	if(version < INNO_VERSION(6, 3, 0)) {
+		save_architectures(os, header.architectures_allowed, version);
+		save_architectures(os, header.architectures_installed_in_64bit_mode, version);
+	}
+	
+	if(version >= INNO_VERSION(5, 2, 1) && version < INNO_VERSION(5, 3, 10)) {
+		store(os, header.signed_uninstaller_original_size);
+		store(os, header.signed_uninstaller_header_checksum);
+	}
+	
+	if(version >= INNO_VERSION(5, 3, 3)) {
+		store(os, boost::uint8_t(header.disable_dir_page));
+		store(os, boost::uint8_t(header.disable_program_group_page));
+	}
+	
+	if(version >= INNO_VERSION(5, 5, 0)) {
+		store(os, header.uninstall_display_size);
+	} else if(version >= INNO_VERSION(5, 3, 6)) {
+		store(os, boost::uint32_t(header.uninstall_display_size));
+	}
+	
+	stored_flag_writer<setup::header::flags> flagwriter(os, header.options);
+	
+	flagwriter.add(setup::header::DisableStartupPrompt);
+	if(version < INNO_VERSION(5, 3, 10)) {
+		flagwriter.add(setup::header::Uninstallable);
+	}
+	flagwriter.add(setup::header::CreateAppDir);
+	if(version < INNO_VERSION(5, 3, 3)) {
+		flagwriter.add(setup::header::DisableDirPage);
+		flagwriter.add(setup::header::DisableProgramGroupPage);
+	}
+	flagwriter.add(setup::header::AllowNoIcons);
+	flagwriter.add(setup::header::AlwaysRestart);
+	flagwriter.add(setup::header::AlwaysUsePersonalGroup);
+	flagwriter.add(setup::header::WindowVisible);
+	flagwriter.add(setup::header::WindowShowCaption);
+	flagwriter.add(setup::header::WindowResizable);
+	flagwriter.add(setup::header::WindowStartMaximized);
+	flagwriter.add(setup::header::EnableDirDoesntExistWarning);
+	flagwriter.add(setup::header::Password);
+	flagwriter.add(setup::header::AllowRootDirectory);
+	flagwriter.add(setup::header::DisableFinishedPage);
+	if(version < INNO_VERSION(5, 6, 1)) {
+		flagwriter.add(setup::header::ChangesAssociations);
+	}
+	if(version < INNO_VERSION(5, 3, 8)) {
+		flagwriter.add(setup::header::CreateUninstallRegKey);
+	}
+	flagwriter.add(setup::header::UsePreviousAppDir);
+	flagwriter.add(setup::header::BackColorHorizontal);
+	flagwriter.add(setup::header::UsePreviousGroup);
+	flagwriter.add(setup::header::UpdateUninstallLogAppName);
+	flagwriter.add(setup::header::UsePreviousSetupType);
+	flagwriter.add(setup::header::DisableReadyMemo);
+	flagwriter.add(setup::header::AlwaysShowComponentsList);
+	flagwriter.add(setup::header::FlatComponentsList);
+	flagwriter.add(setup::header::ShowComponentSizes);
+	flagwriter.add(setup::header::UsePreviousTasks);
+	flagwriter.add(setup::header::DisableReadyPage);
+	flagwriter.add(setup::header::AlwaysShowDirOnReadyPage);
+	flagwriter.add(setup::header::AlwaysShowGroupOnReadyPage);
+	flagwriter.add(setup::header::AllowUNCPath);
+	flagwriter.add(setup::header::UserInfoPage);
+	flagwriter.add(setup::header::UsePreviousUserInfo);
+	flagwriter.add(setup::header::UninstallRestartComputer);
+	flagwriter.add(setup::header::RestartIfNeededByRun);
+	flagwriter.add(setup::header::ShowTasksTreeLines);
+	flagwriter.add(setup::header::AllowCancelDuringInstall);
+	flagwriter.add(setup::header::WizardImageStretch);
+	flagwriter.add(setup::header::AppendDefaultDirName);
+	flagwriter.add(setup::header::AppendDefaultGroupName);
+	flagwriter.add(setup::header::EncryptionUsed);
+	if(version < INNO_VERSION(5, 6, 1)) {
+		flagwriter.add(setup::header::ChangesEnvironment);
+	}
+	if(version >= INNO_VERSION(5, 1, 7) && !version.is_unicode()) {
+		flagwriter.add(setup::header::ShowUndisplayableLanguages);
+	}
+	if(version >= INNO_VERSION(5, 1, 13)) {
+		flagwriter.add(setup::header::SetupLogging);
+	}
+	if(version >= INNO_VERSION(5, 2, 1)) {
+		flagwriter.add(setup::header::SignedUninstaller);
+	}
+	if(version >= INNO_VERSION(5, 3, 8)) {
+		flagwriter.add(setup::header::UsePreviousLanguage);
+	}
+	if(version >= INNO_VERSION(5, 3, 9)) {
+		flagwriter.add(setup::header::DisableWelcomePage);
+	}
+	if(version >= INNO_VERSION(5, 5, 0)) {
+		flagwriter.add(setup::header::CloseApplications);
+		flagwriter.add(setup::header::RestartApplications);
+		flagwriter.add(setup::header::AllowNetworkDrive);
+	}
+	if(version >= INNO_VERSION(5, 5, 7)) {
+		flagwriter.add(setup::header::ForceCloseApplications);
+	}
+	if(version >= INNO_VERSION(6, 0, 0)) {
+		flagwriter.add(setup::header::AppNameHasConsts);
+		flagwriter.add(setup::header::UsePreviousPrivileges);
+		flagwriter.add(setup::header::WizardResizable);
+	}
+	if(version >= INNO_VERSION(6, 3, 0)) {
+		flagwriter.add(setup::header::UninstallLogging);
+	}
+	
+	flagwriter.finish();
+	
+}
+
+void save_file(std::ostream & os, const setup::file_entry & entry, const setup::info & info) {
+	
+	const setup::version & version = info.version;
+	
+	store_string(os, entry.source, info.codepage);
+	store_string(os, entry.destination, info.codepage);
+	store_string(os, entry.install_font_name, info.codepage);
+	if(version >= INNO_VERSION(5, 2, 5)) {
+		store_string(os, entry.strong_assembly_name, info.codepage);
+	}
+	
+	store_string(os, entry.components, info.codepage);
+	store_string(os, entry.tasks, info.codepage);
+	store_string(os, entry.languages, info.codepage);
+	store_string(os, entry.check, info.codepage);
+	store_string(os, entry.after_install, info.codepage);
+	store_string(os, entry.before_install, info.codepage);
+	
+	save_windows_version_range(os, entry.winver);
+	
+	store(os, entry.location);
+	store(os, entry.attributes);
+	store(os, entry.external_size);
+	store(os, entry.permission);
+	
+	stored_flag_writer<setup::file_entry::flags> flagwriter(os, entry.options);
+	
+	flagwriter.add(setup::file_entry::ConfirmOverwrite);
+	flagwriter.add(setup::file_entry::NeverUninstall);
+	flagwriter.add(setup::file_entry::RestartReplace);
+	flagwriter.add(setup::file_entry::DeleteAfterInstall);
+	flagwriter.add(setup::file_entry::RegisterServer);
+	flagwriter.add(setup::file_entry::RegisterTypeLib);
+	flagwriter.add(setup::file_entry::SharedFile);
+	flagwriter.add(setup::file_entry::CompareTimeStamp);
+	flagwriter.add(setup::file_entry::FontIsNotTrueType);
+	flagwriter.add(setup::file_entry::SkipIfSourceDoesntExist);
+	flagwriter.add(setup::file_entry::OverwriteReadOnly);
+	flagwriter.add(setup::file_entry::OverwriteSameVersion);
+	flagwriter.add(setup::file_entry::CustomDestName);
+	flagwriter.add(setup::file_entry::OnlyIfDestFileExists);
+	flagwriter.add(setup::file_entry::NoRegError);
+	flagwriter.add(setup::file_entry::UninsRestartDelete);
+	flagwriter.add(setup::file_entry::OnlyIfDoesntExist);
+	flagwriter.add(setup::file_entry::IgnoreVersion);
+	flagwriter.add(setup::file_entry::PromptIfOlder);
+	flagwriter.add(setup::file_entry::DontCopy);
+	flagwriter.add(setup::file_entry::UninsRemoveReadOnly);
+	flagwriter.add(setup::file_entry::RecurseSubDirsExternal);
+	flagwriter.add(setup::file_entry::ReplaceSameVersionIfContentsDiffer);
+	flagwriter.add(setup::file_entry::DontVerifyChecksum);
+	flagwriter.add(setup::file_entry::UninsNoSharedFilePrompt);
+	flagwriter.add(setup::file_entry::CreateAllSubDirs);
+	if(version >= INNO_VERSION(5, 1, 2)) {
+		flagwriter.add(setup::file_entry::Bits32);
+		flagwriter.add(setup::file_entry::Bits64);
+	}
+	if(version >= INNO_VERSION(5, 2, 0)) {
+		flagwriter.add(setup::file_entry::ExternalSizePreset);
+		flagwriter.add(setup::file_entry::SetNtfsCompression);
+		flagwriter.add(setup::file_entry::UnsetNtfsCompression);
+	}
+	if(version >= INNO_VERSION(5, 2, 5)) {
+		flagwriter.add(setup::file_entry::GacInstall);
+	}
+	
+	flagwriter.finish();
+	
+	store(os, boost::uint8_t(entry.type));
+	
+}
+
+void save_data(std::ostream & os, const setup::data_entry & entry, const setup::info & info) {
+	
+	const setup::version & version = info.version;
+	
+	store(os, entry.chunk.first_slice);
+	store(os, entry.chunk.last_slice);
+	store(os, entry.chunk.offset);
+	store(os, entry.file.offset);
+	store(os, entry.file.size);
+	store(os, entry.chunk.size);
+	
+	store_checksum(os, entry.file.checksum, version < INNO_VERSION(5, 3, 9) ? crypto::MD5 : crypto::SHA1);
+	
+	static const boost::int64_t FiletimeOffset = 0x19DB1DED53E8000ll;
+	store(os, boost::int64_t(entry.timestamp * 10000000 + entry.timestamp_nsec / 100 + FiletimeOffset));
+	
+	store(os, boost::uint32_t(entry.file_version >> 32));
+	store(os, boost::uint32_t(entry.file_version));
+	
+	stored_flag_writer<setup::data_entry::flags> flagwriter(os, entry.options);
+	
+	flagwriter.add(setup::data_entry::VersionInfoValid);
+	flagwriter.add(setup::data_entry::VersionInfoNotValid);
+	flagwriter.add(setup::data_entry::TimeStampInUTC);
+	flagwriter.add(setup::data_entry::IsUninstallerExe);
+	flagwriter.add(setup::data_entry::CallInstructionOptimized);
+	flagwriter.add(setup::data_entry::Touch);
+	flagwriter.add(setup::data_entry::ChunkEncrypted);
+	flagwriter.add(setup::data_entry::ChunkCompressed);
+	if(version >= INNO_VERSION(5, 1, 13)) {
+		flagwriter.add(setup::data_entry::SolidBreak);
+	}
+	if(version >= INNO_VERSION(5, 5, 7) && version < INNO_VERSION(6, 3, 0)) {
+		flagwriter.add(setup::data_entry::Sign);
+		flagwriter.add(setup::data_entry::SignOnce);
+	}
+	
+	flagwriter.finish();
+	
+	if(version >= INNO_VERSION(6, 3, 0)) {
+		stored_flag_writer<setup::data_entry::sign> signwriter(os, entry.sign_options);
+		signwriter.add(setup::data_entry::NoSetting);
+		signwriter.add(setup::data_entry::Yes);
+		signwriter.add(setup::data_entry::Once);
+		signwriter.add(setup::data_entry::Check);
+		signwriter.finish();
+	}
+	
+}
+
+void save_block(std::ostream & os, const std::string & data, const setup::version & version) {
+	
+	#if INNOEXTRACT_HAVE_LZMA
+	std::string stored = compress(version >= INNO_VERSION(4, 1, 6) ? stream::LZMA1 : stream::Zlib, data);
+	bool compressed = true;
+	#else
+	std::string stored = (version >= INNO_VERSION(4, 1, 6)) ? data : compress(stream::Zlib, data);
+	bool compressed = (version < INNO_VERSION(4, 1, 6));
+	#endif
+	
+	// Split into 4 KiB sub-blocks, each prefixed with its CRC32 checksum
+	std::string blocks;
+	for(size_t pos = 0; pos < stored.size(); pos += 4096) {
+		size_t size = std::min(stored.size() - pos, size_t(4096));
+		crypto::crc32 checksum;
+		checksum.init();
+		checksum.update(stored.data() + pos, size);
+		char crc[4];
+		util::little_endian::store(checksum.finalize(), crc);
+		blocks.append(crc, sizeof(crc));
+		blocks.append(stored, pos, size);
+	}
+	
+	char header[5];
+	util::little_endian::store(boost::uint32_t(blocks.size()), header);
+	header[4] = char(compressed ? 1 : 0);
+	
+	crypto::crc32 checksum;
+	checksum.init();
+	checksum.update(header, sizeof(header));
+	
+	store(os, checksum.finalize());
+	os.write(header, std::streamsize(sizeof(header)));
+	os.write(blocks.data(), std::streamsize(blocks.size()));
+}
+
+} // namespace tools
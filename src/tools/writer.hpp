@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Functions to store setup data in the formats read by \ref setup::info::load and
+ * \ref loader::offsets::load, used to generate test installers.
+ *
+ * Only data versions supported by \ref tools::is_writable are handled.
+ */
+#ifndef INNOEXTRACT_TOOLS_WRITER_HPP
+#define INNOEXTRACT_TOOLS_WRITER_HPP
+
+#include <stddef.h>
+#include <ostream>
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+#include "setup/version.hpp"
+#include "util/encoding.hpp"
+#include "util/endian.hpp"
+#include "util/flags.hpp"
+
+namespace loader { struct offsets; }
+namespace setup {
+struct data_entry;
+struct file_entry;
+struct header;
+struct info;
+}
+
+namespace tools {
+
+//! Store an integer in little-endian byte order.
+template <class T>
+void store(std::ostream & os, T value) {
+	char buffer[sizeof(T)];
+	util::little_endian::store(value, buffer);
+	os.write(buffer, std::streamsize(sizeof(buffer)));
+}
+
+//! Store a length-prefixed string as is.
+void store_string(std::ostream & os, const std::string & data);
+
+//! Store a length-prefixed string converted from UTF-8 to the given codepage.
+void store_string(std::ostream & os, const std::string & utf8, util::codepage_id codepage);
+
+/*!
+ * Store flags in the packed format read by \ref stored_flag_reader.
+ *
+ * Flags must be added in the same order in which the reader expects them.
+ */
+template <class Enum>
+class stored_flag_writer {
+	
+public:
+	
+	typedef Enum enum_type;
+	typedef flags<enum_type> flag_type;
+	
+	stored_flag_writer(std::ostream & os, flag_type flag_values)
+		: stream(os), values(flag_values), pos(0), buffer(0), bytes(0) { }
+	
+	//! Declare the next possible flag.
+	void add(enum_type flag) {
+		
+		if(values & flag) {
+			buffer = boost::uint8_t(buffer | (1 << pos));
+		}
+		
+		if(++pos == 8) {
+			write_byte();
+		}
+	}
+	
+	//! Write out the remaining flags.
+	void finish() {
+		if(pos != 0) {
+			write_byte();
+		}
+		if(bytes == 3) {
+			// 3-byte sets are padded to 4 bytes
+			store(stream, boost::uint8_t(0));
+		}
+	}
+	
+private:
+	
+	void write_byte() {
+		store(stream, buffer);
+		buffer = 0, pos = 0, bytes++;
+	}
+	
+	std::ostream & stream;
+	flag_type values;
+	
+	size_t pos;
+	boost::uint8_t buffer;
+	
+	size_t bytes;
+	
+};
+
+template <class Enum>
+class stored_flag_writer<flags<Enum> > : public stored_flag_writer<Enum> {
+	
+public:
+	
+	stored_flag_writer(std::ostream & os, flags<Enum> flag_values)
+		: stored_flag_writer<Enum>(os, flag_values) { }
+	
+};
+
+//! Check if setup data for a version can be written by these functions.
+bool is_writable(const setup::version & version);
+
+//! Get the data version string that identifies a version.
+std::string version_name(const setup::version & version);
+
+//! Store the setup data version string.
+void save_version(std::ostream & os, const setup::version & version);
+
+/*!
+ * Store the setup loader table.
+ *
+ * The caller is responsible for storing a pointer to the table at offset 0x30.
+ */
+void save_offsets(std::ostream & os, const loader::offsets & offsets,
+                  const setup::version & version);
+
+void save_header(std::ostream & os, const setup::header & header,
+                 const setup::version & version, util::codepage_id codepage);
+
+void save_file(std::ostream & os, const setup::file_entry & entry, const setup::info & info);
+
+void save_data(std::ostream & os, const setup::data_entry & entry, const setup::info & info);
+
+/*!
+ * Store data as a compressed block read by \ref stream::block_reader.
+ *
+ * The block is compressed using LZMA1 if supported by this build.
+ */
+void save_block(std::ostream & os, const std::string & data, const setup::version & version);
+
+} // namespace tools
+
+#endif // INNOEXTRACT_TOOLS_WRITER_HPP
@@ -21,6 +21,7 @@
 #include "util/log.hpp"
 
 #include <iostream>
+#include <mutex>
 
 #include "util/console.hpp"
 
@@ -30,8 +31,17 @@ bool logger::quiet = false;
 size_t logger::total_errors = 0;
 size_t logger::total_warnings = 0;
 
+namespace {
+
+//! Keep lines from different threads apart
+std::mutex output_mutex;
+
+} // anonymous namespace
+
 logger::~logger() {
 	
+	std::lock_guard<std::mutex> lock(output_mutex);
+	
 	color::shell_command previous = color::current;
 	progress::clear();
 	
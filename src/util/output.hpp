@@ -26,10 +26,13 @@
 #ifndef INNOEXTRACT_UTIL_OUTPUT_HPP
 #define INNOEXTRACT_UTIL_OUTPUT_HPP
 
+#include <limits>
 #include <ostream>
+#include <sstream>
 #include <string>
 
 #include <boost/cstdint.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include "util/console.hpp"
 
@@ -58,6 +61,31 @@ inline std::ostream & operator<<(std::ostream & os, const quoted & q) {
 	return os << prev << '"';
 }
 
+//! Quote and escape a string for JSON output.
+struct json_string {
+	
+	const std::string & str;
+	
+	explicit json_string(const std::string & _str) : str(_str) { }
+	
+};
+
+inline std::ostream & operator<<(std::ostream & os, const json_string & s) {
+	const char * digits = "0123456789abcdef";
+	os << '"';
+	for(std::string::const_iterator i = s.str.begin(); i != s.str.end(); ++i) {
+		boost::uint8_t c = boost::uint8_t(*i);
+		if(c == '"' || c == '\\') {
+			os << '\\' << *i;
+		} else if(c < 0x20) {
+			os << "\\u00" << digits[c >> 4] << digits[c & 0xf];
+		} else {
+			os << *i;
+		}
+	}
+	return os << '"';
+}
+
 struct if_not_empty {
 	
 	const std::string & name;
@@ -240,4 +268,42 @@ detail::print_bytes<T> print_bytes(T value, int precision = 3) {
 	return detail::print_bytes<T>(value, precision);
 }
 
+/*!
+ * Parse a size in bytes with an optional unit suffix.
+ *
+ * Accepted units are B, K/KiB, M/MiB and G/GiB, with binary multiples.
+ *
+ * \return false if the string is not a valid size or the size does not fit in 64 bits.
+ */
+inline bool parse_bytes(const std::string & str, boost::uint64_t & result) {
+	
+	std::istringstream iss(str);
+	boost::uint64_t value;
+	if(!(iss >> value)) {
+		return false;
+	}
+	
+	std::string unit;
+	iss >> unit;
+	unsigned shift;
+	if(unit.empty() || boost::iequals(unit, "B")) {
+		shift = 0;
+	} else if(boost::iequals(unit, "K") || boost::iequals(unit, "KiB")) {
+		shift = 10;
+	} else if(boost::iequals(unit, "M") || boost::iequals(unit, "MiB")) {
+		shift = 20;
+	} else if(boost::iequals(unit, "G") || boost::iequals(unit, "GiB")) {
+		shift = 30;
+	} else {
+		return false;
+	}
+	
+	if(value > (std::numeric_limits<boost::uint64_t>::max() >> shift)) {
+		return false; // Too large to represent
+	}
+	result = value << shift;
+	
+	return iss.eof() || (iss >> std::ws).eof();
+}
+
 #endif // INNOEXTRACT_UTIL_OUTPUT_HPP
@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "util/outputbatch.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "configure.hpp"
+
+#if INNOEXTRACT_HAVE_IO_URING
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "util/log.hpp"
+
+namespace util {
+
+const size_t output_batch::max_file_size;
+const size_t output_batch::max_window;
+
+#if INNOEXTRACT_HAVE_IO_URING
+
+namespace {
+
+enum request_stage {
+	OpenRequest,
+	WriteRequest,
+	CloseRequest,
+};
+
+int io_uring_setup(unsigned entries, io_uring_params * params) {
+	return int(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+	return int(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0));
+}
+
+int io_uring_register(int fd, unsigned opcode, const void * arg, unsigned count) {
+	return int(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <typename T>
+T * ring_pointer(void * base, boost::uint32_t offset) {
+	return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+} // anonymous namespace
+
+struct output_batch::ring {
+	
+	int fd;
+	
+	void * sq_base;
+	size_t sq_size;
+	unsigned * sq_head;
+	unsigned * sq_tail;
+	unsigned sq_mask;
+	unsigned * sq_array;
+	io_uring_sqe * sqes;
+	size_t sqes_size;
+	
+	void * cq_base;
+	size_t cq_size;
+	unsigned * cq_head;
+	unsigned * cq_tail;
+	unsigned cq_mask;
+	io_uring_cqe * cqes;
+	
+	ring() : fd(-1), sq_base(MAP_FAILED), sq_size(0), sqes(static_cast<io_uring_sqe *>(MAP_FAILED)),
+	         sqes_size(0), cq_base(MAP_FAILED), cq_size(0) { }
+	
+	~ring() {
+		if(sqes != MAP_FAILED) {
+			munmap(sqes, sqes_size);
+		}
+		if(cq_base != MAP_FAILED && cq_base != sq_base) {
+			munmap(cq_base, cq_size);
+		}
+		if(sq_base != MAP_FAILED) {
+			munmap(sq_base, sq_size);
+		}
+		if(fd >= 0) {
+			::close(fd);
+		}
+	}
+	
+	bool setup(unsigned entries) {
+		
+		io_uring_params params;
+		std::memset(&params, 0, sizeof(params));
+		fd = io_uring_setup(entries, &params);
+		if(fd < 0) {
+			return false;
+		}
+		
+		// Opening files into fixed slots needs Linux 5.15, use a feature from 5.17 to detect it
+		if(!(params.features & IORING_FEAT_CQE_SKIP)) {
+			return false;
+		}
+		
+		sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if(params.features & IORING_FEAT_SINGLE_MMAP) {
+			sq_size = cq_size = std::max(sq_size, cq_size);
+		}
+		
+		sq_base = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		               fd, IORING_OFF_SQ_RING);
+		if(sq_base == MAP_FAILED) {
+			return false;
+		}
+		if(params.features & IORING_FEAT_SINGLE_MMAP) {
+			cq_base = sq_base;
+		} else {
+			cq_base = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			               fd, IORING_OFF_CQ_RING);
+			if(cq_base == MAP_FAILED) {
+				return false;
+			}
+		}
+		sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		sqes = static_cast<io_uring_sqe *>(mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+		                                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+		if(sqes == MAP_FAILED) {
+			return false;
+		}
+		
+		sq_head = ring_pointer<unsigned>(sq_base, params.sq_off.head);
+		sq_tail = ring_pointer<unsigned>(sq_base, params.sq_off.tail);
+		sq_mask = *ring_pointer<unsigned>(sq_base, params.sq_off.ring_mask);
+		sq_array = ring_pointer<unsigned>(sq_base, params.sq_off.array);
+		cq_head = ring_pointer<unsigned>(cq_base, params.cq_off.head);
+		cq_tail = ring_pointer<unsigned>(cq_base, params.cq_off.tail);
+		cq_mask = *ring_pointer<unsigned>(cq_base, params.cq_off.ring_mask);
+		cqes = ring_pointer<io_uring_cqe>(cq_base, params.cq_off.cqes);
+		
+		return true;
+	}
+	
+	//! Get the next submission queue entry - the caller must make sure there is space.
+	io_uring_sqe & next(boost::uint64_t user_data, boost::uint8_t opcode, boost::uint8_t flags) {
+		unsigned tail = *sq_tail;
+		unsigned index = tail & sq_mask;
+		io_uring_sqe & sqe = sqes[index];
+		std::memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = opcode;
+		sqe.flags = flags;
+		sqe.user_data = user_data;
+		sq_array[index] = index;
+		__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+		return sqe;
+	}
+	
+};
+
+output_batch::output_batch(const boost::filesystem::path & root)
+	: root_(root), ring_(NULL), unsubmitted_(0) { }
+
+output_batch::~output_batch() {
+	try {
+		flush();
+	} catch(...) {
+		// Only reached if extraction has already failed
+	}
+	delete ring_;
+}
+
+bool output_batch::open(size_t window) {
+	
+	window = std::min(std::max(window, size_t(1)), max_window);
+	
+	// Each file needs three entries and may not be submitted right away
+	unsigned entries = 1;
+	while(entries < 3 * window) {
+		entries *= 2;
+	}
+	
+	ring * result = new ring;
+	if(!result->setup(entries)) {
+		delete result;
+		return false;
+	}
+	
+	// Files are opened into a fixed slot so that the write and close can be linked to the open
+	std::vector<int> files(window, -1);
+	if(io_uring_register(result->fd, IORING_REGISTER_FILES, &files.front(), unsigned(window)) != 0) {
+		delete result;
+		return false;
+	}
+	
+	ring_ = result;
+	slots_.resize(window);
+	free_.clear();
+	free_.reserve(window);
+	for(size_t i = window; i > 0; i--) {
+		free_.push_back(i - 1);
+	}
+	
+	return true;
+}
+
+void output_batch::submit(bool wait) {
+	
+	for(;;) {
+		
+		unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+		int submitted = io_uring_enter(ring_->fd, unsigned(unsubmitted_), wait ? 1 : 0, flags);
+		
+		if(submitted < 0) {
+			if(errno == EINTR) {
+				continue;
+			} else if(errno != EAGAIN && errno != EBUSY) {
+				throw std::runtime_error("Could not submit output files");
+			}
+			// Completions must be consumed before more requests can be submitted
+			reap();
+			if(io_uring_enter(ring_->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+				throw std::runtime_error("Could not wait for output files");
+			}
+			continue;
+		}
+		
+		unsubmitted_ -= std::min(unsubmitted_, size_t(submitted));
+		if(unsubmitted_ == 0) {
+			return;
+		}
+		
+	}
+	
+}
+
+void output_batch::reap() {
+	
+	unsigned head = *ring_->cq_head;
+	unsigned tail = __atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE);
+	
+	for(; head != tail; head++) {
+		
+		const io_uring_cqe & cqe = ring_->cqes[head & ring_->cq_mask];
+		slot & file = slots_[size_t(cqe.user_data >> 2)];
+		request_stage stage = request_stage(cqe.user_data & 3);
+		
+		int error = 0;
+		if(stage == OpenRequest && cqe.res == -EEXIST && file.exclusive) {
+			// Retried once the other requests for the file have been canceled
+			file.exists = true;
+		} else if(cqe.res < 0 && cqe.res != -ECANCELED) {
+			error = -cqe.res;
+		} else if(stage == WriteRequest && cqe.res >= 0 && size_t(cqe.res) != file.data.size()) {
+			error = EIO;
+		}
+		if(error && !file.error) {
+			file.error = error;
+			switch(stage) {
+				case OpenRequest: file.operation = "open"; break;
+				case WriteRequest: file.operation = "write"; break;
+				case CloseRequest: file.operation = "close"; break;
+			}
+		}
+		
+		if(--file.pending != 0) {
+			continue;
+		}
+		
+		size_t index = size_t(&file - &slots_.front());
+		if(file.exists && !file.error) {
+			// Files are first created exclusively so that there is no need to check if they
+			// already exist - most output directories are empty
+			struct stat buf;
+			if(::fstatat(file.directory, file.path.c_str() + file.name, &buf, AT_SYMLINK_NOFOLLOW) == 0
+			   && S_ISREG(buf.st_mode) && buf.st_nlink > 1) {
+				// Replace hard-linked files instead of writing to all links, like output_tree
+				::unlinkat(file.directory, file.path.c_str() + file.name, 0);
+			}
+			file.exclusive = false;
+			file.exists = false;
+			queue(index);
+		} else {
+			complete(file);
+		}
+	
+	}
+	
+	__atomic_store_n(ring_->cq_head, head, __ATOMIC_RELEASE);
+	
+	if(!error_.empty()) {
+		std::string error;
+		error.swap(error_);
+		throw std::runtime_error(error);
+	}
+	
+}
+
+void output_batch::complete(slot & file) {
+	
+	if(file.error) {
+		if(error_.empty()) {
+			std::ostringstream oss;
+			oss << "Could not " << file.operation << " output file \"" << (root_ / file.path).string()
+			    << "\": " << std::strerror(file.error);
+			error_ = oss.str();
+		}
+	} else if(file.set_time) {
+		struct timespec timens[2];
+		timens[0].tv_sec = time_t(file.sec);
+		timens[0].tv_nsec = boost::int32_t(file.nsec);
+		timens[1] = timens[0];
+		if(time(timens[0].tv_sec) != file.sec
+		   || utimensat(file.directory, file.path.c_str() + file.name, timens, 0) != 0) {
+			log_warning << "Error setting timestamp on file " << (root_ / file.path);
+		}
+	}
+	
+	free_.push_back(size_t(&file - &slots_.front()));
+}
+
+void output_batch::write(int directory, const std::string & path, size_t name,
+                         std::vector<char> & data, bool set_time, time sec,
+                         boost::uint32_t nsec) {
+	
+	reap();
+	while(free_.empty()) {
+		submit(true);
+		reap();
+	}
+	
+	size_t index = free_.back();
+	free_.pop_back();
+	
+	slot & file = slots_[index];
+	file.path = path;
+	file.name = name;
+	file.directory = directory;
+	file.data.swap(data);
+	data.clear();
+	file.set_time = set_time;
+	file.sec = sec;
+	file.nsec = nsec;
+	file.exclusive = true;
+	file.exists = false;
+	file.error = 0;
+	file.operation = NULL;
+	
+	queue(index);
+	
+	// Submit in a few steps per window so that the kernel can start while more files are queued
+	if(unsubmitted_ >= std::max(size_t(3), slots_.size() / 4 * 3)) {
+		submit(false);
+	}
+	
+}
+
+void output_batch::queue(size_t index) {
+	
+	slot & file = slots_[index];
+	file.pending = 3;
+	
+	boost::uint64_t id = boost::uint64_t(index) << 2;
+	
+	io_uring_sqe & open = ring_->next(id | OpenRequest, IORING_OP_OPENAT, IOSQE_IO_LINK);
+	open.fd = file.directory;
+	open.addr = boost::uint64_t(reinterpret_cast<uintptr_t>(file.path.c_str() + file.name));
+	open.len = 0666;
+	// O_CLOEXEC is not allowed for fixed files
+	open.open_flags = O_CREAT | O_WRONLY | (file.exclusive ? O_EXCL : O_TRUNC);
+	open.file_index = boost::uint32_t(index + 1);
+	
+	// Close the file even if writing it fails
+	io_uring_sqe & write = ring_->next(id | WriteRequest, IORING_OP_WRITE,
+	                                   IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK);
+	write.fd = int(index);
+	write.addr = boost::uint64_t(reinterpret_cast<uintptr_t>(file.data.empty() ? NULL : &file.data.front()));
+	write.len = boost::uint32_t(file.data.size());
+	write.off = 0;
+	
+	io_uring_sqe & close = ring_->next(id | CloseRequest, IORING_OP_CLOSE, 0);
+	close.file_index = boost::uint32_t(index + 1);
+	
+	unsubmitted_ += 3;
+	
+}
+
+void output_batch::flush() {
+	
+	if(!ring_) {
+		return;
+	}
+	
+	while(busy()) {
+		submit(true);
+		reap();
+	}
+	
+}
+
+#else // !INNOEXTRACT_HAVE_IO_URING
+
+struct output_batch::ring { };
+
+output_batch::output_batch(const boost::filesystem::path & root)
+	: root_(root), ring_(NULL), unsubmitted_(0) { }
+
+output_batch::~output_batch() { }
+
+bool output_batch::open(size_t window) {
+	(void)window;
+	return false;
+}
+
+void output_batch::queue(size_t index) {
+	(void)index;
+}
+
+void output_batch::submit(bool wait) {
+	(void)wait;
+}
+
+void output_batch::reap() { }
+
+void output_batch::complete(slot & file) {
+	(void)file;
+}
+
+void output_batch::write(int directory, const std::string & path, size_t name,
+                         std::vector<char> & data, bool set_time, time sec,
+                         boost::uint32_t nsec) {
+	(void)directory, (void)path, (void)name, (void)data, (void)set_time, (void)sec, (void)nsec;
+	throw std::runtime_error("Batched output is not supported");
+}
+
+void output_batch::flush() { }
+
+#endif // !INNOEXTRACT_HAVE_IO_URING
+
+} // namespace util
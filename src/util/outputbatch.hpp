@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Asynchronous creation of many small output files.
+ */
+#ifndef INNOEXTRACT_UTIL_OUTPUTBATCH_HPP
+#define INNOEXTRACT_UTIL_OUTPUTBATCH_HPP
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include "util/time.hpp"
+
+namespace util {
+
+/*!
+ * Creates small files in batches using Linux io_uring.
+ *
+ * Opening, writing and closing each file is submitted to the kernel as one linked
+ * request, so that many files only need a few system calls. The file time is set once
+ * the file has been closed.
+ *
+ * Only a bounded number of files are in flight at the same time - queueing another file
+ * waits for earlier ones to complete.
+ */
+class output_batch : private boost::noncopyable {
+	
+	struct ring;
+	
+	struct slot {
+		
+		std::string path;
+		size_t name; //!< Offset of the file name in the path
+		int directory;
+		std::vector<char> data;
+		
+		bool set_time;
+		time sec;
+		boost::uint32_t nsec;
+		
+		bool exclusive; //!< Only create the file if it does not exist yet
+		bool exists; //!< The file could not be created exclusively
+		int pending; //!< Number of outstanding completions
+		int error;
+		const char * operation; //!< Operation that failed
+		
+	};
+	
+	boost::filesystem::path root_;
+	ring * ring_;
+	std::vector<slot> slots_;
+	std::vector<size_t> free_;
+	size_t unsubmitted_; //!< Number of queued files not yet submitted to the kernel
+	std::string error_;
+	
+	void queue(size_t index);
+	void submit(bool wait);
+	void reap();
+	void complete(slot & file);
+	
+public:
+	
+	//! Largest file that should be written using a batch.
+	static const size_t max_file_size = size_t(256) << 10;
+	
+	//! Maximum number of files in flight.
+	static const size_t max_window = 1024;
+	
+	//! \param root Directory relative paths are reported relative to.
+	explicit output_batch(const boost::filesystem::path & root);
+	
+	//! Wait for all files, ignoring any errors.
+	~output_batch();
+	
+	/*!
+	 * Set up io_uring.
+	 *
+	 * \param window Number of files that can be in flight at the same time.
+	 *
+	 * \return false if io_uring is not supported by the build or the running kernel.
+	 */
+	bool open(size_t window);
+	
+	bool is_open() const { return ring_ != NULL; }
+	
+	/*!
+	 * Queue a file to be created or truncated and written.
+	 *
+	 * Existing files that are hard-linked elsewhere are replaced instead of truncated.
+	 *
+	 * \param directory Handle of the directory to create the file in. It must remain open
+	 *                  until the file has been written - see \ref flush().
+	 * \param path      Path of the file relative to the root directory.
+	 * \param name      Offset of the file name in \c path.
+	 * \param data      Contents of the file. This is swapped with an unused buffer.
+	 * \param set_time  Set the file time once the file has been written.
+	 * \param sec       File time to set (in seconds).
+	 * \param nsec      Sub-second component of the file time to set (in nanoseconds).
+	 *
+	 * \throws std::runtime_error if a previously queued file could not be written.
+	 */
+	void write(int directory, const std::string & path, size_t name, std::vector<char> & data,
+	           bool set_time, time sec, boost::uint32_t nsec);
+	
+	/*!
+	 * Wait for all queued files to be written.
+	 *
+	 * \throws std::runtime_error if a file could not be written.
+	 */
+	void flush();
+	
+	//! \return true if there are files that have not been written yet.
+	bool busy() const { return free_.size() != slots_.size(); }
+	
+};
+
+} // namespace util
+
+#endif // INNOEXTRACT_UTIL_OUTPUTBATCH_HPP
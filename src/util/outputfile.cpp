@@ -0,0 +1,462 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "util/outputfile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "configure.hpp"
+
+#if INNOEXTRACT_HAVE_PWRITE
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if INNOEXTRACT_HAVE_PWRITE && INNOEXTRACT_HAVE_MMAP && INNOEXTRACT_HAVE_FALLOCATE
+#include <sys/mman.h>
+#define INNOEXTRACT_OUTPUT_FILE_MAP 1
+#else
+#define INNOEXTRACT_OUTPUT_FILE_MAP 0
+#endif
+
+#include "util/align.hpp"
+
+namespace io = boost::iostreams;
+
+namespace util {
+
+namespace {
+
+//! Drop written data from the page cache after this many bytes.
+const boost::uint64_t drop_cache_interval = boost::uint64_t(32) << 20;
+
+} // anonymous namespace
+
+const size_t output_file::default_buffer_size;
+const size_t output_file::block_size;
+const boost::uint64_t output_file::min_map_size;
+
+output_file::output_file()
+	: storage_size_(0)
+	, buffer_(NULL)
+	, buffer_size_(0)
+	, buffered_(0)
+	, buffer_offset_(0)
+	, mode_(KeepCache)
+	, direct_(false)
+	, unsynced_(0)
+	, good_(true)
+	, mapping_(NULL)
+	, mapping_size_(0)
+	, end_(0)
+{ }
+
+output_file::~output_file() {
+	try {
+		close();
+	} catch(...) {
+		// Errors have already been reported by earlier calls
+	}
+}
+
+void output_file::open(const io::file_descriptor & file, boost::uint64_t size_hint,
+                       size_t buffer_size, output_cache_mode mode) {
+	
+	close();
+	
+	file_ = file;
+	mode_ = mode;
+	good_ = true;
+	buffered_ = 0;
+	buffer_offset_ = 0;
+	unsynced_ = 0;
+	direct_ = false;
+	
+	// Don't allocate a large buffer for small files
+	buffer_size = std::max(buffer_size, block_size);
+	if(size_hint < buffer_size) {
+		buffer_size = size_t(size_hint);
+	}
+	buffer_size_ = std::max(block_size, (buffer_size + block_size - 1) / block_size * block_size);
+	
+	if(storage_size_ < buffer_size_ + block_size) {
+		storage_.reset(); // Don't hold both buffers at once
+		storage_size_ = buffer_size_ + block_size;
+		storage_.reset(new char[storage_size_]);
+	}
+	buffer_ = storage_.get();
+	while(!is_aligned_on(buffer_, block_size)) {
+		buffer_++;
+	}
+	
+	#if !INNOEXTRACT_HAVE_O_DIRECT
+	if(mode_ == DirectIO) {
+		mode_ = DropCache;
+	}
+	#endif
+	
+}
+
+bool output_file::set_direct(bool enable) {
+	
+	if(enable == direct_) {
+		return true;
+	}
+	
+	#if INNOEXTRACT_HAVE_O_DIRECT
+	int flags = fcntl(file_.handle(), F_GETFL);
+	if(flags != -1) {
+		flags = enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+		if(fcntl(file_.handle(), F_SETFL, flags) == 0) {
+			direct_ = enable;
+			return true;
+		}
+	}
+	#endif
+	
+	if(enable) {
+		// Not supported for this file - don't try again
+		mode_ = DropCache;
+	}
+	
+	return false;
+}
+
+bool output_file::write_at(const char * data, size_t n, boost::uint64_t offset) {
+	
+	#if INNOEXTRACT_HAVE_PWRITE
+	
+	while(n != 0) {
+		ssize_t written = pwrite(file_.handle(), data, n, off_t(offset));
+		if(written < 0 && errno == EINTR) {
+			continue;
+		}
+		if(written < 0 && direct_ && errno == EINVAL) {
+			// The filesystem does not support direct I/O after all
+			set_direct(false);
+			mode_ = DropCache;
+			continue;
+		}
+		if(written <= 0) {
+			return (good_ = false);
+		}
+		data += written, n -= size_t(written), offset += boost::uint64_t(written);
+		unsynced_ += boost::uint64_t(written);
+	}
+	
+	#else
+	
+	try {
+		file_.seek(io::stream_offset(offset), std::ios_base::beg);
+		file_.write(data, std::streamsize(n));
+		unsynced_ += n;
+	} catch(...) {
+		return (good_ = false);
+	}
+	
+	#endif
+	
+	return true;
+}
+
+bool output_file::flush_buffer(bool all) {
+	
+	if(buffered_ == 0) {
+		return good_;
+	}
+	
+	size_t written = 0;
+	
+	if(mode_ == DirectIO) {
+		size_t misalignment = size_t(buffer_offset_ % block_size);
+		if(misalignment != 0 && !all) {
+			// Write up to the next block boundary so that the remaining data can use direct I/O
+			written = std::min(buffered_, block_size - misalignment);
+			set_direct(false);
+			write_at(buffer_, written, buffer_offset_);
+		} else if(misalignment == 0) {
+			written = buffered_ - buffered_ % block_size;
+			if(written != 0) {
+				if(set_direct(true)) {
+					write_at(buffer_, written, buffer_offset_);
+				} else {
+					written = 0;
+				}
+			}
+		}
+	}
+	
+	if(all || mode_ != DirectIO) {
+		if(written != buffered_) {
+			set_direct(false);
+			write_at(buffer_ + written, buffered_ - written, buffer_offset_ + written);
+		}
+		written = buffered_;
+	}
+	
+	// Keep any data we could not write yet at the start of the aligned buffer
+	if(written != buffered_) {
+		std::memmove(buffer_, buffer_ + written, buffered_ - written);
+	}
+	buffered_ -= written;
+	buffer_offset_ += written;
+	
+	drop_cache(false);
+	
+	return good_;
+}
+
+void output_file::drop_cache(bool force) {
+	
+	if(mode_ == KeepCache || unsynced_ == 0 || (!force && unsynced_ < drop_cache_interval)) {
+		return;
+	}
+	
+	unsynced_ = 0;
+	
+	#if INNOEXTRACT_HAVE_POSIX_FADVISE && INNOEXTRACT_HAVE_FDATASYNC
+	// Dirty pages cannot be evicted so write them back first
+	if(fdatasync(file_.handle()) == 0) {
+		(void)posix_fadvise(file_.handle(), 0, 0, POSIX_FADV_DONTNEED);
+	}
+	#endif
+	
+}
+
+bool output_file::map(boost::uint64_t size) {
+	
+	#if INNOEXTRACT_OUTPUT_FILE_MAP
+	
+	if(mapping_ || mode_ != KeepCache || tell() != 0 || size == 0
+	   || size > boost::uint64_t(std::numeric_limits<size_t>::max())
+	   || size > boost::uint64_t(std::numeric_limits<off_t>::max())) {
+		return false;
+	}
+	
+	// Writes to the mapping can't report errors, so make sure there is enough space
+	if(fallocate(file_.handle(), 0, 0, off_t(size)) != 0) {
+		return false;
+	}
+	
+	void * mapping = mmap(NULL, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, file_.handle(), 0);
+	if(mapping == MAP_FAILED) {
+		if(ftruncate(file_.handle(), 0) != 0) {
+			good_ = false;
+		}
+		return false;
+	}
+	
+	mapping_ = static_cast<char *>(mapping);
+	mapping_size_ = size;
+	end_ = 0;
+	
+	return true;
+	
+	#else
+	
+	(void)size;
+	
+	return false;
+	
+	#endif
+	
+}
+
+void output_file::unmap() {
+	
+	#if INNOEXTRACT_OUTPUT_FILE_MAP
+	
+	if(!mapping_) {
+		return;
+	}
+	
+	munmap(mapping_, size_t(mapping_size_));
+	mapping_ = NULL;
+	
+	// Remove space that was allocated for data that never came
+	if(end_ < mapping_size_ && ftruncate(file_.handle(), off_t(end_)) != 0) {
+		good_ = false;
+	}
+	
+	#endif
+	
+}
+
+char * output_file::mapped(size_t & n) {
+	
+	boost::uint64_t position = tell();
+	if(!mapping_ || position >= mapping_size_) {
+		return NULL;
+	}
+	
+	n = size_t(std::min(boost::uint64_t(n), mapping_size_ - position));
+	
+	return mapping_ + position;
+}
+
+bool output_file::write_mapped(const char * data, size_t n) {
+	
+	boost::uint64_t position = buffer_offset_;
+	
+	if(position < mapping_size_) {
+		size_t count = size_t(std::min(boost::uint64_t(n), mapping_size_ - position));
+		if(data != mapping_ + position) {
+			std::memcpy(mapping_ + position, data, count);
+		}
+		data += count, n -= count, position += count;
+	}
+	
+	if(n != 0) {
+		write_at(data, n, position);
+		position += n;
+	}
+	
+	buffer_offset_ = position;
+	end_ = std::max(end_, position);
+	
+	return good_;
+}
+
+bool output_file::write(const char * data, size_t n) {
+	
+	if(mapping_) {
+		return write_mapped(data, n);
+	}
+	
+	if(buffered_ == 0 && n >= buffer_size_ && mode_ == KeepCache) {
+		// Large writes don't benefit from buffering
+		bool success = write_at(data, n, buffer_offset_);
+		buffer_offset_ += n;
+		return success;
+	}
+	
+	while(n != 0) {
+		size_t count = std::min(n, buffer_size_ - buffered_);
+		std::memcpy(buffer_ + buffered_, data, count);
+		buffered_ += count, data += count, n -= count;
+		if(buffered_ == buffer_size_) {
+			flush_buffer(false);
+		}
+	}
+	
+	return good_;
+}
+
+bool output_file::seek(boost::uint64_t position) {
+	
+	if(position == tell()) {
+		return good_;
+	}
+	
+	bool success = flush_buffer(true);
+	buffer_offset_ = position;
+	
+	return success;
+}
+
+size_t output_file::read(boost::uint64_t position, char * data, size_t n) {
+	
+	if(mapping_ && position < mapping_size_) {
+		boost::uint64_t available = std::min(end_, mapping_size_);
+		available = (available > position) ? available - position : 0;
+		size_t count = size_t(std::min(boost::uint64_t(n), available));
+		std::memcpy(data, mapping_ + position, count);
+		if(count == n || position + count < mapping_size_) {
+			return count;
+		}
+		// The rest was written past the end of the mapping
+		return count + read(position + count, data + count, n - count);
+	}
+	
+	if(!flush_buffer(true)) {
+		return 0;
+	}
+	set_direct(false);
+	
+	#if INNOEXTRACT_HAVE_PWRITE
+	
+	size_t total = 0;
+	while(n != 0) {
+		ssize_t count = pread(file_.handle(), data, n, off_t(position));
+		if(count < 0 && errno == EINTR) {
+			continue;
+		}
+		if(count <= 0) {
+			break;
+		}
+		data += count, n -= size_t(count), position += boost::uint64_t(count);
+		total += size_t(count);
+	}
+	return total;
+	
+	#else
+	
+	try {
+		file_.seek(io::stream_offset(position), std::ios_base::beg);
+		std::streamsize count = file_.read(data, std::streamsize(n));
+		return count < 0 ? 0 : size_t(count);
+	} catch(...) {
+		return 0;
+	}
+	
+	#endif
+	
+}
+
+bool output_file::flush() {
+	return flush_buffer(true);
+}
+
+bool output_file::close() {
+	
+	if(!file_.is_open()) {
+		return good_;
+	}
+	
+	unmap();
+	bool success = flush_buffer(true);
+	drop_cache(true);
+	
+	try {
+		file_.close();
+	} catch(...) {
+		success = good_ = false;
+	}
+	
+	return success;
+}
+
+bool output_file::close(const boost::filesystem::path & path, time sec, boost::uint32_t nsec,
+                        bool & time_set) {
+	
+	// Writes to the mapping could otherwise still change the file time
+	unmap();
+	bool success = flush_buffer(true);
+	drop_cache(true);
+	
+	time_set = set_file_time(file_.handle(), path, sec, nsec);
+	
+	return close() && success;
+}
+
+} // namespace util
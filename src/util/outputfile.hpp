@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Buffered writer for extracted files.
+ */
+#ifndef INNOEXTRACT_UTIL_OUTPUTFILE_HPP
+#define INNOEXTRACT_UTIL_OUTPUTFILE_HPP
+
+#include <stddef.h>
+#include <memory>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/iostreams/device/file_descriptor.hpp>
+
+#include "util/time.hpp"
+
+namespace util {
+
+//! How written data should interact with the operating system's page cache.
+enum output_cache_mode {
+	KeepCache, //!< Leave written data in the page cache.
+	DropCache, //!< Write data back and then evict it from the page cache.
+	DirectIO   //!< Bypass the page cache where possible, evict the rest.
+};
+
+/*!
+ * Buffered writer using positional writes on a raw file handle.
+ *
+ * The buffer is aligned and writes are issued at the file offset of the buffered data, so
+ * seeking only needs to flush the buffer. Written data can be read back to calculate
+ * checksums of files that were not written sequentially.
+ *
+ * Large files can instead be mapped into memory (see \ref map()) so that data can be
+ * decoded directly into the file without going through the buffer.
+ */
+class output_file : private boost::noncopyable {
+	
+	boost::iostreams::file_descriptor file_;
+	
+	std::unique_ptr<char[]> storage_; //!< Not initialized, the buffer is never read past buffered_
+	size_t storage_size_;
+	char * buffer_;
+	size_t buffer_size_;
+	size_t buffered_;
+	boost::uint64_t buffer_offset_; //!< File offset for the start of the buffer.
+	
+	output_cache_mode mode_;
+	bool direct_; //!< Is direct I/O currently enabled for the handle?
+	boost::uint64_t unsynced_; //!< Bytes written since the page cache was last dropped.
+	
+	bool good_;
+	
+	char * mapping_; //!< Shared mapping of the start of the file, or NULL.
+	boost::uint64_t mapping_size_;
+	boost::uint64_t end_; //!< End of the data written to the mapped file.
+	
+	bool set_direct(bool enable);
+	bool write_at(const char * data, size_t n, boost::uint64_t offset);
+	bool flush_buffer(bool all);
+	void drop_cache(bool force);
+	void unmap();
+	bool write_mapped(const char * data, size_t n);
+	
+public:
+	
+	//! Default size of the write buffer.
+	static const size_t default_buffer_size = size_t(1) << 20;
+	
+	//! Alignment of the write buffer and of direct writes.
+	static const size_t block_size = 4096;
+	
+	//! Files smaller than this are not worth mapping.
+	static const boost::uint64_t min_map_size = boost::uint64_t(4) << 20;
+	
+	output_file();
+	
+	~output_file();
+	
+	/*!
+	 * Start writing to a file.
+	 *
+	 * \param file        Handle of the file to write to, must be opened for writing.
+	 * \param size_hint   Expected size of the file, used to not allocate more buffer
+	 *                    memory than needed for small files.
+	 * \param buffer_size Maximum size of the write buffer.
+	 * \param mode        How to handle the page cache for written data.
+	 */
+	void open(const boost::iostreams::file_descriptor & file, boost::uint64_t size_hint,
+	          size_t buffer_size = default_buffer_size, output_cache_mode mode = KeepCache);
+	
+	bool is_open() const { return file_.is_open(); }
+	
+	/*!
+	 * Write the file through a shared memory mapping instead of the buffer.
+	 *
+	 * Space for the file is allocated up front so that writing to the mapping cannot fail
+	 * later. Data written past the expected size is written normally. If less data is
+	 * written, the file is truncated when it is closed.
+	 *
+	 * Must be called before anything is written.
+	 *
+	 * \param size Expected size of the file.
+	 *
+	 * \return false if the file could not be mapped - it is then written using the buffer.
+	 */
+	bool map(boost::uint64_t size);
+	
+	/*!
+	 * Get mapped memory to write the data at the current position to.
+	 *
+	 * Passing the returned pointer to \ref write() only advances the position.
+	 *
+	 * \param n Maximum number of bytes needed, set to the number of bytes available.
+	 *
+	 * \return a pointer into the mapping or NULL if the current position is not mapped.
+	 */
+	char * mapped(size_t & n);
+	
+	//! \return false if any write has failed.
+	bool good() const { return good_; }
+	
+	//! Write data at the current position.
+	bool write(const char * data, size_t n);
+	
+	//! Change the position for the next write.
+	bool seek(boost::uint64_t position);
+	
+	//! \return the position for the next write.
+	boost::uint64_t tell() const { return buffer_offset_ + buffered_; }
+	
+	/*!
+	 * Read back previously written data.
+	 *
+	 * \return the number of bytes read - less than \c n at the end of the file.
+	 */
+	size_t read(boost::uint64_t position, char * data, size_t n);
+	
+	//! Write any buffered data to the file.
+	bool flush();
+	
+	//! Write any buffered data and close the file.
+	bool close();
+	
+	/*!
+	 * Write any buffered data, set the file time and close the file.
+	 *
+	 * \param path     Path of the file in case the time cannot be set using the open handle.
+	 * \param sec      File time to set (in seconds).
+	 * \param nsec     Sub-second component of the file time to set (in nanoseconds).
+	 * \param time_set Receives \c true if the file time was changed, \c false otherwise.
+	 *
+	 * \return false if writing the data failed.
+	 */
+	bool close(const boost::filesystem::path & path, time sec, boost::uint32_t nsec,
+	           bool & time_set);
+	
+};
+
+} // namespace util
+
+#endif // INNOEXTRACT_UTIL_OUTPUTFILE_HPP
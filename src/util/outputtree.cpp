@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "util/outputtree.hpp"
+
+#include <stdexcept>
+
+#include "configure.hpp"
+
+#if INNOEXTRACT_HAVE_OPENAT && INNOEXTRACT_HAVE_MKDIRAT
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define INNOEXTRACT_OUTPUT_TREE_HANDLES 1
+#else
+#include <boost/filesystem/operations.hpp>
+#define INNOEXTRACT_OUTPUT_TREE_HANDLES 0
+#endif
+
+#include "util/outputbatch.hpp"
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+namespace io = boost::iostreams;
+namespace fs = boost::filesystem;
+
+namespace util {
+
+output_tree::output_tree(const fs::path & root, size_t max_open)
+	: root_(root), root_handle_(-1), max_open_(max_open < 2 ? 2 : max_open) { }
+
+output_tree::~output_tree() {
+	close();
+}
+
+void output_tree::flush() {
+	if(batch_) {
+		batch_->flush();
+	}
+}
+
+#if INNOEXTRACT_OUTPUT_TREE_HANDLES
+
+namespace {
+
+std::pair<std::string, std::string> split_path(const std::string & path) {
+	size_t pos = path.find_last_of('/');
+	if(pos == std::string::npos) {
+		return std::make_pair(std::string(), path);
+	}
+	return std::make_pair(path.substr(0, pos), path.substr(pos + 1));
+}
+
+} // anonymous namespace
+
+int output_tree::directory_handle(const std::string & path) {
+	
+	if(path.empty()) {
+		if(root_handle_ < 0) {
+			const char * name = root_.empty() ? "." : root_.c_str();
+			root_handle_ = ::open(name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if(root_handle_ < 0) {
+				throw std::runtime_error("Could not open directory \"" + root_.string() + '"');
+			}
+		}
+		return root_handle_;
+	}
+	
+	directory_map::iterator it = directories_.find(path);
+	if(it != directories_.end()) {
+		lru_.splice(lru_.begin(), lru_, it->second);
+		return it->second->second;
+	}
+	
+	std::pair<std::string, std::string> parts = split_path(path);
+	int parent = directory_handle(parts.first);
+	int handle = ::openat(parent, parts.second.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(handle < 0) {
+		throw std::runtime_error("Could not open directory \"" + full_path(path).string() + '"');
+	}
+	
+	if(lru_.size() >= max_open_) {
+		if(batch_ && batch_->busy()) {
+			// Queued files may still be using the handle
+			batch_->flush();
+		}
+		::close(lru_.back().second);
+		directories_.erase(lru_.back().first);
+		lru_.pop_back();
+	}
+	
+	lru_.push_front(cached_directory(path, handle));
+	directories_[path] = lru_.begin();
+	
+	return handle;
+}
+
+void output_tree::create_directory(const std::string & path) {
+	
+	if(path.empty()) {
+		return;
+	}
+	
+	std::pair<std::string, std::string> parts = split_path(path);
+	if(::mkdirat(directory_handle(parts.first), parts.second.c_str(), 0777) != 0 && errno != EEXIST) {
+		throw std::runtime_error("Could not create directory \"" + full_path(path).string() + '"');
+	}
+	
+}
+
+io::file_descriptor output_tree::open_file(const std::string & path, bool read) {
+	
+	std::pair<std::string, std::string> parts = split_path(path);
+	
+	int handle = -1;
+	try {
+		int parent = directory_handle(parts.first);
+		// Replace hard-linked files instead of writing to all links, which may be in a content store
+		struct stat buf;
+		if(::fstatat(parent, parts.second.c_str(), &buf, AT_SYMLINK_NOFOLLOW) == 0
+		   && S_ISREG(buf.st_mode) && buf.st_nlink > 1) {
+			::unlinkat(parent, parts.second.c_str(), 0);
+		}
+		int flags = O_CREAT | O_TRUNC | O_CLOEXEC | (read ? O_RDWR : O_WRONLY);
+		handle = ::openat(parent, parts.second.c_str(), flags, 0666);
+	} catch(const std::runtime_error &) {
+		// Report the file that could not be opened below
+	}
+	if(handle < 0) {
+		throw std::runtime_error("Could not open output file \"" + full_path(path).string() + '"');
+	}
+	
+	return io::file_descriptor(handle, io::close_handle);
+}
+
+bool output_tree::enable_batch(size_t window) {
+	
+	boost::scoped_ptr<output_batch> batch(new output_batch(root_));
+	if(!batch->open(window)) {
+		return false;
+	}
+	
+	batch_.swap(batch);
+	
+	return true;
+}
+
+void output_tree::write_file(const std::string & path, std::vector<char> & data, bool set_time,
+                             time sec, boost::uint32_t nsec) {
+	
+	size_t name = path.find_last_of('/');
+	name = (name == std::string::npos) ? 0 : name + 1;
+	
+	int parent = -1;
+	try {
+		parent = directory_handle(name == 0 ? std::string() : path.substr(0, name - 1));
+	} catch(const std::runtime_error &) {
+		throw std::runtime_error("Could not open output file \"" + full_path(path).string() + '"');
+	}
+	
+	batch_->write(parent, path, name, data, set_time, sec, nsec);
+}
+
+void output_tree::close() {
+	
+	if(batch_) {
+		try {
+			batch_->flush();
+		} catch(...) {
+			// Errors are reported by flush() if extraction was successful
+		}
+	}
+	
+	for(const cached_directory & directory : lru_) {
+		::close(directory.second);
+	}
+	lru_.clear();
+	directories_.clear();
+	
+	if(root_handle_ >= 0) {
+		::close(root_handle_);
+		root_handle_ = -1;
+	}
+	
+}
+
+#else // !INNOEXTRACT_OUTPUT_TREE_HANDLES
+
+int output_tree::directory_handle(const std::string & path) {
+	(void)path;
+	return root_handle_;
+}
+
+void output_tree::create_directory(const std::string & path) {
+	
+	fs::path dir = full_path(path);
+	try {
+		if(!path.empty() && !fs::exists(dir)) {
+			fs::create_directory(dir);
+		}
+	} catch(...) {
+		throw std::runtime_error("Could not create directory \"" + dir.string() + '"');
+	}
+	
+}
+
+io::file_descriptor output_tree::open_file(const std::string & path, bool read) {
+	
+	fs::path file = full_path(path);
+	
+	io::file_descriptor result;
+	try {
+		// Replace hard-linked files instead of writing to all links, which may be in a content store
+		boost::system::error_code ec;
+		if(fs::hard_link_count(file, ec) > 1 && !ec) {
+			fs::remove(file, ec);
+		}
+		std::ios_base::openmode mode = std::ios_base::out | std::ios_base::binary | std::ios_base::trunc;
+		if(read) {
+			mode |= std::ios_base::in;
+		}
+		result.open(file, mode);
+	} catch(...) {
+		// Reported below
+	}
+	if(!result.is_open()) {
+		throw std::runtime_error("Could not open output file \"" + file.string() + '"');
+	}
+	
+	return result;
+}
+
+bool output_tree::enable_batch(size_t window) {
+	(void)window;
+	return false;
+}
+
+void output_tree::write_file(const std::string & path, std::vector<char> & data, bool set_time,
+                             time sec, boost::uint32_t nsec) {
+	(void)path, (void)data, (void)set_time, (void)sec, (void)nsec;
+	throw std::runtime_error("Batched output is not supported");
+}
+
+void output_tree::close() { }
+
+#endif // !INNOEXTRACT_OUTPUT_TREE_HANDLES
+
+} // namespace util
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Creation of the extracted directory tree and output files.
+ */
+#ifndef INNOEXTRACT_UTIL_OUTPUTTREE_HPP
+#define INNOEXTRACT_UTIL_OUTPUTTREE_HPP
+
+#include <stddef.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/file_descriptor.hpp>
+
+#include "util/time.hpp"
+
+namespace util {
+
+class output_batch;
+
+/*!
+ * Creates directories and files below an output directory.
+ *
+ * Where supported, handles for recently used directories are kept open so that new
+ * directories and files are created relative to their parent instead of having the
+ * kernel resolve the full path every time.
+ *
+ * Relative paths passed to this class must use \ref setup::path_sep as separator and
+ * must not contain \c . or \c .. components.
+ */
+class output_tree : private boost::noncopyable {
+	
+	boost::filesystem::path root_;
+	
+	typedef std::pair<std::string, int> cached_directory;
+	typedef std::list<cached_directory> directory_list;
+	typedef std::unordered_map<std::string, directory_list::iterator> directory_map;
+	
+	int root_handle_;
+	directory_list lru_;
+	directory_map directories_;
+	size_t max_open_;
+	
+	boost::scoped_ptr<output_batch> batch_;
+	
+	int directory_handle(const std::string & path);
+	
+public:
+	
+	/*!
+	 * \param root     Directory below which all files are created. Must already exist.
+	 * \param max_open Maximum number of directory handles to keep open.
+	 */
+	explicit output_tree(const boost::filesystem::path & root, size_t max_open = 64);
+	
+	~output_tree();
+	
+	//! Create a directory if it does not already exist. The parent directory must exist.
+	void create_directory(const std::string & path);
+	
+	/*!
+	 * Create or truncate a file for writing.
+	 *
+	 * \param path Path of the file relative to the root directory.
+	 * \param read Open the file for reading as well.
+	 *
+	 * \throws std::runtime_error if the file could not be opened.
+	 */
+	boost::iostreams::file_descriptor open_file(const std::string & path, bool read);
+	
+	/*!
+	 * Write small files asynchronously using \ref output_batch where supported.
+	 *
+	 * \param window Number of files that can be in flight at the same time.
+	 *
+	 * \return false if files can only be written using \ref open_file().
+	 */
+	bool enable_batch(size_t window);
+	
+	//! \return true if \ref write_file() can be used.
+	bool is_batched() const { return batch_.get() != NULL; }
+	
+	/*!
+	 * Queue a complete file to be created or truncated and written asynchronously.
+	 *
+	 * Errors are reported by a later call to this function or to \ref flush().
+	 *
+	 * \param path     Path of the file relative to the root directory.
+	 * \param data     Contents of the file. This is swapped with an unused buffer.
+	 * \param set_time Set the file time once the file has been written.
+	 * \param sec      File time to set (in seconds).
+	 * \param nsec     Sub-second component of the file time to set (in nanoseconds).
+	 *
+	 * \throws std::runtime_error if this or a previously queued file could not be written.
+	 */
+	void write_file(const std::string & path, std::vector<char> & data, bool set_time,
+	                time sec, boost::uint32_t nsec);
+	
+	/*!
+	 * Wait for all files queued using \ref write_file().
+	 *
+	 * \throws std::runtime_error if a file could not be written.
+	 */
+	void flush();
+	
+	//! Close all cached directory handles after waiting for queued files.
+	void close();
+	
+	//! \return the full path for a path relative to the root directory.
+	boost::filesystem::path full_path(const std::string & path) const { return root_ / path; }
+	
+	const boost::filesystem::path & root() const { return root_; }
+	
+};
+
+} // namespace util
+
+#endif // INNOEXTRACT_UTIL_OUTPUTTREE_HPP
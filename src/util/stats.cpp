@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "util/stats.hpp"
+
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+
+#include "util/output.hpp"
+
+namespace util {
+
+namespace stats {
+
+bool enabled = false;
+
+namespace {
+
+const char * const stage_names[] = {
+	"headers",
+	"slice read",
+	"decrypt",
+	"decompress",
+	"exe filter",
+	"hash",
+	"output write",
+	"checksum re-read",
+	"copy",
+};
+
+const char * const counter_names[] = {
+	"files",
+	"chunks",
+	"slices",
+	"seeks",
+	"discards",
+	"discarded bytes",
+	"colliding paths",
+	"colliding files",
+	"renamed files",
+	"numbered files",
+};
+
+std::atomic<boost::uint64_t> stage_bytes[StageCount];
+std::atomic<boost::uint64_t> stage_time[StageCount]; // nanoseconds
+std::atomic<boost::uint64_t> calls[StageCount];
+std::atomic<boost::uint64_t> counters[CounterCount];
+
+std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+
+thread_local timer * current = NULL;
+
+double seconds(boost::uint64_t nanoseconds) {
+	return double(nanoseconds) / 1e9;
+}
+
+double wall_time() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+}
+
+std::string json_key(const char * name) {
+	std::string key = name;
+	for(char & c : key) {
+		if(c == ' ' || c == '-') {
+			c = '_';
+		}
+	}
+	return key;
+}
+
+} // anonymous namespace
+
+void reset() {
+	
+	for(size_t i = 0; i < StageCount; i++) {
+		stage_bytes[i] = 0;
+		stage_time[i] = 0;
+		calls[i] = 0;
+	}
+	for(size_t i = 0; i < CounterCount; i++) {
+		counters[i] = 0;
+	}
+	
+	wall_start = std::chrono::steady_clock::now();
+}
+
+void count(counter c, boost::uint64_t n) {
+	if(enabled) {
+		counters[c].fetch_add(n, std::memory_order_relaxed);
+	}
+}
+
+void timer::start() {
+	nested_ = 0;
+	parent_ = current;
+	current = this;
+	start_ = clock::now();
+}
+
+void timer::stop() {
+	
+	boost::uint64_t elapsed = boost::uint64_t(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count()
+	);
+	
+	current = parent_;
+	if(parent_) {
+		parent_->nested_ += elapsed;
+	}
+	
+	stage_time[stage_].fetch_add(elapsed > nested_ ? elapsed - nested_ : 0, std::memory_order_relaxed);
+	stage_bytes[stage_].fetch_add(bytes_, std::memory_order_relaxed);
+	calls[stage_].fetch_add(1, std::memory_order_relaxed);
+}
+
+void print(std::ostream & os) {
+	
+	double wall = wall_time();
+	
+	std::ios_base::fmtflags old_flags = os.flags();
+	std::streamsize old_precision = os.precision();
+	os << "Statistics:\n";
+	
+	double accounted = 0;
+	for(size_t i = 0; i < StageCount; i++) {
+		boost::uint64_t bytes = stage_bytes[i];
+		double time = seconds(stage_time[i]);
+		accounted += time;
+		if(calls[i] == 0) {
+			continue;
+		}
+		os << " - " << std::left << std::setw(17) << (std::string(stage_names[i]) + ':') << std::right;
+		os << std::fixed << std::setprecision(3) << std::setw(9) << time << std::defaultfloat << " s";
+		if(bytes != 0) {
+			os << "  " << std::setw(10) << print_bytes(bytes);
+			if(time > 0) {
+				os << "  " << std::setw(10) << print_bytes(double(bytes) / time) << "/s";
+			}
+		}
+		os << '\n';
+	}
+	
+	os << " - " << std::left << std::setw(17) << "other:" << std::right;
+	os << std::fixed << std::setprecision(3) << std::setw(9) << (wall > accounted ? wall - accounted : 0.) << " s\n";
+	os << " - " << std::left << std::setw(17) << "total:" << std::right;
+	os << std::setw(9) << wall << " s\n";
+	
+	os << "Counts:";
+	for(size_t i = 0; i < CounterCount; i++) {
+		os << (i == 0 ? " " : ", ") << counter_names[i] << ' ' << counters[i];
+	}
+	os << '\n';
+	
+	os.flags(old_flags);
+	os.precision(old_precision);
+}
+
+void print_json(std::ostream & os) {
+	
+	std::ios_base::fmtflags old_flags = os.flags();
+	std::streamsize old_precision = os.precision();
+	os << std::fixed << std::setprecision(6);
+	
+	os << "{\n  \"wall_seconds\": " << wall_time() << ",\n  \"stages\": {";
+	for(size_t i = 0; i < StageCount; i++) {
+		os << (i == 0 ? "\n" : ",\n");
+		os << "    \"" << json_key(stage_names[i]) << "\": { \"seconds\": " << seconds(stage_time[i])
+		   << ", \"bytes\": " << stage_bytes[i] << ", \"calls\": " << calls[i] << " }";
+	}
+	os << "\n  },\n  \"counts\": {";
+	for(size_t i = 0; i < CounterCount; i++) {
+		os << (i == 0 ? "\n" : ",\n");
+		os << "    \"" << json_key(counter_names[i]) << "\": " << counters[i];
+	}
+	os << "\n  }\n}\n";
+	
+	os.flags(old_flags);
+	os.precision(old_precision);
+}
+
+} // namespace stats
+
+} // namespace util
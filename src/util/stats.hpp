@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Per-stage timing and throughput statistics for the extraction pipeline.
+ */
+#ifndef INNOEXTRACT_UTIL_STATS_HPP
+#define INNOEXTRACT_UTIL_STATS_HPP
+
+#include <chrono>
+#include <iosfwd>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace util {
+
+namespace stats {
+
+//! Pipeline stages that time is attributed to.
+enum stage {
+	Headers,     //!< Loading and parsing the setup headers
+	SliceRead,   //!< Reading data from the setup executable or slice files
+	Decrypt,     //!< ARC4 decryption
+	Decompress,  //!< zlib, bzip2 or LZMA decompression
+	ExeFilter,   //!< Undoing instruction filters
+	Hash,        //!< Checksum calculation
+	OutputWrite, //!< Writing extracted files
+	Reread,      //!< Reading back output files to calculate checksums
+	Copy,        //!< Stream buffers and the copy loop, excluding all other stages
+	StageCount
+};
+
+//! Events that are counted.
+enum counter {
+	Files,          //!< Files read from chunks
+	Chunks,         //!< Chunks opened
+	Slices,         //!< Slice files opened
+	Seeks,          //!< Seeks in slices and output files
+	Discards,       //!< Skipped regions in chunks
+	DiscardedBytes, //!< Bytes decoded and thrown away for skipped regions
+	CollisionPaths, //!< Output paths with more than one file
+	CollisionFiles, //!< Files involved in collisions
+	Renamed,        //!< Colliding files that were assigned a new name
+	Numbered,       //!< Renamed files that needed a numbered suffix
+	CounterCount
+};
+
+//! Is statistics collection enabled? Everything else is a no-op if not.
+extern bool enabled;
+
+//! Clear all statistics and restart the wall clock.
+void reset();
+
+//! Add a number to a counter.
+void count(counter c, boost::uint64_t n = 1);
+
+//! Print a human-readable summary.
+void print(std::ostream & os);
+
+//! Print the statistics as a JSON object.
+void print_json(std::ostream & os);
+
+/*!
+ * Attribute the time until destruction to a stage.
+ *
+ * Timers nest: time spent in timers started while this one is active is subtracted, so
+ * each stage only gets its own time even if it pulls data through other stages.
+ * Construction only tests \ref enabled if statistics are disabled.
+ */
+class timer : private boost::noncopyable {
+	
+	typedef std::chrono::steady_clock clock;
+	
+	bool active_;
+	stage stage_;
+	boost::uint64_t bytes_;
+	boost::uint64_t nested_; //!< Nanoseconds spent in nested timers
+	timer * parent_;
+	clock::time_point start_;
+	
+	void start();
+	void stop();
+	
+public:
+	
+	explicit timer(stage s) : active_(enabled), stage_(s), bytes_(0) {
+		if(active_) {
+			start();
+		}
+	}
+	
+	~timer() {
+		if(active_) {
+			stop();
+		}
+	}
+	
+	//! Add to the number of bytes processed by this stage.
+	void add(boost::uint64_t bytes) { bytes_ += bytes; }
+	
+};
+
+} // namespace stats
+
+} // namespace util
+
+#endif // INNOEXTRACT_UTIL_STATS_HPP
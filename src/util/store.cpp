@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "util/store.hpp"
+
+#include <ctime>
+#include <stdexcept>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "configure.hpp"
+
+#if INNOEXTRACT_HAVE_FICLONE
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace util {
+
+namespace {
+
+//! Create a copy-on-write clone of a file, if the filesystem supports it.
+bool clone_file(const fs::path & from, const fs::path & to) {
+	
+	#if INNOEXTRACT_HAVE_FICLONE
+	
+	int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+	if(in < 0) {
+		return false;
+	}
+	
+	int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	bool success = (out >= 0 && ::ioctl(out, FICLONE, in) == 0);
+	if(out >= 0) {
+		::close(out);
+		if(!success) {
+			::unlink(to.c_str());
+		}
+	}
+	::close(in);
+	
+	return success;
+	
+	#else
+	(void)from, (void)to;
+	return false;
+	#endif
+	
+}
+
+} // anonymous namespace
+
+content_store::content_store(const fs::path & root) : root_(root) {
+	try {
+		fs::create_directories(root_);
+	} catch(...) {
+		throw std::runtime_error("Could not create store directory \"" + root_.string() + '"');
+	}
+}
+
+fs::path content_store::path(const std::string & name) const {
+	return root_ / name.substr(0, 2) / name;
+}
+
+bool content_store::contains(const std::string & name, boost::uint64_t size) const {
+	boost::system::error_code ec;
+	boost::uintmax_t actual = fs::file_size(path(name), ec);
+	return !ec && actual == size;
+}
+
+bool content_store::materialize(const std::string & name, const fs::path & target,
+                                bool link, const std::time_t * mtime) const {
+	
+	fs::path source = path(name);
+	
+	boost::system::error_code ec;
+	fs::remove(target, ec);
+	
+	if(clone_file(source, target)) {
+		return false;
+	}
+	
+	// Hard links would all get the time of whichever file was extracted last
+	if(link && mtime) {
+		std::time_t entry_time = fs::last_write_time(source, ec);
+		link = (!ec && entry_time == *mtime);
+	}
+	if(link) {
+		fs::create_hard_link(source, target, ec);
+		if(!ec) {
+			return true;
+		}
+	}
+	
+	fs::copy_file(source, target, ec);
+	if(!ec) {
+		fs::permissions(target, fs::add_perms | fs::owner_write, ec);
+		return false;
+	}
+	
+	throw std::runtime_error("Could not create \"" + target.string() + "\" from the store");
+}
+
+bool content_store::add(const std::string & name, const fs::path & file) const {
+	
+	fs::path target = path(name);
+	
+	boost::system::error_code ec;
+	if(fs::exists(target, ec)) {
+		return true;
+	}
+	
+	// Write to a temporary file first so that other processes never see partial entries
+	fs::create_directories(target.parent_path(), ec);
+	fs::path temp = target.parent_path() / fs::unique_path(".%%%%-%%%%-%%%%-%%%%.tmp", ec);
+	if(ec) {
+		return false;
+	}
+	if(!clone_file(file, temp)) {
+		fs::copy_file(file, temp, ec);
+		if(ec) {
+			return false;
+		}
+	}
+	
+	// Hard links to the entry share its modification time
+	std::time_t mtime = fs::last_write_time(file, ec);
+	if(!ec) {
+		fs::last_write_time(temp, mtime, ec);
+	}
+	fs::permissions(temp, fs::owner_read | fs::group_read | fs::others_read, ec);
+	fs::rename(temp, target, ec);
+	if(ec) {
+		fs::remove(temp, ec);
+		return false;
+	}
+	
+	return true;
+}
+
+} // namespace util
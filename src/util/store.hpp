@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Content-addressed store for extracted files shared between installers.
+ */
+#ifndef INNOEXTRACT_UTIL_STORE_HPP
+#define INNOEXTRACT_UTIL_STORE_HPP
+
+#include <ctime>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/filesystem/path.hpp>
+
+namespace util {
+
+/*!
+ * Directory of file contents named by their checksum and size.
+ *
+ * Entries are never modified once added, and are made read-only so that hard links
+ * to them can not be written to by accident. Several processes can add to the same
+ * store at the same time.
+ */
+class content_store : private boost::noncopyable {
+	
+	boost::filesystem::path root_;
+	
+public:
+	
+	//! \param root Directory for the store, created if it does not exist.
+	explicit content_store(const boost::filesystem::path & root);
+	
+	//! \return the path of the entry with the given name.
+	boost::filesystem::path path(const std::string & name) const;
+	
+	//! \return true if the store has an entry with the given name and size.
+	bool contains(const std::string & name, boost::uint64_t size) const;
+	
+	/*!
+	 * Create a file with the contents of a store entry.
+	 *
+	 * The file is cloned if the filesystem supports it, otherwise it is copied. If \c link
+	 * is set, it is hard-linked to the entry instead of copied when possible. Hard links
+	 * share the entry's content and read-only permissions: changing them changes the
+	 * store for all later users. An existing file is replaced.
+	 *
+	 * \param name   Name of the store entry.
+	 * \param target Path of the file to create.
+	 * \param link   Hard-link the file to the entry if it cannot be cloned.
+	 * \param mtime  Modification time the file should have, or \c NULL if it does not matter.
+	 *               The file is only hard-linked if the entry has the same time (in seconds)
+	 *               as all links share it.
+	 *
+	 * \throws std::runtime_error if the file could not be created.
+	 *
+	 * \return true if the file is a hard link to the store entry and shares its metadata.
+	 */
+	bool materialize(const std::string & name, const boost::filesystem::path & target,
+	                 bool link, const std::time_t * mtime = NULL) const;
+	
+	/*!
+	 * Add a copy of a file to the store unless there already is an entry with that name.
+	 *
+	 * \return false if the entry could not be added.
+	 */
+	bool add(const std::string & name, const boost::filesystem::path & file) const;
+	
+};
+
+} // namespace util
+
+#endif // INNOEXTRACT_UTIL_STORE_HPP
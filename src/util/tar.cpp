@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "util/tar.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace util {
+
+namespace {
+
+const size_t name_size = 100;
+const size_t prefix_size = 155;
+
+//! Offsets of ustar header fields.
+enum header_field {
+	Name = 0,
+	Mode = 100,
+	UserId = 108,
+	GroupId = 116,
+	Size = 124,
+	ModificationTime = 136,
+	Checksum = 148,
+	Type = 156,
+	LinkName = 157,
+	Magic = 257,
+	Version = 263,
+	Prefix = 345
+};
+
+void put_string(char * field, size_t size, const std::string & value) {
+	std::memcpy(field, value.data(), std::min(size, value.size()));
+}
+
+//! Store a number as zero-padded octal or using the GNU base-256 encoding if too large.
+void put_number(char * field, size_t size, boost::uint64_t value) {
+	
+	size_t digits = size - 1;
+	if(digits * 3 >= 64 || value < (boost::uint64_t(1) << (digits * 3))) {
+		field[digits] = '\0';
+		for(size_t i = digits; i > 0; i--) {
+			field[i - 1] = char('0' + (value & 7));
+			value >>= 3;
+		}
+		return;
+	}
+	
+	std::memset(field, 0, size);
+	field[0] = char(0x80);
+	for(size_t i = size; i > 1 && value != 0; i--) {
+		field[i - 1] = char(value & 0xff);
+		value >>= 8;
+	}
+}
+
+/*!
+ * Split a path into the ustar prefix and name fields.
+ *
+ * \return false if the path cannot be represented.
+ */
+bool split_path(const std::string & path, std::string & prefix, std::string & name) {
+	
+	if(path.size() <= name_size) {
+		prefix.clear();
+		name = path;
+		return true;
+	}
+	
+	size_t pos = path.rfind('/', std::min(prefix_size, path.size() - 1));
+	while(pos != std::string::npos && pos != 0) {
+		if(path.size() - pos - 1 > name_size) {
+			break;
+		}
+		if(path.size() - pos - 1 > 0) {
+			prefix = path.substr(0, pos);
+			name = path.substr(pos + 1);
+			return true;
+		}
+		pos = path.rfind('/', pos - 1);
+	}
+	
+	return false;
+}
+
+std::string archive_path(std::string path) {
+	#if defined(_WIN32)
+	std::replace(path.begin(), path.end(), '\\', '/');
+	#endif
+	return path;
+}
+
+} // anonymous namespace
+
+tar_writer::tar_writer(std::ostream & os)
+	: os_(os), in_entry_(false), remaining_(0), size_(0) { }
+
+void tar_writer::write_padding(boost::uint64_t size) {
+	static const char zeros[block_size] = { 0 };
+	size_t padding = size_t((block_size - size % block_size) % block_size);
+	os_.write(zeros, std::streamsize(padding));
+}
+
+void tar_writer::write_long_name(char type, const std::string & name) {
+	
+	write_header("././@LongLink", type, name.size() + 1, 0);
+	
+	os_.write(name.c_str(), std::streamsize(name.size() + 1));
+	write_padding(name.size() + 1);
+	
+}
+
+void tar_writer::write_header(const std::string & path, char type, boost::uint64_t size,
+                              time mtime, const std::string & link) {
+	
+	std::string prefix, name;
+	if(!split_path(path, prefix, name)) {
+		write_long_name('L', path);
+		prefix.clear();
+		name = path.substr(0, name_size);
+	}
+	
+	if(link.size() > name_size) {
+		write_long_name('K', link);
+	}
+	
+	char header[block_size];
+	std::memset(header, 0, sizeof(header));
+	
+	put_string(header + Name, name_size, name);
+	put_number(header + Mode, 8, type == '5' ? 0755 : 0644);
+	put_number(header + UserId, 8, 0);
+	put_number(header + GroupId, 8, 0);
+	put_number(header + Size, 12, size);
+	put_number(header + ModificationTime, 12, mtime < 0 ? 0 : boost::uint64_t(mtime));
+	header[Type] = type;
+	put_string(header + LinkName, name_size, link);
+	std::memcpy(header + Magic, "ustar", 6);
+	std::memcpy(header + Version, "00", 2);
+	put_string(header + Prefix, prefix_size, prefix);
+	
+	std::memset(header + Checksum, ' ', 8);
+	boost::uint32_t checksum = 0;
+	for(size_t i = 0; i < block_size; i++) {
+		checksum += boost::uint8_t(header[i]);
+	}
+	put_number(header + Checksum, 7, checksum);
+	
+	os_.write(header, std::streamsize(sizeof(header)));
+	
+}
+
+void tar_writer::add_directory(const std::string & path, time mtime) {
+	
+	if(in_entry_) {
+		end_file();
+	}
+	
+	std::string name = archive_path(path);
+	if(name.empty() || name[name.size() - 1] != '/') {
+		name.push_back('/');
+	}
+	
+	write_header(name, '5', 0, mtime);
+	
+}
+
+void tar_writer::begin_file(const std::string & path, boost::uint64_t size, time mtime) {
+	
+	if(in_entry_) {
+		end_file();
+	}
+	
+	write_header(archive_path(path), '0', size, mtime);
+	
+	in_entry_ = true;
+	remaining_ = size;
+	size_ = size;
+	
+}
+
+bool tar_writer::write(const char * data, size_t n) {
+	
+	if(!in_entry_) {
+		return false;
+	}
+	
+	bool complete = true;
+	if(n > remaining_) {
+		n = size_t(remaining_);
+		complete = false;
+	}
+	
+	os_.write(data, std::streamsize(n));
+	remaining_ -= n;
+	
+	return complete && os_.good();
+}
+
+bool tar_writer::end_file() {
+	
+	if(!in_entry_) {
+		return true;
+	}
+	
+	bool complete = (remaining_ == 0);
+	
+	static const char zeros[block_size] = { 0 };
+	while(remaining_ != 0) {
+		size_t n = size_t(std::min(remaining_, boost::uint64_t(block_size)));
+		os_.write(zeros, std::streamsize(n));
+		remaining_ -= n;
+	}
+	
+	write_padding(size_);
+	
+	in_entry_ = false;
+	
+	return complete;
+}
+
+void tar_writer::add_link(const std::string & path, const std::string & target, time mtime) {
+	
+	if(in_entry_) {
+		end_file();
+	}
+	
+	write_header(archive_path(path), '1', 0, mtime, archive_path(target));
+	
+}
+
+void tar_writer::finish() {
+	
+	if(in_entry_) {
+		end_file();
+	}
+	
+	static const char zeros[block_size * 2] = { 0 };
+	os_.write(zeros, std::streamsize(sizeof(zeros)));
+	os_.flush();
+	
+}
+
+} // namespace util
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Streaming writer for tar archives.
+ */
+#ifndef INNOEXTRACT_UTIL_TAR_HPP
+#define INNOEXTRACT_UTIL_TAR_HPP
+
+#include <stddef.h>
+#include <ostream>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "util/time.hpp"
+
+namespace util {
+
+/*!
+ * Writes a POSIX ustar archive to an output stream.
+ *
+ * Paths that do not fit into the ustar name and prefix fields are stored using GNU long
+ * name records, sizes larger than 8 GiB use the GNU base-256 encoding.
+ *
+ * Entries must be written one after the other: the data for a file is passed to
+ * \ref write() between \ref begin_file() and \ref end_file().
+ */
+class tar_writer : private boost::noncopyable {
+	
+	std::ostream & os_;
+	
+	bool in_entry_;
+	boost::uint64_t remaining_; //!< Data bytes still expected for the current entry.
+	boost::uint64_t size_; //!< Declared size of the current entry.
+	
+	void write_header(const std::string & path, char type, boost::uint64_t size, time mtime,
+	                  const std::string & link = std::string());
+	void write_long_name(char type, const std::string & name);
+	void write_padding(boost::uint64_t size);
+	
+public:
+	
+	static const size_t block_size = 512;
+	
+	explicit tar_writer(std::ostream & os);
+	
+	//! Add a directory entry.
+	void add_directory(const std::string & path, time mtime);
+	
+	/*!
+	 * Start a regular file entry.
+	 *
+	 * Exactly \c size bytes must be passed to \ref write() before calling \ref end_file().
+	 */
+	void begin_file(const std::string & path, boost::uint64_t size, time mtime);
+	
+	//! Write data for the current file. Data beyond the declared size is discarded.
+	bool write(const char * data, size_t n);
+	
+	/*!
+	 * Finish the current file entry.
+	 *
+	 * If less data than declared was written, the entry is padded with zero bytes.
+	 *
+	 * \return false if the file was padded.
+	 */
+	bool end_file();
+	
+	//! Add a hard link to a file that has already been added to the archive.
+	void add_link(const std::string & path, const std::string & target, time mtime);
+	
+	//! Write the end-of-archive marker.
+	void finish();
+	
+	//! \return true if a file entry has been started but not finished.
+	bool in_entry() const { return in_entry_; }
+	
+	//! \return number of data bytes still expected for the current file.
+	boost::uint64_t remaining() const { return remaining_; }
+	
+	bool good() const { return os_.good(); }
+	
+};
+
+} // namespace util
+
+#endif // INNOEXTRACT_UTIL_TAR_HPP
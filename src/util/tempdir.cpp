@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2014-2019 Daniel Scharrer
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "util/tempdir.hpp"
+
+#include <stddef.h>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "util/log.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace util {
+
+temporary_directory::temporary_directory(const fs::path & base) {
+	try {
+		if(!base.empty() && !fs::exists(base)) {
+			fs::create_directory(base);
+			parent = base;
+		}
+		size_t tmpnum = 0;
+		std::ostringstream oss;
+		do {
+			oss.str(std::string());
+			oss << "innoextract-tmp-" << tmpnum++;
+			path = base / oss.str();
+		} while(fs::exists(path));
+		fs::create_directory(path);
+	} catch(...) {
+		path = fs::path();
+		throw std::runtime_error("Could not create temporary directory!");
+	}
+}
+
+temporary_directory::~temporary_directory() {
+	if(!path.empty()) {
+		try {
+			fs::remove_all(path);
+			if(!parent.empty()) {
+				fs::remove(parent);
+			}
+		} catch(...) {
+			log_error << "Could not remove temporary directory " << path << '!';
+		}
+	}
+}
+
+} // namespace util
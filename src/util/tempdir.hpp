@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2014-2019 Daniel Scharrer
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Self-deleting temporary directories.
+ */
+#ifndef INNOEXTRACT_UTIL_TEMPDIR_HPP
+#define INNOEXTRACT_UTIL_TEMPDIR_HPP
+
+#include <boost/noncopyable.hpp>
+#include <boost/filesystem/path.hpp>
+
+namespace util {
+
+/*!
+ * Temporary directory that is removed together with its contents on destruction.
+ */
+class temporary_directory : private boost::noncopyable {
+	
+	boost::filesystem::path parent;
+	boost::filesystem::path path;
+	
+public:
+	
+	/*!
+	 * Create a new uniquely named directory.
+	 *
+	 * \param base Directory in which to create the temporary directory. It is created if it
+	 *             does not exist yet and will then also be removed on destruction.
+	 *
+	 * \throws std::runtime_error if the directory could not be created.
+	 */
+	explicit temporary_directory(const boost::filesystem::path & base);
+	
+	~temporary_directory();
+	
+	const boost::filesystem::path & get() { return path; }
+	
+};
+
+} // namespace util
+
+#endif // INNOEXTRACT_UTIL_TEMPDIR_HPP
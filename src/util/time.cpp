@@ -40,8 +40,11 @@
 #include <fcntl.h>
 #endif
 
-#if INNOEXTRACT_HAVE_UTIMENSAT && INNOEXTRACT_HAVE_AT_FDCWD
+#if (INNOEXTRACT_HAVE_UTIMENSAT && INNOEXTRACT_HAVE_AT_FDCWD) || INNOEXTRACT_HAVE_FUTIMENS
 #include <sys/stat.h>
+#endif
+
+#if INNOEXTRACT_HAVE_UTIMENSAT && INNOEXTRACT_HAVE_AT_FDCWD
 #elif !defined(_WIN32) && INNOEXTRACT_HAVE_UTIMES
 #include <sys/time.h>
 #elif !defined(_WIN32)
@@ -334,4 +337,34 @@ bool set_file_time(const boost::filesystem::path & path, time sec, boost::uint32
 	
 }
 
+bool set_file_time(file_handle handle, const boost::filesystem::path & path,
+                   time sec, boost::uint32_t nsec) {
+	
+	#if INNOEXTRACT_HAVE_FUTIMENS
+	
+	struct timespec timens[2];
+	timens[0].tv_sec = to_time_t<time_t>(sec, path.string().c_str());
+	timens[0].tv_nsec = boost::int32_t(nsec);
+	timens[1] = timens[0];
+	
+	return (futimens(handle, timens) == 0);
+	
+	#elif defined(_WIN32)
+	
+	(void)path;
+	
+	FILETIME filetime = to_filetime(sec, nsec);
+	
+	return (SetFileTime(HANDLE(handle), &filetime, &filetime, &filetime) != 0);
+	
+	#else
+	
+	(void)handle;
+	
+	return set_file_time(path, sec, nsec);
+	
+	#endif
+	
+}
+
 } // namespace util
@@ -82,6 +82,30 @@ void set_local_timezone(std::string timezone);
  */
 bool set_file_time(const boost::filesystem::path & path, time sec, boost::uint32_t nsec);
 
+//! Native file handle type
+#if defined(_WIN32)
+typedef void * file_handle;
+#else
+typedef int file_handle;
+#endif
+
+/*!
+ * Set an open file's access, creation and modification times.
+ *
+ * Avoids looking up the file by path again where the operating system supports setting
+ * times for open files, otherwise falls back to using the given path.
+ * Any buffered data must have been written to the file before calling this function.
+ *
+ * \param handle Open handle for the file.
+ * \param path   Path to the file, used if the handle cannot be used.
+ * \param sec    File time to set (in seconds).
+ * \param nsec   Sub-second component of the file time to set (in nanoseconds).
+ *
+ * \return \c true if the file time was changed, \c false otherwise.
+ */
+bool set_file_time(file_handle handle, const boost::filesystem::path & path,
+                   time sec, boost::uint32_t nsec);
+
 } // namespace util
 
 #endif // INNOEXTRACT_UTIL_TIME_HPP
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "util/trace.hpp"
+
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+#include "util/fstream.hpp"
+
+namespace util {
+
+namespace trace {
+
+std::atomic<bool> enabled(false);
+
+namespace {
+
+std::mutex mutex;
+util::ofstream file;
+bool first_event = true;
+std::chrono::steady_clock::time_point trace_start;
+
+std::atomic<unsigned> next_thread(1);
+thread_local unsigned thread_id = 0;
+
+void escape(std::ostream & os, const char * data, size_t length) {
+	for(size_t i = 0; i < length; i++) {
+		unsigned char c = static_cast<unsigned char>(data[i]);
+		if(c == '"' || c == '\\') {
+			os << '\\' << char(c);
+		} else if(c < 0x20) {
+			os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << unsigned(c)
+			   << std::dec << std::setfill(' ');
+		} else {
+			os << char(c);
+		}
+	}
+}
+
+double microseconds(std::chrono::steady_clock::duration duration) {
+	return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+} // anonymous namespace
+
+bool open(const boost::filesystem::path & path) {
+	
+	file.open(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if(!file.is_open()) {
+		return false;
+	}
+	
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	first_event = true;
+	trace_start = std::chrono::steady_clock::now();
+	enabled = true;
+	
+	return true;
+}
+
+void close() {
+	
+	if(!enabled) {
+		return;
+	}
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	
+	enabled = false;
+	file << "\n]}\n";
+	file.close();
+}
+
+void span::start() {
+	start_ = clock::now();
+}
+
+void span::stop() {
+	
+	clock::time_point end = clock::now();
+	
+	if(thread_id == 0) {
+		thread_id = next_thread++;
+	}
+	
+	std::ostringstream event;
+	event << std::fixed << std::setprecision(3);
+	event << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_id;
+	event << ",\"cat\":\"" << category_ << "\",\"name\":\"" << name_ << '"';
+	event << ",\"ts\":" << microseconds(start_ - trace_start);
+	event << ",\"dur\":" << microseconds(end - start_);
+	if(!args_.empty()) {
+		event << ",\"args\":{" << args_ << '}';
+	}
+	event << '}';
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!enabled) {
+		return;
+	}
+	file << (first_event ? "\n" : ",\n") << event.str();
+	first_event = false;
+}
+
+span & span::arg(const char * key, const std::string & value) {
+	
+	if(active_) {
+		std::ostringstream oss;
+		oss << (args_.empty() ? "" : ",") << '"' << key << "\":\"";
+		escape(oss, value.data(), value.length());
+		oss << '"';
+		args_ += oss.str();
+	}
+	
+	return *this;
+}
+
+span & span::arg(const char * key, boost::uint64_t value) {
+	
+	if(active_) {
+		std::ostringstream oss;
+		oss << (args_.empty() ? "" : ",") << '"' << key << "\":" << value;
+		args_ += oss.str();
+	}
+	
+	return *this;
+}
+
+} // namespace trace
+
+} // namespace util
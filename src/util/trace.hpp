@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the author(s) be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*!
+ * \file
+ *
+ * Timeline of the extraction in the Chrome / Perfetto trace event format.
+ */
+#ifndef INNOEXTRACT_UTIL_TRACE_HPP
+#define INNOEXTRACT_UTIL_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/filesystem/path.hpp>
+
+namespace util {
+
+namespace trace {
+
+/*!
+ * Is a trace being written? Everything else is a no-op if not.
+ *
+ * Read by worker threads while the main thread may still close the trace.
+ */
+extern std::atomic<bool> enabled;
+
+/*!
+ * Start writing a trace to a file and enable tracing.
+ *
+ * \return false if the file could not be opened.
+ */
+bool open(const boost::filesystem::path & file);
+
+//! Finish the trace file and disable tracing.
+void close();
+
+/*!
+ * A complete event spanning the lifetime of this object.
+ *
+ * The event is written when the span is destroyed. Spans on the same thread nest in the
+ * viewer according to their times.
+ *
+ * Construction only tests \ref enabled if tracing is disabled. Use \ref active() to skip
+ * building arguments that are expensive to format.
+ */
+class span : private boost::noncopyable {
+	
+	typedef std::chrono::steady_clock clock;
+	
+	bool active_;
+	const char * category_;
+	const char * name_;
+	std::string args_; //!< JSON object members without the braces
+	clock::time_point start_;
+	
+	void start();
+	void stop();
+	
+public:
+	
+	/*!
+	 * \param category Event category, must be a string literal.
+	 * \param name     Event name, must be a string literal.
+	 */
+	span(const char * category, const char * name)
+		: active_(enabled.load(std::memory_order_relaxed)), category_(category), name_(name) {
+		if(active_) {
+			start();
+		}
+	}
+	
+	~span() {
+		if(active_) {
+			stop();
+		}
+	}
+	
+	bool active() const { return active_; }
+	
+	//! Add a string argument shown when the event is selected.
+	span & arg(const char * key, const std::string & value);
+	
+	//! Add a numeric argument shown when the event is selected.
+	span & arg(const char * key, boost::uint64_t value);
+	
+};
+
+} // namespace trace
+
+} // namespace util
+
+#endif // INNOEXTRACT_UTIL_TRACE_HPP